@@ -66,6 +66,19 @@ float CalcDistThresh(float3 point, __constant sClInConstants *consts)
 	return distThresh;
 }
 
+// limits of ray-marching step
+float LimitMarchingStep(float step, float distThresh, __constant sClInConstants *consts)
+{
+#ifdef ADVANCED_QUALITY
+	step = clamp(step, consts->params.absMinMarchingStep, consts->params.absMaxMarchingStep);
+
+	if (distThresh > consts->params.absMinMarchingStep)
+		step = clamp(step, consts->params.relMinMarchingStep * distThresh,
+			consts->params.relMaxMarchingStep * distThresh);
+#endif
+	return step;
+}
+
 // calculation of "voxel" size
 float CalcDelta(float3 point, __constant sClInConstants *consts)
 {
@@ -113,6 +126,19 @@ formulaOut CalculateDistance(__constant sClInConstants *consts, float3 point,
 		return out;
 	}
 #endif
+
+#ifdef BOUNDING_SPHERE_ENABLED
+	float boundingSphereDist =
+		length(point - consts->params.boundingSphereCenter) - consts->params.boundingSphereRadius;
+
+	if (boundingSphereDist > calcParam->detailSize)
+	{
+		out.maxiter = false;
+		out.distance = boundingSphereDist;
+		out.iters = 0;
+		return out;
+	}
+#endif
 #endif // BOOLEAN_OPERATORS
 
 	int forcedFormulaIndexForSequence = max(0, forcedFormulaIndex);
@@ -314,6 +340,13 @@ formulaOut CalculateDistance(__constant sClInConstants *consts, float3 point,
 	}
 #endif
 
+#ifdef BOUNDING_SPHERE_ENABLED
+	if (boundingSphereDist < calcParam->detailSize)
+	{
+		out.distance = max(out.distance, boundingSphereDist);
+	}
+#endif
+
 	float distFromCamera = length(point - consts->params.camera);
 	float distanceLimitMin = consts->params.viewDistanceMin - distFromCamera;
 	out.distance = max(out.distance, distanceLimitMin);
@@ -359,6 +392,19 @@ formulaOut CalculateDistance(__constant sClInConstants *consts, float3 point,
 	}
 #endif
 
+#ifdef BOUNDING_SPHERE_ENABLED
+	float boundingSphereDist =
+		length(point - consts->params.boundingSphereCenter) - consts->params.boundingSphereRadius;
+
+	if (boundingSphereDist > calcParam->detailSize)
+	{
+		out.maxiter = false;
+		out.distance = boundingSphereDist;
+		out.iters = 0;
+		return out;
+	}
+#endif
+
 	{
 		float3 pointTemp = point - consts->params.formulaPosition[0];
 		pointTemp = modRepeat(pointTemp, consts->params.formulaRepeat[0]);
@@ -498,6 +544,13 @@ formulaOut CalculateDistance(__constant sClInConstants *consts, float3 point,
 	}
 #endif
 
+#ifdef BOUNDING_SPHERE_ENABLED
+	if (boundingSphereDist < calcParam->detailSize)
+	{
+		dist = max(dist, boundingSphereDist);
+	}
+#endif
+
 	float distFromCamera = length(point - consts->params.camera);
 	float distanceLimitMin = consts->params.viewDistanceMin - distFromCamera;
 	dist = max(dist, distanceLimitMin);
@@ -210,6 +210,14 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff,
 		formulaOut outF;
 		float step = 0.0f;
 
+#ifdef OVER_RELAXATION
+		float relaxation = consts->params.overRelaxationFactor;
+		bool lastStepRelaxed = false;
+		float previousDistance = 0.0f;
+		float previousScan = scan;
+		float unrelaxedStep = 0.0f;
+#endif
+
 		// ray-marching
 		for (count = 0; count < MAX_RAYMARCHING && scan < consts->params.viewDistanceMax; count++)
 		{
@@ -220,6 +228,18 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff,
 			outF = CalculateDistance(consts, point, &calcParam, &renderData);
 			distance = outF.distance;
 
+#ifdef OVER_RELAXATION
+			// the over-relaxed step was too long if the unbounding spheres don't overlap
+			if (lastStepRelaxed && distance + previousDistance < step)
+			{
+				step = unrelaxedStep;
+				scan = previousScan + step / length(viewVector);
+				relaxation = 1.0f;
+				lastStepRelaxed = false;
+				continue;
+			}
+#endif
+
 			if (distance < distThresh * 0.95f)
 			{
 				found = true;
@@ -228,14 +248,17 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff,
 
 			step = (distance - 0.5f * distThresh) * consts->params.DEFactor;
 
-#ifdef ADVANCED_QUALITY
-			step = clamp(step, consts->params.absMinMarchingStep, consts->params.absMaxMarchingStep);
-
-			if (distThresh > consts->params.absMinMarchingStep)
-				step = clamp(step, consts->params.relMinMarchingStep * distThresh,
-					consts->params.relMaxMarchingStep * distThresh);
+#ifdef OVER_RELAXATION
+			// normal step is kept in case the over-relaxed one has to be repeated
+			unrelaxedStep = LimitMarchingStep(step, distThresh, consts);
+			step *= relaxation;
+			lastStepRelaxed = relaxation > 1.0f;
+			previousDistance = distance;
+			previousScan = scan;
 #endif
 
+			step = LimitMarchingStep(step, distThresh, consts);
+
 			scan += step / length(viewVector);
 		}
 
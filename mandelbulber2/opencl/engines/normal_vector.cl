@@ -45,6 +45,22 @@ float3 NormalVector(__constant sClInConstants *consts, sRenderData *renderData,
 	calcParam->detailSize = distThresh;
 	calcParam->normalCalculationMode = true;
 
+#ifdef NORMAL_VECTOR_TETRAHEDRAL
+	// gradient from 4 samples placed in vertices of tetrahedron
+	float3 vertices[4];
+	vertices[0] = (float3){1.0f, -1.0f, -1.0f};
+	vertices[1] = (float3){-1.0f, -1.0f, 1.0f};
+	vertices[2] = (float3){-1.0f, 1.0f, -1.0f};
+	vertices[3] = (float3){1.0f, 1.0f, 1.0f};
+
+	float3 normal = 0.0f;
+	for (int i = 0; i < 4; i++)
+	{
+		normal +=
+			vertices[i]
+			* CalculateDistance(consts, point + vertices[i] * delta, calcParam, renderData).distance;
+	}
+#else
 	float3 deltas[6];
 	deltas[0] = (float3){delta, 0.0f, 0.0f};
 	deltas[1] = (float3){-delta, 0.0f, 0.0f};
@@ -60,6 +76,7 @@ float3 NormalVector(__constant sClInConstants *consts, sRenderData *renderData,
 	}
 
 	float3 normal = (float3){s[0] - s[1], s[2] - s[3], s[4] - s[5]};
+#endif
 	normal = normalize(normal);
 	calcParam->normalCalculationMode = false;
 
@@ -88,6 +105,51 @@ float3 NormalVector(__constant sClInConstants *consts, sRenderData *renderData,
 	out.objectId = 0;
 
 	float3 normal = 0.0f;
+
+#ifdef SLOW_SHADING_ADAPTIVE
+	// lattice 11 x 11 x 11 is refined with strides 10, 5, 2 and 1 and only new points are calculated
+	// (lattice with stride 2 doesn't contain the one with stride 5, so all previous levels are
+	// checked). Calculation is finished when normal vector doesn't change
+	int strides[4] = {10, 5, 2, 1};
+	float3 lastNormal = 0.0f;
+
+	for (int level = 0; level < 4; level++)
+	{
+		int stride = strides[level];
+
+		for (int ix = 0; ix <= 10; ix += stride)
+		{
+			for (int iy = 0; iy <= 10; iy += stride)
+			{
+				for (int iz = 0; iz <= 10; iz += stride)
+				{
+					bool calculated = false;
+					for (int i = 0; i < level; i++)
+					{
+						if (ix % strides[i] == 0 && iy % strides[i] == 0 && iz % strides[i] == 0)
+							calculated = true;
+					}
+					if (calculated) continue;
+
+					point2 = (float3){ix * 0.2f - 1.0f, iy * 0.2f - 1.0f, iz * 0.2f - 1.0f};
+					point3 = point + point2 * delta;
+
+					out = Fractal(consts, point3, calcParam, calcModeNormal, NULL, -1);
+					float pseudoDistance = 1.0f + consts->params.N - out.iters;
+					normal += point2 * pseudoDistance;
+				}
+			}
+		}
+
+		float len = length(normal);
+		if (len > 0.0f)
+		{
+			float3 actualNormal = normal / len;
+			if (level > 0 && dot(actualNormal, lastNormal) > 0.999f) break;
+			lastNormal = actualNormal;
+		}
+	}
+#else
 	for (point2.x = -1.0f; point2.x <= 1.0f; point2.x += 0.2f) //+0.2
 	{
 		for (point2.y = -1.0f; point2.y <= 1.0f; point2.y += 0.2f)
@@ -102,6 +164,7 @@ float3 NormalVector(__constant sClInConstants *consts, sRenderData *renderData,
 			}
 		}
 	}
+#endif
 	normal = normalize(normal);
 
 	if (invertMode) normal *= -1.0f;
@@ -151,6 +151,16 @@ void RayMarching(sRayMarchingIn in, sRayMarchingOut *out, __constant sClInConsta
 	float searchAccuracy = 0.001f * consts->params.detailLevel;
 	float searchLimit = 1.0f - searchAccuracy;
 
+#ifdef OVER_RELAXATION
+	// over-relaxed sphere tracing: steps are longer than the distance as long as the unbounding
+	// spheres of consecutive points overlap
+	float relaxation = in.invertMode ? 1.0f : consts->params.overRelaxationFactor;
+	bool lastStepRelaxed = false;
+	float previousDistance = 0.0f;
+	float previousScan = scan;
+	float unrelaxedStep = 0.0f;
+#endif
+
 	// ray-marching
 	for (count = 0; count < MAX_RAYMARCHING && scan < in.maxScan; count++)
 	{
@@ -170,6 +180,19 @@ void RayMarching(sRayMarchingIn in, sRayMarchingOut *out, __constant sClInConsta
 		}
 #endif
 
+#ifdef OVER_RELAXATION
+		// the over-relaxed step was too long if the unbounding spheres don't overlap. The step is
+		// repeated without over-relaxation
+		if (lastStepRelaxed && distance + previousDistance < step)
+		{
+			step = unrelaxedStep;
+			scan = previousScan + step / length(in.direction);
+			relaxation = 1.0f;
+			lastStepRelaxed = false;
+			continue;
+		}
+#endif
+
 		if (distance < distThresh)
 		{
 			found = true;
@@ -184,14 +207,17 @@ void RayMarching(sRayMarchingIn in, sRayMarchingOut *out, __constant sClInConsta
 
 		step *= (1.0f - Random(1000, randomSeed) / 10000.0f);
 
-#ifdef ADVANCED_QUALITY
-		step = clamp(step, consts->params.absMinMarchingStep, consts->params.absMaxMarchingStep);
-
-		if (distThresh > consts->params.absMinMarchingStep)
-			step = clamp(step, consts->params.relMinMarchingStep * distThresh,
-				consts->params.relMaxMarchingStep * distThresh);
+#ifdef OVER_RELAXATION
+		// normal step is kept in case the over-relaxed one has to be repeated
+		unrelaxedStep = LimitMarchingStep(step, distThresh, consts);
+		step *= relaxation;
+		lastStepRelaxed = relaxation > 1.0f;
+		previousDistance = distance;
+		previousScan = scan;
 #endif
 
+		step = LimitMarchingStep(step, distThresh, consts);
+
 		scan += step / length(in.direction);
 	}
 
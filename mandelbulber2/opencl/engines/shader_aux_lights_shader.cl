@@ -43,19 +43,77 @@ float3 AuxLightsShader(__constant sClInConstants *consts, sRenderData *renderDat
 	if (numberOfLights < 4) numberOfLights = 4;
 	float3 shadeAuxSum = 0.0f;
 	float3 specularAuxSum = 0.0f;
+
+#ifdef AUX_LIGHTS_MC_SAMPLING
+	// every sample selects one light with probability proportional to its unshadowed intensity
+	// at the point (weighted reservoir sampling, so the lights are visited only once)
+	int samples = clamp(consts->params.auxLightMonteCarloSamples, 1, 16);
+	int selectedLights[16];
+	float selectedWeights[16];
+	for (int s = 0; s < samples; s++)
+	{
+		selectedLights[s] = -1;
+		selectedWeights[s] = 0.0f;
+	}
+	float totalWeight = 0.0f;
+#endif
+
 	for (int i = 0; i < numberOfLights; i++)
 	{
 		__global sLightCl *light = &renderData->lights[i];
 
 		if (i < consts->params.auxLightNumber || light->enabled)
 		{
+#if defined(AUX_LIGHTS_INFLUENCE_CULLING) || defined(AUX_LIGHTS_MC_SAMPLING)
+			float3 d = light->position - input->point;
+			float distance2 = max(dot(d, d), 1e-20f);
+#endif
+
+#ifdef AUX_LIGHTS_INFLUENCE_CULLING
+			// the same intensity as calculated in LightShading() (number of lights is at least 4)
+			float intensity = 100.0f * light->intensity / distance2 / numberOfLights / 6.0f;
+			if (intensity < consts->params.auxLightInfluenceThreshold) continue;
+#endif
+
+#ifdef AUX_LIGHTS_MC_SAMPLING
+			float weight =
+				light->intensity * max(max(light->colour.s0, light->colour.s1), light->colour.s2)
+				/ distance2;
+			if (weight <= 0.0f) continue;
+			totalWeight += weight;
+			for (int s = 0; s < samples; s++)
+			{
+				if (Random(65535, &input->randomSeed) / 65536.0f * totalWeight < weight)
+				{
+					selectedLights[s] = i;
+					selectedWeights[s] = weight;
+				}
+			}
+#else
 			float3 specularAuxOutTemp;
 			float3 shadeAux = LightShading(
 				consts, renderData, input, calcParam, surfaceColor, light, gradients, &specularAuxOutTemp);
 			shadeAuxSum += shadeAux;
 			specularAuxSum += specularAuxOutTemp;
+#endif
+		}
+	}
+
+#ifdef AUX_LIGHTS_MC_SAMPLING
+	for (int s = 0; s < samples; s++)
+	{
+		if (selectedLights[s] >= 0)
+		{
+			__global sLightCl *light = &renderData->lights[selectedLights[s]];
+			float weight = totalWeight / (selectedWeights[s] * samples);
+			float3 specularAuxOutTemp;
+			float3 shadeAux = LightShading(
+				consts, renderData, input, calcParam, surfaceColor, light, gradients, &specularAuxOutTemp);
+			shadeAuxSum += shadeAux * weight;
+			specularAuxSum += specularAuxOutTemp * weight;
 		}
 	}
+#endif
 
 	*specularOut = specularAuxSum;
 	return shadeAuxSum;
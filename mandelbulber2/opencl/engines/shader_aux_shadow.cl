@@ -103,6 +103,11 @@ float AuxShadow(constant sClInConstants *consts, sRenderData *renderData, sShade
 		limitsAcheved = any(isless(point2, consts->params.limitMin))
 										|| any(isgreater(point2, consts->params.limitMax));
 #endif // LIMITS_ENABLED
+#ifdef BOUNDING_SPHERE_ENABLED
+		limitsAcheved = limitsAcheved
+										|| length(point2 - consts->params.boundingSphereCenter)
+												 > consts->params.boundingSphereRadius;
+#endif // BOUNDING_SPHERE_ENABLED
 
 		if (bSoft && !limitsAcheved)
 		{
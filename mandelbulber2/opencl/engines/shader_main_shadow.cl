@@ -107,6 +107,11 @@ float3 MainShadow(__constant sClInConstants *consts, sRenderData *renderData,
 		limitsAcheved = any(isless(point2, consts->params.limitMin))
 										|| any(isgreater(point2, consts->params.limitMax));
 #endif // LIMITS_ENABLED
+#ifdef BOUNDING_SPHERE_ENABLED
+		limitsAcheved = limitsAcheved
+										|| length(point2 - consts->params.boundingSphereCenter)
+												 > consts->params.boundingSphereRadius;
+#endif // BOUNDING_SPHERE_ENABLED
 
 		if (bSoft && !limitsAcheved)
 		{
@@ -82,6 +82,7 @@ typedef struct
 	cl_int auxLightNumber;
 	cl_int auxLightRandomNumber;
 	cl_int auxLightRandomSeed;
+	cl_int auxLightMonteCarloSamples;
 	cl_int cloudsIterations;
 	cl_int cloudsRandomSeed;
 	cl_int frameNo;
@@ -110,8 +111,10 @@ typedef struct
 	cl_int auxLightPreEnabled[4];
 	cl_int auxLightRandomEnabled;
 	cl_int auxLightRandomInOneColor;
+	cl_int auxLightMonteCarloSampling; // one or few lights selected randomly for each sample
 	cl_int background3ColorsEnable;
 	cl_int booleanOperatorsEnabled;
+	cl_int boundingSphereEnabled; // everything outside the sphere is cut away
 	cl_int cloudsCastShadows;
 	cl_int cloudsDistanceMode;
 	cl_int cloudsEnable;
@@ -174,6 +177,7 @@ typedef struct
 	cl_float absMinMarchingStep;
 	cl_float ambientOcclusion;
 	cl_float ambientOcclusionFastTune;
+	cl_float auxLightInfluenceThreshold; // lights weaker than this are skipped
 	cl_float auxLightPreIntensity[4];
 	cl_float auxLightVisibility;
 	cl_float auxLightVisibilitySize;
@@ -185,6 +189,7 @@ typedef struct
 	cl_float backgroundVScale;
 	cl_float backgroundTextureOffsetX;
 	cl_float backgroundTextureOffsetY;
+	cl_float boundingSphereRadius;
 	cl_float cameraDistanceToTarget; // zoom
 	cl_float cloudsAmbientLight;
 	cl_float cloudsDEApproaching;
@@ -233,6 +238,7 @@ typedef struct
 	cl_float mainLightVisibility;
 	cl_float mainLightVisibilitySize;
 	cl_float monteCarloGIRadianceLimit;
+	cl_float overRelaxationFactor; // step multiplier of over-relaxed sphere tracing
 	cl_float relMaxMarchingStep;
 	cl_float relMinMarchingStep;
 	cl_float resolution; // resolution of image in fractal coordinates
@@ -257,6 +263,7 @@ typedef struct
 	cl_float3 auxLightPre[4];
 	cl_float3 auxLightRandomCenter;
 	cl_float3 backgroundRotation;
+	cl_float3 boundingSphereCenter;
 	cl_float3 cloudsCenter;
 	cl_float3 cloudsRotation;
 	cl_float3 formulaPosition[NUMBER_OF_FRACTALS];
@@ -287,6 +294,7 @@ inline sParamRenderCl clCopySParamRenderCl(const sParamRender &source)
 	target.auxLightNumber = source.auxLightNumber;
 	target.auxLightRandomNumber = source.auxLightRandomNumber;
 	target.auxLightRandomSeed = source.auxLightRandomSeed;
+	target.auxLightMonteCarloSamples = source.auxLightMonteCarloSamples;
 	target.cloudsIterations = source.cloudsIterations;
 	target.cloudsRandomSeed = source.cloudsRandomSeed;
 	target.frameNo = source.frameNo;
@@ -322,8 +330,10 @@ inline sParamRenderCl clCopySParamRenderCl(const sParamRender &source)
 	}
 	target.auxLightRandomEnabled = source.auxLightRandomEnabled;
 	target.auxLightRandomInOneColor = source.auxLightRandomInOneColor;
+	target.auxLightMonteCarloSampling = source.auxLightMonteCarloSampling;
 	target.background3ColorsEnable = source.background3ColorsEnable;
 	target.booleanOperatorsEnabled = source.booleanOperatorsEnabled;
+	target.boundingSphereEnabled = source.boundingSphereEnabled;
 	target.cloudsCastShadows = source.cloudsCastShadows;
 	target.cloudsDistanceMode = source.cloudsDistanceMode;
 	target.cloudsEnable = source.cloudsEnable;
@@ -390,6 +400,7 @@ inline sParamRenderCl clCopySParamRenderCl(const sParamRender &source)
 	target.absMinMarchingStep = source.absMinMarchingStep;
 	target.ambientOcclusion = source.ambientOcclusion;
 	target.ambientOcclusionFastTune = source.ambientOcclusionFastTune;
+	target.auxLightInfluenceThreshold = source.auxLightInfluenceThreshold;
 	for (int i = 0; i < 4; i++)
 	{
 		target.auxLightPreIntensity[i] = source.auxLightPreIntensity[i];
@@ -404,6 +415,7 @@ inline sParamRenderCl clCopySParamRenderCl(const sParamRender &source)
 	target.backgroundVScale = source.backgroundVScale;
 	target.backgroundTextureOffsetX = source.backgroundTextureOffsetX;
 	target.backgroundTextureOffsetY = source.backgroundTextureOffsetY;
+	target.boundingSphereRadius = source.boundingSphereRadius;
 	target.cameraDistanceToTarget = source.cameraDistanceToTarget;
 	target.cloudsAmbientLight = source.cloudsAmbientLight;
 	target.cloudsDEApproaching = source.cloudsDEApproaching;
@@ -455,6 +467,7 @@ inline sParamRenderCl clCopySParamRenderCl(const sParamRender &source)
 	target.mainLightVisibility = source.mainLightVisibility;
 	target.mainLightVisibilitySize = source.mainLightVisibilitySize;
 	target.monteCarloGIRadianceLimit = source.monteCarloGIRadianceLimit;
+	target.overRelaxationFactor = source.overRelaxationFactor;
 	target.relMaxMarchingStep = source.relMaxMarchingStep;
 	target.relMinMarchingStep = source.relMinMarchingStep;
 	target.resolution = source.resolution;
@@ -483,6 +496,7 @@ inline sParamRenderCl clCopySParamRenderCl(const sParamRender &source)
 	}
 	target.auxLightRandomCenter = toClFloat3(source.auxLightRandomCenter);
 	target.backgroundRotation = toClFloat3(source.backgroundRotation);
+	target.boundingSphereCenter = toClFloat3(source.boundingSphereCenter);
 	target.cloudsCenter = toClFloat3(source.cloudsCenter);
 	target.cloudsRotation = toClFloat3(source.cloudsRotation);
 	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
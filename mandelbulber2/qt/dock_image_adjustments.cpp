@@ -428,7 +428,8 @@ void cDockImageAdjustments::SetAntialiasingOpenCL(bool enable) const
 {
 	ui->label_antialiasingNumberOfSamples->setEnabled(!enable);
 	ui->label_antialiasing_depth->setEnabled(enable);
-	ui->checkBox_antialiasing_adaptive->setEnabled(enable);
+	ui->label_antialiasing_adaptive_threshold->setEnabled(!enable);
+	ui->logedit_antialiasing_adaptive_threshold->setEnabled(!enable);
 	ui->comboBox_antialiasing_ocl_depth->setEnabled(enable);
 	ui->spinboxInt_antialiasing_size->setEnabled(!enable);
 }
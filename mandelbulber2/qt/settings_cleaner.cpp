@@ -115,12 +115,16 @@ void cSettingsCleaner::runCleaner()
 			if (parameterName == "DOF_min_samples") continue;
 			if (parameterName == "DOF_max_noise") continue;
 			if (parameterName == "DOF_monte_carlo") continue;
+			if (parameterName == "DOF_MC_tile_convergence") continue;
 			if (parameterName == "image_proportion") continue;
 			if (parameterName == "MC_soft_shadows_enable") continue;
+			if (parameterName == "MC_aux_lights_sampling") continue;
+			if (parameterName == "MC_aux_lights_samples") continue;
 			if (parameterName == "antialiasing_enabled") continue;
 			if (parameterName == "antialiasing_size") continue;
 			if (parameterName == "antialiasing_ocl_depth") continue;
 			if (parameterName == "antialiasing_adaptive") continue;
+			if (parameterName == "antialiasing_adaptive_threshold") continue;
 			if (parameterName == "description") continue;
 			if (parameterName.contains("animSound")) continue;
 			if (parameterName == "camera_distance_to_target") continue;
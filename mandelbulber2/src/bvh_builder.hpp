@@ -0,0 +1,113 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * BuildBvh() - builder of bounding volume hierarchy of axis aligned boxes
+ *
+ * Used for primitives (cPrimitives) and for light influence spheres (cLights). Node type has to
+ * contain boxMin, boxMax and firstChild fields. Leafs are split at the median of box centers
+ * along the longest axis, so the tree is balanced. Children of a node are stored at firstChild
+ * and firstChild + 1.
+ */
+
+#ifndef MANDELBULBER2_SRC_BVH_BUILDER_HPP_
+#define MANDELBULBER2_SRC_BVH_BUILDER_HPP_
+
+#include <algorithm>
+
+#include <QVector>
+
+#include "algebra.hpp"
+
+template <typename Node, typename InnerNodeFunction>
+void BuildBvhNode(QVector<Node> *nodes, QVector<Node> *leafs, int first, int last, int nodeIndex,
+	InnerNodeFunction setInnerNode)
+{
+	if (first == last)
+	{
+		(*nodes)[nodeIndex] = (*leafs)[first];
+		return;
+	}
+
+	CVector3 centerMin(1e20, 1e20, 1e20);
+	CVector3 centerMax(-1e20, -1e20, -1e20);
+	for (int i = first; i <= last; i++)
+	{
+		CVector3 center = ((*leafs)[i].boxMin + (*leafs)[i].boxMax) * 0.5;
+		centerMin = CVector3(std::min(centerMin.x, center.x), std::min(centerMin.y, center.y),
+			std::min(centerMin.z, center.z));
+		centerMax = CVector3(std::max(centerMax.x, center.x), std::max(centerMax.y, center.y),
+			std::max(centerMax.z, center.z));
+	}
+	CVector3 extent = centerMax - centerMin;
+	int axis = 0;
+	if (extent.y > extent.x) axis = 1;
+	if (extent.z > std::max(extent.x, extent.y)) axis = 2;
+
+	std::sort(leafs->begin() + first, leafs->begin() + last + 1,
+		[axis](const Node &a, const Node &b) {
+			CVector3 centerA = a.boxMin + a.boxMax;
+			CVector3 centerB = b.boxMin + b.boxMax;
+			if (axis == 0) return centerA.x < centerB.x;
+			if (axis == 1) return centerA.y < centerB.y;
+			return centerA.z < centerB.z;
+		});
+
+	int middle = (first + last) / 2;
+	int firstChild = nodes->size();
+	nodes->append(Node());
+	nodes->append(Node());
+	BuildBvhNode(nodes, leafs, first, middle, firstChild, setInnerNode);
+	BuildBvhNode(nodes, leafs, middle + 1, last, firstChild + 1, setInnerNode);
+
+	const Node &child1 = nodes->at(firstChild);
+	const Node &child2 = nodes->at(firstChild + 1);
+	Node node;
+	node.boxMin = CVector3(std::min(child1.boxMin.x, child2.boxMin.x),
+		std::min(child1.boxMin.y, child2.boxMin.y), std::min(child1.boxMin.z, child2.boxMin.z));
+	node.boxMax = CVector3(std::max(child1.boxMax.x, child2.boxMax.x),
+		std::max(child1.boxMax.y, child2.boxMax.y), std::max(child1.boxMax.z, child2.boxMax.z));
+	node.firstChild = firstChild;
+	// setInnerNode(Node *node, const Node &child1, const Node &child2) fills node specific data
+	setInnerNode(&node, child1, child2);
+	(*nodes)[nodeIndex] = node;
+}
+
+// appends tree built from leafs to nodes and returns index of the root node. Order of leafs is
+// changed. Leafs must not be empty
+template <typename Node, typename InnerNodeFunction>
+int BuildBvh(QVector<Node> *nodes, QVector<Node> *leafs, InnerNodeFunction setInnerNode)
+{
+	int root = nodes->size();
+	nodes->append(Node());
+	BuildBvhNode(nodes, leafs, 0, leafs->size() - 1, root, setInnerNode);
+	return root;
+}
+
+#endif /* MANDELBULBER2_SRC_BVH_BUILDER_HPP_ */
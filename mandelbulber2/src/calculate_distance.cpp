@@ -53,6 +53,18 @@
 
 using namespace std;
 
+// lower bound of distance to the formula calculated from its bounding sphere.
+// Returns negative value when the bounding sphere is not used
+static double FormulaBoundingDistance(
+	const sParamRender &params, const CVector3 &point, int formulaIndex)
+{
+	if (!params.formulaBoundingSphereEnabled[formulaIndex]) return -1.0;
+	if (params.formulaBoundingSphereRadius[formulaIndex] <= 0.0) return -1.0;
+	return (point - params.formulaPosition[formulaIndex]).Length()
+				 - params.formulaBoundingSphereRadius[formulaIndex]
+				 - params.formulaDisplacementHeight[formulaIndex];
+}
+
 double CalculateDistance(const sParamRender &params, const cNineFractals &fractals,
 	const sDistanceIn &in, sDistanceOut *out, sRenderData *data)
 {
@@ -75,35 +87,84 @@ double CalculateDistance(const sParamRender &params, const cNineFractals &fracta
 		{
 			out->maxiter = false;
 			out->distance = limitBoxDist;
+			out->objectDistance = limitBoxDist;
 			out->objectId = 0;
 			out->iters = 0;
 			return limitBoxDist;
 		}
 	}
 
+	double boundingSphereDist = 0.0;
+	if (params.boundingSphereEnabled)
+	{
+		boundingSphereDist =
+			(in.point - params.boundingSphereCenter).Length() - params.boundingSphereRadius;
+
+		if (boundingSphereDist > in.detailSize)
+		{
+			out->maxiter = false;
+			out->distance = boundingSphereDist;
+			out->objectDistance = boundingSphereDist;
+			out->objectId = 0;
+			out->iters = 0;
+			return boundingSphereDist;
+		}
+	}
+
 	if (params.booleanOperatorsEnabled)
 	{
 		sDistanceIn inTemp = in;
 		CVector3 point = inTemp.point;
 
-		point = (point - params.formulaPosition[0]).mod(params.formulaRepeat[0]);
-		point = params.mRotFormulaRotation[0].RotateVector(point);
-		point *= params.formulaScale[0];
-		inTemp.point = point;
+		// bounding distance is a lower bound of the true distance to the formula, so when it's
+		// above detail size, the point cannot be on the surface of the formula
+		double boundingDist = FormulaBoundingDistance(params, in.point, 0);
+		if (boundingDist > in.detailSize)
+		{
+			distance = boundingDist;
+			out->maxiter = false;
+			out->iters = 0;
+		}
+		else
+		{
+			point = (point - params.formulaPosition[0]).mod(params.formulaRepeat[0]);
+			point = params.mRotFormulaRotation[0].RotateVector(point);
+			point *= params.formulaScale[0];
+			inTemp.point = point;
 
-		distance = CalculateDistanceSimple(params, fractals, inTemp, out, 0) / params.formulaScale[0];
+			distance =
+				CalculateDistanceSimple(params, fractals, inTemp, out, 0) / params.formulaScale[0];
 
-		CVector3 pointFractalized = inTemp.point;
-		double reduceDisplacement = 1.0;
-		pointFractalized =
-			FractalizeTexture(inTemp.point, data, params, fractals, 0, &reduceDisplacement);
+			CVector3 pointFractalized = inTemp.point;
+			double reduceDisplacement = 1.0;
+			pointFractalized =
+				FractalizeTexture(inTemp.point, data, params, fractals, 0, &reduceDisplacement);
 
-		distance = DisplacementMap(distance, pointFractalized, 0, data, reduceDisplacement);
+			distance = DisplacementMap(distance, pointFractalized, 0, data, reduceDisplacement);
+		}
 
 		for (int i = 0; i < NUMBER_OF_FRACTALS - 1; i++)
 		{
 			if (fractals.GetFractal(i + 1)->formula != fractal::none)
 			{
+				const params::enumBooleanOperator boolOperator = params.booleanOperator[i];
+
+				// skip formulas which cannot change the result
+				boundingDist = FormulaBoundingDistance(params, in.point, i + 1);
+				const double subtractLimit = in.detailSize * 1.5 * 1.5;
+				if (boolOperator == params::booleanOperatorOR && boundingDist > 0.0
+						&& boundingDist >= distance)
+					continue;
+				if (boolOperator == params::booleanOperatorSUB
+						&& (distance >= in.detailSize || boundingDist >= subtractLimit))
+					continue;
+				if (boolOperator == params::booleanOperatorAND && boundingDist > in.detailSize)
+				{
+					if (boundingDist > distance) out->objectId = 1 + i;
+					distance = max(boundingDist, distance);
+					continue;
+				}
+
 				sDistanceOut outTemp = *out;
 
 				point = in.point - params.formulaPosition[i + 1];
@@ -122,8 +183,6 @@ double CalculateDistance(const sParamRender &params, const cNineFractals &fracta
 
 				distTemp = DisplacementMap(distTemp, pointFractalized, i + 1, data);
 
-				const params::enumBooleanOperator boolOperator = params.booleanOperator[i];
-
 				switch (boolOperator)
 				{
 					case params::booleanOperatorOR:
@@ -207,11 +266,22 @@ double CalculateDistance(const sParamRender &params, const cNineFractals &fracta
 		}
 	}
 
+	if (params.boundingSphereEnabled)
+	{
+		if (boundingSphereDist < in.detailSize)
+		{
+			distance = max(distance, boundingSphereDist);
+		}
+	}
+
 	if (CheckNAN(distance)) // check if not a number
 	{
 		distance = 0.0;
 	}
 
+	// distance to objects only, without dependency on camera position
+	out->objectDistance = distance;
+
 	const double distFromCamera = (in.point - params.camera).Length();
 	const double distanceLimitMin = params.viewDistanceMin - distFromCamera;
 	if (distanceLimitMin > in.detailSize)
@@ -480,3 +550,67 @@ double CalculateDistanceMinPlane(const sParamRender &params, const cNineFractals
 	}
 	return CVector3(point - planePoint).Dot(direction);
 }
+
+void EstimateFormulaBoundingSpheres(sParamRender *params, const cNineFractals &fractals)
+{
+	// rays are marched from a big sphere towards the center of the formula. The outermost hit
+	// enlarged by the spacing between rays gives the radius of the bounding sphere
+	const int numberOfDirections = 256;
+	const double startRadius = 100.0;
+	const double detail = startRadius * 1e-6;
+	const int maxSteps = 1000;
+
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		if (!params->formulaBoundingSphereEnabled[i] || params->formulaBoundingSphereRadius[i] > 0.0)
+			continue;
+
+		if (i > 0 && fractals.GetFractal(i)->formula == fractal::none) continue;
+
+		double maxRadius = 0.0;
+		bool unbounded = false;
+		for (int d = 0; d < numberOfDirections && !unbounded; d++)
+		{
+			// directions evenly distributed on the sphere (Fibonacci lattice)
+			const double z = 1.0 - (d + 0.5) * 2.0 / numberOfDirections;
+			const double r = sqrt(1.0 - z * z);
+			const double phi = d * M_PI * (3.0 - sqrt(5.0));
+			const CVector3 direction(cos(phi) * r, sin(phi) * r, z);
+
+			double radius = startRadius;
+			int step = 0;
+			for (; step < maxSteps && radius > 0.0; step++)
+			{
+				const sDistanceIn in(direction * radius, detail, false);
+				sDistanceOut out;
+				out.totalIters = 0;
+				const double dist = CalculateDistanceSimple(*params, fractals, in, &out, i);
+				if (dist < detail)
+				{
+					if (step == 0) unbounded = true;
+					maxRadius = max(maxRadius, radius);
+					break;
+				}
+				radius -= dist;
+			}
+
+			// the ray reached neither the surface nor the center, so the formula can't be bounded
+			if (step == maxSteps) unbounded = true;
+		}
+
+		if (unbounded || maxRadius == 0.0)
+		{
+			params->formulaBoundingSphereEnabled[i] = false;
+			WriteLog(
+				"EstimateFormulaBoundingSpheres(): formula " + QString::number(i + 1) + " is unbounded", 2);
+		}
+		else
+		{
+			const double margin = maxRadius * sqrt(4.0 * M_PI / numberOfDirections);
+			params->formulaBoundingSphereRadius[i] = (maxRadius + margin) / params->formulaScale[i];
+			WriteLog("EstimateFormulaBoundingSpheres(): formula " + QString::number(i + 1)
+								 + " radius = " + QString::number(params->formulaBoundingSphereRadius[i]),
+				2);
+		}
+	}
+}
@@ -60,6 +60,7 @@ struct sDistanceIn
 struct sDistanceOut
 {
 	double distance;
+	double objectDistance; // distance before clamping to minimum view distance
 	double colorIndex;
 	int iters;
 	int totalIters;
@@ -73,5 +74,6 @@ double CalculateDistanceSimple(const sParamRender &params, const cNineFractals &
 	const sDistanceIn &in, sDistanceOut *out, int forcedFormulaIndex);
 double CalculateDistanceMinPlane(const sParamRender &params, const cNineFractals &fractals,
 	const CVector3 point, const CVector3 direction, const CVector3 orthDirection, bool *stopRequest);
+void EstimateFormulaBoundingSpheres(sParamRender *params, const cNineFractals &fractals);
 
 #endif /* MANDELBULBER2_SRC_CALCULATE_DISTANCE_HPP_ */
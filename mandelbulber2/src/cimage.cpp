@@ -87,20 +87,33 @@ bool cImage::AllocMem()
 		{
 			try
 			{
-				imageFloat.resize(width * height);
-				postImageFloat.resize(width * height);
-				image16.resize(width * height);
-				image8.resize(width * height);
-				zBuffer.resize(width * height);
-				alphaBuffer8.resize(width * height);
-				alphaBuffer16.resize(width * height);
-				opacityBuffer.resize(width * height);
-				colourBuffer.resize(width * height);
-				normalFloat.resize(width * height);
-				normalFloatWorld.resize(width * height);
-				specularFloat.resize(width * height);
-				diffuseFloat.resize(width * height);
-				worldFloat.resize(width * height);
+				const quint64 size = width * height;
+				const bool compact = opt.compactStorage;
+				imageFloat.Alloc(size, compact);
+				postImageFloat.Alloc(size, compact);
+
+				// in compact mode 16-bit and 8-bit buffers are allocated when they are needed
+				if (!compact)
+				{
+					image16.resize(size);
+					image8.resize(size);
+					alphaBuffer8.resize(size);
+				}
+
+				zBuffer.resize(size);
+				alphaBuffer16.resize(size);
+				opacityBuffer.resize(size);
+				colourBuffer.resize(size);
+
+				// optional channels are allocated only when enabled
+				if (opt.optionalNormal) normalFloat.Alloc(size, compact && opt.halfNormal);
+				if (opt.optionalNormalWorld)
+					normalFloatWorld.Alloc(size, compact && opt.halfNormalWorld);
+				if (opt.optionalSpecular) specularFloat.Alloc(size, compact && opt.halfSpecular);
+				if (opt.optionalDiffuse) diffuseFloat.Alloc(size, compact && opt.halfDiffuse);
+				if (opt.optionalWorld) worldFloat.Alloc(size, compact && opt.halfWorld);
+				if (opt.optionalSampleCount)
+					sampleCountFloat.Alloc(size, compact && opt.halfSampleCount);
 				ClearImage();
 			}
 			catch (std::bad_alloc &ba)
@@ -154,8 +167,8 @@ bool cImage::ChangeSize(quint64 w, quint64 h, sImageOptional optional)
 
 void cImage::ClearImage()
 {
-	std::fill(imageFloat.begin(), imageFloat.end(), sRGBFloat());
-	std::fill(postImageFloat.begin(), postImageFloat.end(), sRGBFloat());
+	imageFloat.Clear();
+	postImageFloat.Clear();
 	std::fill(image16.begin(), image16.end(), sRGB16());
 	std::fill(image8.begin(), image8.end(), sRGB8());
 	std::fill(alphaBuffer8.begin(), alphaBuffer8.end(), 0);
@@ -163,12 +176,12 @@ void cImage::ClearImage()
 	std::fill(opacityBuffer.begin(), opacityBuffer.end(), 0);
 	std::fill(colourBuffer.begin(), colourBuffer.end(), sRGB8());
 
-	if (opt.optionalNormal) std::fill(normalFloat.begin(), normalFloat.end(), sRGBFloat());
-	if (opt.optionalNormalWorld)
-		std::fill(normalFloatWorld.begin(), normalFloatWorld.end(), sRGBFloat());
-	if (opt.optionalSpecular) std::fill(specularFloat.begin(), specularFloat.end(), sRGBFloat());
-	if (opt.optionalDiffuse) std::fill(diffuseFloat.begin(), diffuseFloat.end(), sRGBFloat());
-	if (opt.optionalWorld) std::fill(worldFloat.begin(), worldFloat.end(), sRGBFloat());
+	normalFloat.Clear();
+	normalFloatWorld.Clear();
+	specularFloat.Clear();
+	diffuseFloat.Clear();
+	worldFloat.Clear();
+	sampleCountFloat.Clear();
 
 	for (quint64 i = 0; i < quint64(width) * quint64(height); ++i)
 		zBuffer[i] = float(1e20);
@@ -186,21 +199,22 @@ void cImage::FreeImage()
 {
 	isAllocated = false;
 	// qDebug() << "void cImage::FreeImage(void)";
-	imageFloat.clear();
+	imageFloat.Free();
 	image16.clear();
 	image8.clear();
-	postImageFloat.clear();
+	postImageFloat.Free();
 	alphaBuffer8.clear();
 	alphaBuffer16.clear();
 	opacityBuffer.clear();
 	colourBuffer.clear();
 	zBuffer.clear();
 
-	normalFloat.clear();
-	normalFloatWorld.clear();
-	specularFloat.clear();
-	diffuseFloat.clear();
-	worldFloat.clear();
+	normalFloat.Free();
+	normalFloatWorld.Free();
+	specularFloat.Free();
+	diffuseFloat.Free();
+	worldFloat.Free();
+	sampleCountFloat.Free();
 
 	gammaTable.clear();
 	gammaTablePrepared = false;
@@ -275,23 +289,121 @@ void cImage::CalculateGammaTable()
 	}
 }
 
+// Does the same as CalculatePixel() for a continuous run of pixels. Pixels are processed in
+// small blocks with separated color channels, so the loops can be vectorized by the compiler
+void cImage::CompilePixels(quint64 address, quint64 count)
+{
+	const int blockSize = 64;
+	float R[blockSize];
+	float G[blockSize];
+	float B[blockSize];
+
+	const float brightness = adj.brightness;
+	const float contrast = adj.contrast;
+	const float saturation = adj.saturation;
+	const bool hdrEnabled = adj.hdrEnabled;
+	const int *gamma = gammaTable.data();
+
+	const sRGBFloat *postImage = postImageFloat.data(); // nullptr in compact storage mode
+
+	for (quint64 blockStart = 0; blockStart < count; blockStart += blockSize)
+	{
+		const int n = int(qMin(count - blockStart, quint64(blockSize)));
+		sRGB16 *out = &image16[address + blockStart];
+
+		if (postImage)
+		{
+			const sRGBFloat *in = &postImage[address + blockStart];
+			for (int i = 0; i < n; i++)
+			{
+				R[i] = in[i].R;
+				G[i] = in[i].G;
+				B[i] = in[i].B;
+			}
+		}
+		else
+		{
+			for (int i = 0; i < n; i++)
+			{
+				sRGBFloat pixel = postImageFloat.Get(address + blockStart + i);
+				R[i] = pixel.R;
+				G[i] = pixel.G;
+				B[i] = pixel.B;
+			}
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			R[i] = (R[i] * brightness - 0.5f) * contrast + 0.5f;
+			G[i] = (G[i] * brightness - 0.5f) * contrast + 0.5f;
+			B[i] = (B[i] * brightness - 0.5f) * contrast + 0.5f;
+			R[i] = R[i] < 0.0f ? 0.0f : R[i];
+			G[i] = G[i] < 0.0f ? 0.0f : G[i];
+			B[i] = B[i] < 0.0f ? 0.0f : B[i];
+		}
+
+		if (hdrEnabled)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				R[i] = tanhf(R[i]);
+				G[i] = tanhf(G[i]);
+				B[i] = tanhf(B[i]);
+			}
+		}
+
+		// saturation
+		for (int i = 0; i < n; i++)
+		{
+			float V = sqrtf(R[i] * R[i] * 0.299f + G[i] * G[i] * 0.587f + B[i] * B[i] * 0.114f);
+			R[i] = clamp(V + (R[i] - V) * saturation, 0.0f, 1.0f);
+			G[i] = clamp(V + (G[i] - V) * saturation, 0.0f, 1.0f);
+			B[i] = clamp(V + (B[i] - V) * saturation, 0.0f, 1.0f);
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			out[i].R = quint16(gamma[quint16(R[i] * 65535.0f)]);
+			out[i].G = quint16(gamma[quint16(G[i] * 65535.0f)]);
+			out[i].B = quint16(gamma[quint16(B[i] * 65535.0f)]);
+		}
+	}
+}
+
+// splits rectangles into single lines, so they can be processed in parallel
+QVector<QRect> cImage::LinesOfRects(const QList<QRect> *list)
+{
+	QVector<QRect> lines;
+	for (auto rect : *list)
+	{
+		for (int y = rect.top(); y <= rect.bottom(); y++)
+			lines.append(QRect(rect.left(), y, rect.width(), 1));
+	}
+	return lines;
+}
+
 void cImage::CompileImage(QList<int> *list)
 {
-	int listIndex = 0;
-	for (quint64 y = 0; y < height; y++)
+	CalculateGammaTable();
+	if (image16.empty()) image16.resize(width * height);
+
+	if (list)
 	{
-		if (list)
+		const int numberOfLines = list->size();
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < numberOfLines; i++)
 		{
-			if (listIndex >= list->size()) break;
-			y = quint64(list->at(listIndex));
-			listIndex++;
+			quint64 y = quint64(list->at(i));
+			if (y < height) CompilePixels(y * width, width);
 		}
-		for (quint64 x = 0; x < width; x++)
+	}
+	else
+	{
+#pragma omp parallel for schedule(dynamic, 1)
+		for (qint64 y = 0; y < qint64(height); y++)
 		{
-			quint64 address = x + y * width;
-			sRGBFloat pixel = postImageFloat[address];
-			sRGB16 newPixel16 = CalculatePixel(pixel);
-			image16[address] = newPixel16;
+			CompilePixels(quint64(y) * width, width);
 		}
 	}
 }
@@ -300,18 +412,15 @@ void cImage::CompileImage(const QList<QRect> *list)
 {
 	if (!imageFloat.empty() && !postImageFloat.empty())
 	{
-		for (auto rect : *list)
+		CalculateGammaTable();
+		if (image16.empty()) image16.resize(width * height);
+		QVector<QRect> lines = LinesOfRects(list);
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < lines.size(); i++)
 		{
-			for (quint64 y = quint64(rect.top()); y <= quint64(rect.bottom()); y++)
-			{
-				for (quint64 x = quint64(rect.left()); x <= quint64(rect.right()); x++)
-				{
-					quint64 address = x + y * width;
-					sRGBFloat pixel = postImageFloat[address];
-					sRGB16 newPixel16 = CalculatePixel(pixel);
-					image16[address] = newPixel16;
-				}
-			}
+			const QRect &line = lines.at(i);
+			CompilePixels(quint64(line.left()) + quint64(line.top()) * width, quint64(line.width()));
 		}
 	}
 }
@@ -320,26 +429,20 @@ int cImage::GetUsedMB() const
 {
 	quint64 mb;
 
-	quint64 zBufferSize = width * height * sizeof(float);
-	quint64 alphaSize16 = width * height * sizeof(quint16);
-	quint64 alphaSize8 = width * height * sizeof(quint8);
-	quint64 imageFloatSize = width * height * sizeof(sRGBFloat);
-	quint64 image16Size = width * height * sizeof(sRGB16);
-	quint64 image8Size = width * height * sizeof(sRGB8);
-	quint64 colorSize = width * height * sizeof(sRGB8);
-	quint64 opacitySize = width * height * sizeof(quint16);
-	quint64 optionalSize = 0;
-
-	quint64 optionalChannels = 0;
-	if (opt.optionalNormal) optionalChannels++;
-	if (opt.optionalNormalWorld) optionalChannels++;
-	if (opt.optionalSpecular) optionalChannels++;
-	if (opt.optionalDiffuse) optionalChannels++;
-	if (opt.optionalWorld) optionalChannels++;
-	optionalSize +=
-		optionalChannels * width * height * (sizeof(sRGBFloat) + sizeof(sRGB16) + sizeof(sRGB8));
-
-	mb = (zBufferSize + alphaSize16 + alphaSize8 + image16Size + image8Size + imageFloatSize * 2
+	// only allocated buffers are counted (in compact mode 16 and 8-bit images are allocated later)
+	quint64 zBufferSize = zBuffer.size() * sizeof(float);
+	quint64 alphaSize16 = alphaBuffer16.size() * sizeof(quint16);
+	quint64 alphaSize8 = alphaBuffer8.size() * sizeof(quint8);
+	quint64 imageFloatSize = imageFloat.GetUsedMemory() + postImageFloat.GetUsedMemory();
+	quint64 image16Size = image16.size() * sizeof(sRGB16);
+	quint64 image8Size = image8.size() * sizeof(sRGB8);
+	quint64 colorSize = colourBuffer.size() * sizeof(sRGB8);
+	quint64 opacitySize = opacityBuffer.size() * sizeof(quint16);
+	quint64 optionalSize = normalFloat.GetUsedMemory() + normalFloatWorld.GetUsedMemory()
+												 + specularFloat.GetUsedMemory() + diffuseFloat.GetUsedMemory()
+												 + worldFloat.GetUsedMemory() + sampleCountFloat.GetUsedMemory();
+
+	mb = (zBufferSize + alphaSize16 + alphaSize8 + image16Size + image8Size + imageFloatSize
 				 + colorSize + opacitySize + optionalSize)
 			 / 1024 / 1024;
 
@@ -353,64 +456,91 @@ void cImage::SetImageParameters(sImageAdjustments adjustments)
 	CalculateGammaTable();
 }
 
+void cImage::ConvertPixelsTo8bit(quint64 address, quint64 count)
+{
+	const sRGB16 *in = &image16[address];
+	sRGB8 *out = &image8[address];
+	for (quint64 i = 0; i < count; i++)
+	{
+		out[i].R = quint8(in[i].R >> 8);
+		out[i].G = quint8(in[i].G >> 8);
+		out[i].B = quint8(in[i].B >> 8);
+	}
+}
+
 quint8 *cImage::ConvertTo8bit()
 {
-	for (quint64 i = 0; i < quint64(width) * quint64(height); i++)
+	if (image16.empty()) CompileImage();
+	if (image8.empty()) image8.resize(width * height);
+
+#pragma omp parallel for
+	for (qint64 y = 0; y < qint64(height); y++)
 	{
-		image8[i].R = image16[i].R / 256;
-		image8[i].G = image16[i].G / 256;
-		image8[i].B = image16[i].B / 256;
+		ConvertPixelsTo8bit(quint64(y) * width, width);
 	}
 	return reinterpret_cast<quint8 *>(image8.data());
 }
 
 quint8 *cImage::ConvertTo8bit(const QList<QRect> *list)
 {
-	for (auto rect : *list)
+	if (image16.empty()) CompileImage();
+	if (image8.empty()) image8.resize(width * height);
+	QVector<QRect> lines = LinesOfRects(list);
+
+#pragma omp parallel for
+	for (int i = 0; i < lines.size(); i++)
 	{
-		{
-			for (quint64 y = quint64(rect.top()); y <= quint64(rect.bottom()); y++)
-			{
-				for (quint64 x = quint64(rect.left()); x <= quint64(rect.right()); x++)
-				{
-					quint64 address = x + y * width;
-					image8[address].R = image16[address].R / 256;
-					image8[address].G = image16[address].G / 256;
-					image8[address].B = image16[address].B / 256;
-				}
-			}
-		}
+		const QRect &line = lines.at(i);
+		ConvertPixelsTo8bit(quint64(line.left()) + quint64(line.top()) * width, quint64(line.width()));
 	}
 	return reinterpret_cast<quint8 *>(image8.data());
 }
 
 quint8 *cImage::ConvertAlphaTo8bit()
 {
-	for (quint64 i = 0; i < quint64(width) * quint64(height); i++)
+	if (alphaBuffer8.empty()) alphaBuffer8.resize(width * height);
+
+#pragma omp parallel for
+	for (qint64 y = 0; y < qint64(height); y++)
 	{
-		alphaBuffer8[i] = alphaBuffer16[i] / 256;
+		const quint16 *in = &alphaBuffer16[quint64(y) * width];
+		quint8 *out = &alphaBuffer8[quint64(y) * width];
+		for (quint64 x = 0; x < width; x++)
+			out[x] = quint8(in[x] >> 8);
 	}
 	return alphaBuffer8.data();
 }
 
 quint8 *cImage::ConvertGenericRGBTo8bit(std::vector<sRGBFloat> &from, std::vector<sRGB8> &to)
 {
-	for (quint64 i = 0; i < quint64(width) * quint64(height); i++)
+#pragma omp parallel for
+	for (qint64 y = 0; y < qint64(height); y++)
 	{
-		to[i].R = quint8(qBound(0.0f, from[i].R * 255.0f, 255.0f));
-		to[i].G = quint8(qBound(0.0f, from[i].G * 255.0f, 255.0f));
-		to[i].B = quint8(qBound(0.0f, from[i].B * 255.0f, 255.0f));
+		const sRGBFloat *in = &from[quint64(y) * width];
+		sRGB8 *out = &to[quint64(y) * width];
+		for (quint64 x = 0; x < width; x++)
+		{
+			out[x].R = quint8(clamp(in[x].R * 255.0f, 0.0f, 255.0f));
+			out[x].G = quint8(clamp(in[x].G * 255.0f, 0.0f, 255.0f));
+			out[x].B = quint8(clamp(in[x].B * 255.0f, 0.0f, 255.0f));
+		}
 	}
 	return reinterpret_cast<quint8 *>(to.data());
 }
 
 quint8 *cImage::ConvertGenericRGBTo16bit(std::vector<sRGBFloat> &from, std::vector<sRGB16> &to)
 {
-	for (quint64 i = 0; i < quint64(width) * quint64(height); i++)
+#pragma omp parallel for
+	for (qint64 y = 0; y < qint64(height); y++)
 	{
-		to[i].R = quint16(qBound(0.0f, from[i].R * 65535.0f, 65535.0f));
-		to[i].G = quint16(qBound(0.0f, from[i].G * 65535.0f, 65535.0f));
-		to[i].B = quint16(qBound(0.0f, from[i].B * 65535.0f, 65535.0f));
+		const sRGBFloat *in = &from[quint64(y) * width];
+		sRGB16 *out = &to[quint64(y) * width];
+		for (quint64 x = 0; x < width; x++)
+		{
+			out[x].R = quint16(clamp(in[x].R * 65535.0f, 0.0f, 65535.0f));
+			out[x].G = quint16(clamp(in[x].G * 65535.0f, 0.0f, 65535.0f));
+			out[x].B = quint16(clamp(in[x].B * 65535.0f, 0.0f, 65535.0f));
+		}
 	}
 	return reinterpret_cast<quint8 *>(to.data());
 }
@@ -475,10 +605,65 @@ quint8 *cImage::CreatePreview(
 	return ptr;
 }
 
+void cImage::UpdatePreviewLine(quint64 y, quint64 xStart, quint64 xEnd)
+{
+	quint64 w = previewWidth;
+	quint64 h = previewHeight;
+
+	float scaleX = float(width) / w;
+	float scaleY = float(height) / h;
+
+	// number of pixels to sum
+	int countX = int(float(width) / w + 1);
+	int countY = int(float(height) / h + 1);
+	int factor = countX * countY;
+
+	float deltaX = scaleX / countX;
+	float deltaY = scaleY / countY;
+
+	for (quint64 x = xStart; x <= xEnd; x++)
+	{
+		if (fastPreview)
+		{
+			quint64 xx = quint64(x * scaleX);
+			quint64 yy = quint64(y * scaleY);
+			preview[x + y * w] = image8[yy * width + xx];
+		}
+		else
+		{
+			int R = 0;
+			int G = 0;
+			int B = 0;
+			for (int j = 0; j < countY; j++)
+			{
+				float yy = y * scaleY + j * deltaY - 0.5f;
+
+				for (int i = 0; i < countX; i++)
+				{
+					float xx = x * scaleX + i * deltaX - 0.5f;
+					if (xx > 0 && xx < width - 1 && yy > 0 && yy < height - 1)
+					{
+						sRGB8 oldPixel = Interpolation(xx, yy);
+						R += oldPixel.R;
+						G += oldPixel.G;
+						B += oldPixel.B;
+					}
+				} // next i
+			}		// next j
+			sRGB8 newPixel;
+			newPixel.R = quint8(R / factor);
+			newPixel.G = quint8(G / factor);
+			newPixel.B = quint8(B / factor);
+			preview[x + y * w] = newPixel;
+		}
+	} // next x
+}
+
 void cImage::UpdatePreview(QList<int> *list)
 {
 	if (previewAllocated && !allocLater)
 	{
+		if (image8.empty()) ConvertTo8bit();
 		previewMutex.lock();
 		quint64 w = previewWidth;
 		quint64 h = previewHeight;
@@ -489,22 +674,13 @@ void cImage::UpdatePreview(QList<int> *list)
 		}
 		else
 		{
-			float scaleX = float(width) / w;
 			float scaleY = float(height) / h;
 
-			// number of pixels to sum
-			int countX = int(float(width) / w + 1);
-			int countY = int(float(height) / h + 1);
-			int factor = countX * countY;
-
-			float deltaX = scaleX / countX;
-			float deltaY = scaleY / countY;
-
+			// preview lines which are affected by the listed image lines
+			std::vector<qint64> lines;
 			int listIndex = 0;
-
 			for (quint64 y = 0; y < h; y++)
 			{
-
 				if (list)
 				{
 					if (listIndex >= list->size()) break;
@@ -517,44 +693,14 @@ void cImage::UpdatePreview(QList<int> *list)
 						if (listIndex >= list->size()) break;
 					}
 				}
+				lines.push_back(qint64(y));
+			}
 
-				for (quint64 x = 0; x < w; x++)
-				{
-					if (fastPreview)
-					{
-						quint64 xx = quint64(x * scaleX);
-						quint64 yy = quint64(y * scaleY);
-						preview[x + y * w] = image8[yy * width + xx];
-					}
-					else
-					{
-						int R = 0;
-						int G = 0;
-						int B = 0;
-						for (int j = 0; j < countY; j++)
-						{
-							float yy = y * scaleY + j * deltaY - 0.5f;
-
-							for (int i = 0; i < countX; i++)
-							{
-								float xx = x * scaleX + i * deltaX - 0.5f;
-								if (xx > 0 && xx < width - 1 && yy > 0 && yy < height - 1)
-								{
-									sRGB8 oldPixel = Interpolation(xx, yy);
-									R += oldPixel.R;
-									G += oldPixel.G;
-									B += oldPixel.B;
-								}
-							} // next i
-						}		// next j
-						sRGB8 newPixel;
-						newPixel.R = quint8(R / factor);
-						newPixel.G = quint8(G / factor);
-						newPixel.B = quint8(B / factor);
-						preview[x + y * w] = newPixel;
-					}
-				} // next x
-			}		// next y
+#pragma omp parallel for schedule(dynamic, 1)
+			for (qint64 i = 0; i < qint64(lines.size()); i++)
+			{
+				UpdatePreviewLine(quint64(lines[i]), 0, w - 1);
+			}
 		}
 		preview2 = preview;
 		previewMutex.unlock();
@@ -569,6 +715,7 @@ void cImage::UpdatePreview(const QList<QRect> *list)
 {
 	if (previewAllocated && !allocLater)
 	{
+		if (image8.empty()) ConvertTo8bit();
 		previewMutex.lock();
 		quint64 w = previewWidth;
 		quint64 h = previewHeight;
@@ -579,70 +726,23 @@ void cImage::UpdatePreview(const QList<QRect> *list)
 		}
 		else
 		{
+			float scaleX = float(width) / w;
+			float scaleY = float(height) / h;
+
 			for (auto rect : *list)
 			{
-				float scaleX = float(width) / w;
-				float scaleY = float(height) / h;
-
-				// number of pixels to sum
-				int countX = int(float(width) / w + 1);
-				int countY = int(float(height) / h + 1);
-				int factor = countX * countY;
-
-				float deltaX = scaleX / countX;
-				float deltaY = scaleY / countY;
-
 				quint64 xStart = quint64(rect.left() / scaleX);
-				xStart = qMax(xStart, 0ULL);
 				quint64 xEnd = quint64((rect.right() + 1) / scaleX);
 				xEnd = qMin(xEnd, w - 1);
-				quint64 yStart = quint64(rect.top() / scaleY);
-				yStart = qMax(yStart, 0ULL);
-				quint64 yEnd = quint64((rect.bottom() + 1) / scaleY);
-				yEnd = qMin(yEnd, h - 1);
-
-				//#ifndef _WIN32
-				//#pragma omp parallel for
-				//#endif
-				for (quint64 y = yStart; y <= yEnd; y++)
+				qint64 yStart = qint64(rect.top() / scaleY);
+				qint64 yEnd = qint64((rect.bottom() + 1) / scaleY);
+				yEnd = qMin(yEnd, qint64(h) - 1);
+
+#pragma omp parallel for schedule(dynamic, 1)
+				for (qint64 y = yStart; y <= yEnd; y++)
 				{
-					for (quint64 x = xStart; x <= xEnd; x++)
-					{
-						if (fastPreview)
-						{
-							quint64 xx = quint64(x * scaleX);
-							quint64 yy = quint64(y * scaleY);
-							preview[x + y * w] = image8[yy * width + xx];
-						}
-						else
-						{
-							int R = 0;
-							int G = 0;
-							int B = 0;
-							for (int j = 0; j < countY; j++)
-							{
-								float yy = y * scaleY + j * deltaY - 0.5f;
-
-								for (int i = 0; i < countX; i++)
-								{
-									float xx = x * scaleX + i * deltaX - 0.5f;
-									if (xx > 0 && xx < width - 1 && yy > 0 && yy < height - 1)
-									{
-										sRGB8 oldPixel = Interpolation(xx, yy);
-										R += oldPixel.R;
-										G += oldPixel.G;
-										B += oldPixel.B;
-									}
-								} // next i
-							}		// next j
-							sRGB8 newPixel;
-							newPixel.R = quint8(R / factor);
-							newPixel.G = quint8(G / factor);
-							newPixel.B = quint8(B / factor);
-							preview[x + y * w] = newPixel;
-						}
-					} // next x
-				}		// next y
+					UpdatePreviewLine(quint64(y), xStart, xEnd);
+				}
 			}
 		}
 
@@ -723,8 +823,8 @@ void cImage::Squares(quint64 y, int pFactor)
 	for (quint64 x = 0; x <= width - quint64(pf); x += pf)
 	{
 		quint64 ptr = x + y * width;
-		sRGBFloat pixelTemp = imageFloat[ptr];
-		sRGBFloat postPixelTemp = postImageFloat[ptr];
+		sRGBFloat pixelTemp = imageFloat.Get(ptr);
+		sRGBFloat postPixelTemp = postImageFloat.Get(ptr);
 		float zBufferTemp = zBuffer[ptr];
 		sRGB8 colourTemp = colourBuffer[ptr];
 		quint16 alphaTemp = alphaBuffer16[ptr];
@@ -736,8 +836,8 @@ void cImage::Squares(quint64 y, int pFactor)
 			{
 				if (xx == 0 && yy == 0) continue;
 				quint64 ptr2 = (x + xx) + (y + yy) * (width);
-				imageFloat[ptr2] = pixelTemp;
-				postImageFloat[ptr2] = postPixelTemp;
+				imageFloat.Put(ptr2, pixelTemp);
+				postImageFloat.Put(ptr2, postPixelTemp);
 				zBuffer[ptr2] = zBufferTemp;
 				colourBuffer[ptr2] = colourTemp;
 				alphaBuffer16[ptr2] = alphaTemp;
@@ -1024,12 +1124,7 @@ void cImage::NullPostEffect(QList<int> *list)
 					listIndex++;
 				}
 
-				qint64 offset = qint64(y * width);
-				auto first = imageFloat.begin() + offset;
-				auto last = imageFloat.begin() + offset + qint64(width);
-				auto fisrDest = postImageFloat.begin() + offset;
-
-				std::copy(first, last, fisrDest);
+				postImageFloat.CopyFrom(imageFloat, y * width, width);
 			}
 		}
 	}
@@ -1043,12 +1138,7 @@ void cImage::NullPostEffect(const QList<QRect> *list)
 		{
 			for (quint64 y = quint64(rect.top()); y <= quint64(rect.bottom()); y++)
 			{
-				qint64 offset = qint64(y * width) + rect.left();
-				auto first = imageFloat.begin() + offset;
-				auto last = imageFloat.begin() + offset + rect.width();
-				auto fisrDest = postImageFloat.begin() + offset;
-
-				std::copy(first, last, fisrDest);
+				postImageFloat.CopyFrom(imageFloat, y * width + rect.left(), quint64(rect.width()));
 			}
 		}
 	}
@@ -1062,6 +1152,17 @@ void cImage::GetStereoLeftRightImages(cImage *left, cImage *right)
 		left->ChangeSize(halfWidth, height, opt);
 		right->ChangeSize(halfWidth, height, opt);
 
+		// 16-bit and 8-bit buffers can be not allocated yet in compact storage mode
+		const bool copy16 = !image16.empty();
+		const bool copy8 = !image8.empty();
+		const bool copyAlpha8 = !alphaBuffer8.empty();
+		for (cImage *target : {left, right})
+		{
+			if (copy16) target->image16.resize(halfWidth * height);
+			if (copy8) target->image8.resize(halfWidth * height);
+			if (copyAlpha8) target->alphaBuffer8.resize(halfWidth * height);
+		}
+
 		for (quint64 y = 0; y < height; y++)
 		{
 			for (quint64 x = 0; x < halfWidth; x++)
@@ -1070,20 +1171,29 @@ void cImage::GetStereoLeftRightImages(cImage *left, cImage *right)
 				quint64 ptrLeft = x + y * width;
 				quint64 ptrRight = (x + halfWidth) + y * width;
 
-				left->image8[ptrNew] = image8[ptrLeft];
-				right->image8[ptrNew] = image8[ptrRight];
+				if (copy8)
+				{
+					left->image8[ptrNew] = image8[ptrLeft];
+					right->image8[ptrNew] = image8[ptrRight];
+				}
 
-				left->image16[ptrNew] = image16[ptrLeft];
-				right->image16[ptrNew] = image16[ptrRight];
+				if (copy16)
+				{
+					left->image16[ptrNew] = image16[ptrLeft];
+					right->image16[ptrNew] = image16[ptrRight];
+				}
 
-				left->imageFloat[ptrNew] = imageFloat[ptrLeft];
-				right->imageFloat[ptrNew] = imageFloat[ptrRight];
+				left->imageFloat.Put(ptrNew, imageFloat.Get(ptrLeft));
+				right->imageFloat.Put(ptrNew, imageFloat.Get(ptrRight));
 
-				left->postImageFloat[ptrNew] = postImageFloat[ptrLeft];
-				right->postImageFloat[ptrNew] = postImageFloat[ptrRight];
+				left->postImageFloat.Put(ptrNew, postImageFloat.Get(ptrLeft));
+				right->postImageFloat.Put(ptrNew, postImageFloat.Get(ptrRight));
 
-				left->alphaBuffer8[ptrNew] = alphaBuffer8[ptrLeft];
-				right->alphaBuffer8[ptrNew] = alphaBuffer8[ptrRight];
+				if (copyAlpha8)
+				{
+					left->alphaBuffer8[ptrNew] = alphaBuffer8[ptrLeft];
+					right->alphaBuffer8[ptrNew] = alphaBuffer8[ptrRight];
+				}
 
 				left->alphaBuffer16[ptrNew] = alphaBuffer16[ptrLeft];
 				right->alphaBuffer16[ptrNew] = alphaBuffer16[ptrRight];
@@ -1099,28 +1209,33 @@ void cImage::GetStereoLeftRightImages(cImage *left, cImage *right)
 
 				if (opt.optionalNormal)
 				{
-					left->normalFloat[ptrNew] = normalFloat[ptrLeft];
-					right->normalFloat[ptrNew] = normalFloat[ptrRight];
+					left->normalFloat.Put(ptrNew, normalFloat.Get(ptrLeft));
+					right->normalFloat.Put(ptrNew, normalFloat.Get(ptrRight));
 				}
 				if (opt.optionalNormalWorld)
 				{
-					left->normalFloatWorld[ptrNew] = normalFloatWorld[ptrLeft];
-					right->normalFloatWorld[ptrNew] = normalFloatWorld[ptrRight];
+					left->normalFloatWorld.Put(ptrNew, normalFloatWorld.Get(ptrLeft));
+					right->normalFloatWorld.Put(ptrNew, normalFloatWorld.Get(ptrRight));
 				}
 				if (opt.optionalSpecular)
 				{
-					left->specularFloat[ptrNew] = specularFloat[ptrLeft];
-					right->specularFloat[ptrNew] = specularFloat[ptrRight];
+					left->specularFloat.Put(ptrNew, specularFloat.Get(ptrLeft));
+					right->specularFloat.Put(ptrNew, specularFloat.Get(ptrRight));
 				}
 				if (opt.optionalDiffuse)
 				{
-					left->diffuseFloat[ptrNew] = diffuseFloat[ptrLeft];
-					right->diffuseFloat[ptrNew] = diffuseFloat[ptrRight];
+					left->diffuseFloat.Put(ptrNew, diffuseFloat.Get(ptrLeft));
+					right->diffuseFloat.Put(ptrNew, diffuseFloat.Get(ptrRight));
 				}
 				if (opt.optionalWorld)
 				{
-					left->worldFloat[ptrNew] = worldFloat[ptrLeft];
-					right->worldFloat[ptrNew] = worldFloat[ptrRight];
+					left->worldFloat.Put(ptrNew, worldFloat.Get(ptrLeft));
+					right->worldFloat.Put(ptrNew, worldFloat.Get(ptrRight));
+				}
+				if (opt.optionalSampleCount)
+				{
+					left->sampleCountFloat.Put(ptrNew, sampleCountFloat.Get(ptrLeft));
+					right->sampleCountFloat.Put(ptrNew, sampleCountFloat.Get(ptrRight));
 				}
 			}
 		}
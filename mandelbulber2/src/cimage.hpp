@@ -36,13 +36,16 @@
 #define MANDELBULBER2_SRC_CIMAGE_HPP_
 
 //#include <QtGui/QWidget>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <vector>
 
 #include <QMutex>
 #include <QWidget>
 #include <QString>
 #include <QMap>
+#include <QVector>
 #include <QDebug>
 
 #include "color_structures.hpp"
@@ -55,7 +58,12 @@ struct sImageOptional
 	{
 		return (other.optionalNormal == optionalNormal) && (other.optionalSpecular == optionalSpecular)
 					 && (other.optionalDiffuse == optionalDiffuse) && (other.optionalWorld == optionalWorld)
-					 && (other.optionalNormalWorld == optionalNormalWorld);
+					 && (other.optionalNormalWorld == optionalNormalWorld)
+					 && (other.optionalSampleCount == optionalSampleCount)
+					 && (other.compactStorage == compactStorage) && (other.halfNormal == halfNormal)
+					 && (other.halfNormalWorld == halfNormalWorld) && (other.halfSpecular == halfSpecular)
+					 && (other.halfDiffuse == halfDiffuse) && (other.halfWorld == halfWorld)
+					 && (other.halfSampleCount == halfSampleCount);
 	}
 
 	bool optionalNormal{false};
@@ -63,6 +71,85 @@ struct sImageOptional
 	bool optionalSpecular{false};
 	bool optionalDiffuse{false};
 	bool optionalWorld{false};
+	bool optionalSampleCount{false};
+
+	// image layers stored in half precision, 16-bit and 8-bit buffers allocated when needed
+	bool compactStorage{false};
+
+	// optional channels stored in half precision (used only with compactStorage)
+	bool halfNormal{false};
+	bool halfNormalWorld{false};
+	bool halfSpecular{false};
+	bool halfDiffuse{false};
+	bool halfWorld{false};
+	bool halfSampleCount{false};
+};
+
+// RGB image layer stored in full float or in half precision
+class cImageFloatLayer
+{
+public:
+	void Alloc(quint64 size, bool halfPrecision)
+	{
+		Free();
+		if (halfPrecision)
+			pixelsHalf.resize(size);
+		else
+			pixelsFloat.resize(size);
+	}
+	void Free()
+	{
+		pixelsFloat.clear();
+		pixelsFloat.shrink_to_fit();
+		pixelsHalf.clear();
+		pixelsHalf.shrink_to_fit();
+	}
+	void Clear()
+	{
+		std::fill(pixelsFloat.begin(), pixelsFloat.end(), sRGBFloat());
+		std::fill(pixelsHalf.begin(), pixelsHalf.end(), sRGBHalf());
+	}
+	bool empty() const { return pixelsFloat.empty() && pixelsHalf.empty(); }
+	bool IsHalf() const { return !pixelsHalf.empty(); }
+	quint64 GetUsedMemory() const
+	{
+		return pixelsFloat.size() * sizeof(sRGBFloat) + pixelsHalf.size() * sizeof(sRGBHalf);
+	}
+
+	inline sRGBFloat Get(quint64 index) const
+	{
+		return pixelsHalf.empty() ? pixelsFloat[index] : toRGBFloat(pixelsHalf[index]);
+	}
+	inline void Put(quint64 index, const sRGBFloat &pixel)
+	{
+		if (pixelsHalf.empty())
+			pixelsFloat[index] = pixel;
+		else
+			pixelsHalf[index] = toRGBHalf(pixel);
+	}
+
+	// copies pixels from layer with the same storage type
+	void CopyFrom(const cImageFloatLayer &source, quint64 index, quint64 count)
+	{
+		if (pixelsHalf.empty())
+		{
+			const sRGBFloat *first = &source.pixelsFloat[index];
+			std::copy(first, first + count, &pixelsFloat[index]);
+		}
+		else
+		{
+			const sRGBHalf *first = &source.pixelsHalf[index];
+			std::copy(first, first + count, &pixelsHalf[index]);
+		}
+	}
+
+	// nullptr when the layer is stored in half precision
+	sRGBFloat *data() { return pixelsFloat.empty() ? nullptr : pixelsFloat.data(); }
+	const sRGBFloat *data() const { return pixelsFloat.empty() ? nullptr : pixelsFloat.data(); }
+
+private:
+	std::vector<sRGBFloat> pixelsFloat;
+	std::vector<sRGBHalf> pixelsHalf;
 };
 
 struct sAllImageData
@@ -121,11 +208,11 @@ public:
 
 	inline void PutPixelImage(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		imageFloat[getImageIndex(x, y)] = pixel;
+		imageFloat.Put(getImageIndex(x, y), pixel);
 	}
 	inline void PutPixelPostImage(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		postImageFloat[getImageIndex(x, y)] = pixel;
+		postImageFloat.Put(getImageIndex(x, y), pixel);
 	}
 	inline void PutPixelImage16(quint64 x, quint64 y, sRGB16 pixel)
 	{
@@ -149,31 +236,35 @@ public:
 	}
 	inline void PutPixelNormal(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		normalFloat[getImageIndex(x, y)] = pixel;
+		normalFloat.Put(getImageIndex(x, y), pixel);
 	}
 	inline void PutPixelNormalWorld(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		normalFloatWorld[getImageIndex(x, y)] = pixel;
+		normalFloatWorld.Put(getImageIndex(x, y), pixel);
 	}
 	inline void PutPixelSpecular(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		specularFloat[getImageIndex(x, y)] = pixel;
+		specularFloat.Put(getImageIndex(x, y), pixel);
 	}
 	inline void PutPixelDiffuse(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		diffuseFloat[getImageIndex(x, y)] = pixel;
+		diffuseFloat.Put(getImageIndex(x, y), pixel);
 	}
 	inline void PutPixelWorld(quint64 x, quint64 y, sRGBFloat pixel)
 	{
-		worldFloat[getImageIndex(x, y)] = pixel;
+		worldFloat.Put(getImageIndex(x, y), pixel);
+	}
+	inline void PutPixelSampleCount(quint64 x, quint64 y, sRGBFloat pixel)
+	{
+		sampleCountFloat.Put(getImageIndex(x, y), pixel);
 	}
 	inline sRGBFloat GetPixelImage(quint64 x, quint64 y) const
 	{
-		return imageFloat[getImageIndex(x, y)];
+		return imageFloat.Get(getImageIndex(x, y));
 	}
 	inline sRGBFloat GetPixelPostImage(quint64 x, quint64 y) const
 	{
-		return postImageFloat[getImageIndex(x, y)];
+		return postImageFloat.Get(getImageIndex(x, y));
 	}
 	inline sRGB16 GetPixelImage16(quint64 x, quint64 y) const { return image16[getImageIndex(x, y)]; }
 	inline sRGB8 GetPixelImage8(quint64 x, quint64 y) const { return image8[getImageIndex(x, y)]; }
@@ -214,12 +305,16 @@ public:
 	{
 		return GetPixelGeneric(worldFloat, opt.optionalWorld, x, y);
 	}
+	inline sRGBFloat GetPixelSampleCount(quint64 x, quint64 y)
+	{
+		return GetPixelGeneric(sampleCountFloat, opt.optionalSampleCount, x, y);
+	}
 
 	inline sRGBFloat GetPixelGeneric(
-		const std::vector<sRGBFloat> &from, bool available, quint64 x, quint64 y)
+		const cImageFloatLayer &from, bool available, quint64 x, quint64 y)
 	{
 		if (!available) return BlackFloat();
-		return from[getImageIndex(x, y)];
+		return from.Get(getImageIndex(x, y));
 	}
 	inline sRGB16 GetPixelGeneric16(
 		const std::vector<sRGB16> &from, bool available, quint64 x, quint64 y)
@@ -246,9 +341,11 @@ public:
 	{
 		float factorN = 1.0f - factor;
 		quint64 imgIndex = getImageIndex(x, y);
-		postImageFloat[imgIndex].R = postImageFloat[imgIndex].R * factorN + other.R * factor;
-		postImageFloat[imgIndex].G = postImageFloat[imgIndex].G * factorN + other.G * factor;
-		postImageFloat[imgIndex].B = postImageFloat[imgIndex].B * factorN + other.B * factor;
+		sRGBFloat pixel = postImageFloat.Get(imgIndex);
+		pixel.R = pixel.R * factorN + other.R * factor;
+		pixel.G = pixel.G * factorN + other.G * factor;
+		pixel.B = pixel.B * factorN + other.B * factor;
+		postImageFloat.Put(imgIndex, pixel);
 	}
 
 	inline void BlendPixelAlpha(quint64 x, quint64 y, float factor, quint16 other)
@@ -258,6 +355,7 @@ public:
 		alphaBuffer16[imgIndex] = quint16(alphaBuffer16[imgIndex] * factorN + other * factor);
 	}
 
+	// float pointers are nullptr in compact storage mode
 	sRGBFloat *GetImageFloatPtr() { return imageFloat.data(); }
 	sRGBFloat *GetPostImageFloatPtr() { return postImageFloat.data(); }
 	sRGB16 *GetImage16Ptr() { return image16.data(); }
@@ -287,6 +385,7 @@ public:
 	void SetImageParameters(sImageAdjustments adjustments);
 	sImageAdjustments *GetImageAdjustments() { return &adj; }
 	void SetImageOptional(sImageOptional optInput) { opt = optInput; }
+	bool IsCompactStorage() const { return opt.compactStorage; }
 	sImageOptional *GetImageOptional() { return &opt; }
 
 	quint8 *ConvertGenericRGBTo8bit(std::vector<sRGBFloat> &from, std::vector<sRGB8> &to);
@@ -328,6 +427,10 @@ public:
 private:
 	bool isAllocated;
 	sRGB8 Interpolation(float x, float y) const;
+	void CompilePixels(quint64 address, quint64 count);
+	void ConvertPixelsTo8bit(quint64 address, quint64 count);
+	void UpdatePreviewLine(quint64 y, quint64 xStart, quint64 xEnd);
+	static QVector<QRect> LinesOfRects(const QList<QRect> *list);
 	bool AllocMem();
 	void FreeImage();
 	static inline sRGB16 Black16() { return sRGB16(0, 0, 0); }
@@ -336,8 +439,8 @@ private:
 
 	std::vector<sRGB8> image8;
 	std::vector<sRGB16> image16;
-	std::vector<sRGBFloat> imageFloat;
-	std::vector<sRGBFloat> postImageFloat;
+	cImageFloatLayer imageFloat;
+	cImageFloatLayer postImageFloat;
 
 	std::vector<quint8> alphaBuffer8;
 	std::vector<quint16> alphaBuffer16;
@@ -346,11 +449,12 @@ private:
 	std::vector<float> zBuffer;
 
 	// optional image buffers
-	std::vector<sRGBFloat> normalFloat;
-	std::vector<sRGBFloat> normalFloatWorld;
-	std::vector<sRGBFloat> specularFloat;
-	std::vector<sRGBFloat> diffuseFloat;
-	std::vector<sRGBFloat> worldFloat;
+	cImageFloatLayer normalFloat;
+	cImageFloatLayer normalFloatWorld;
+	cImageFloatLayer specularFloat;
+	cImageFloatLayer diffuseFloat;
+	cImageFloatLayer worldFloat;
+	cImageFloatLayer sampleCountFloat;
 
 	std::vector<sRGB8> preview;
 	std::vector<sRGB8> preview2;
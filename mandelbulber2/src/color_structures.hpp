@@ -35,6 +35,8 @@
 #ifndef MANDELBULBER2_SRC_COLOR_STRUCTURES_HPP_
 #define MANDELBULBER2_SRC_COLOR_STRUCTURES_HPP_
 
+#include <cstring>
+
 #include <QtGlobal>
 
 template <typename T>
@@ -94,9 +96,72 @@ inline tsRGBA<float>::tsRGBA()
 	A = 1.0;
 }
 
+// IEEE 754 half precision floating point number, used for compact storage of image layers
+struct sHalf
+{
+	quint16 bits;
+
+	sHalf() : bits(0) {}
+	sHalf(float value) : bits(FloatToHalf(value)) {}
+	operator float() const { return HalfToFloat(bits); }
+
+	static inline quint16 FloatToHalf(float value)
+	{
+		quint32 f;
+		memcpy(&f, &value, sizeof(f));
+		const quint32 sign = (f >> 16) & 0x8000;
+		f &= 0x7fffffff;
+
+		if (f >= 0x47800000) // too big for half, infinity or NaN
+			return quint16(sign | (f > 0x7f800000 ? 0x7e00 : 0x7c00));
+
+		if (f < 0x38800000) // denormalized half or zero
+		{
+			if (f < 0x33000000) return quint16(sign);
+			const quint32 shift = 126 - (f >> 23);
+			const quint32 mantissa = (f & 0x7fffff) | 0x800000;
+			quint32 h = mantissa >> shift;
+			const quint32 remainder = mantissa & ((1u << shift) - 1);
+			const quint32 halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (h & 1))) h++;
+			return quint16(sign | h);
+		}
+
+		// normalized number: exponent rebiased from 127 to 15, mantissa rounded to nearest even
+		quint32 h = (f - 0x38000000) >> 13;
+		const quint32 remainder = f & 0x1fff;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1))) h++;
+		return quint16(sign | h);
+	}
+
+	static inline float HalfToFloat(quint16 h)
+	{
+		const quint32 sign = quint32(h & 0x8000) << 16;
+		const quint32 exponent = (h >> 10) & 0x1f;
+		const quint32 mantissa = h & 0x3ff;
+
+		if (exponent == 0) // zero or denormalized half
+		{
+			float value = mantissa * 5.9604645e-8f; // 2^-24
+			return sign ? -value : value;
+		}
+
+		quint32 f;
+		if (exponent == 0x1f)
+			f = sign | 0x7f800000 | (mantissa << 13);
+		else
+			f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+		float value;
+		memcpy(&value, &f, sizeof(value));
+		return value;
+	}
+};
+
 using sRGB8 = tsRGB<quint8>;
 using sRGB16 = tsRGB<quint16>;
 using sRGBFloat = tsRGB<float>;
+using sRGBHalf = tsRGB<sHalf>;
 using sRGB = tsRGB<qint32>;
 
 using sRGBA8 = tsRGBA<quint8>;
@@ -118,4 +183,14 @@ inline sRGBFloat toRGBFloat(sRGB8 c)
 	return sRGBFloat(c.R / 256.0, c.G / 256.0, c.B / 256.0);
 }
 
+inline sRGBFloat toRGBFloat(sRGBHalf c)
+{
+	return sRGBFloat(c.R, c.G, c.B);
+}
+
+inline sRGBHalf toRGBHalf(sRGBFloat c)
+{
+	return sRGBHalf(c.R, c.G, c.B);
+}
+
 #endif /* MANDELBULBER2_SRC_COLOR_STRUCTURES_HPP_ */
@@ -120,6 +120,13 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *qApplication)
 			"main", "Overrides image resolution. Specify as width and height separated by 'x'"),
 		QCoreApplication::translate("main", "WxH"));
 
+	const QCommandLineOption tilesOption(QStringList({"tiles"}),
+		QCoreApplication::translate("main",
+			"Renders still image in N x N tiles and writes finished tiles directly to the file, so"
+			" the whole image doesn't have to fit in memory (formats: png, png16, png16alpha, tiff,"
+			" exr)."),
+		QCoreApplication::translate("main", "N"));
+
 	const QCommandLineOption fpkOption("fpk",
 		QCoreApplication::translate("main", "Overrides frames per key parameter."),
 		QCoreApplication::translate("main", "N"));
@@ -209,6 +216,7 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *qApplication)
 	parser.addOption(listOption);
 	parser.addOption(formatOption);
 	parser.addOption(resOption);
+	parser.addOption(tilesOption);
 	parser.addOption(fpkOption);
 	parser.addOption(serverOption);
 	parser.addOption(hostOption);
@@ -247,6 +255,7 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *qApplication)
 	cliData.overrideParametersText = parser.value(overrideOption);
 	cliData.imageFileFormat = parser.value(formatOption);
 	cliData.resolution = parser.value(resOption);
+	cliData.tilesText = parser.value(tilesOption);
 	cliData.fpkText = parser.value(fpkOption);
 	cliData.server = parser.isSet(serverOption);
 	cliData.host = parser.value(hostOption);
@@ -334,6 +343,9 @@ void cCommandLineInterface::ReadCLI()
 	else
 		cliData.imageFileFormat = "jpg";
 
+	// tiled rendering of still image
+	if (cliData.tilesText != "") handleTiles();
+
 	// silent mode
 	if (cliData.silent) systemData.silent = true;
 
@@ -419,7 +431,11 @@ void cCommandLineInterface::ProcessCLI() const
 		case modeStill:
 		{
 			gMainInterface->headless = new cHeadless();
-			gMainInterface->headless->RenderStillImage(cliData.outputText, cliData.imageFileFormat);
+			if (cliData.tilesText != "")
+				gMainInterface->headless->RenderStillImageTiled(
+					cliData.outputText, cliData.imageFileFormat);
+			else
+				gMainInterface->headless->RenderStillImage(cliData.outputText, cliData.imageFileFormat);
 			break;
 		}
 		case modeQueue:
@@ -462,6 +478,17 @@ void cCommandLineInterface::printExampleHelpAndExit()
 		"within frames 200 till 300.")
 			<< "\n\n";
 
+	out << cHeadless::colorize(QObject::tr("Tiled render of a huge image"), cHeadless::ansiBlue)
+			<< "\n";
+	out << cHeadless::colorize(
+		"mandelbulber2 -n -r 40000x30000 --tiles 16 -f tiff path/to/fractal.fract",
+		cHeadless::ansiYellow)
+			<< "\n";
+	out << QObject::tr(
+		"Renders the image in 16x16 tiles one after another and writes each finished tile to the "
+		"tiled TIFF file, so the whole image is never kept in memory.")
+			<< "\n\n";
+
 	out << cHeadless::colorize(QObject::tr("Network render"), cHeadless::ansiBlue) << "\n";
 	out << cHeadless::colorize("mandelbulber2 -n --host 192.168.100.1", cHeadless::ansiYellow)
 			<< cHeadless::colorize(" # (1) client", cHeadless::ansiGreen) << "\n";
@@ -1006,6 +1033,29 @@ void cCommandLineInterface::handleImageFileFormat()
 	}
 }
 
+void cCommandLineInterface::handleTiles()
+{
+	bool checkParse = true;
+	const int tiles = cliData.tilesText.toInt(&checkParse);
+	if (!checkParse || tiles < 1 || tiles > 64)
+	{
+		cErrorMessage::showMessage(QObject::tr("Specified number of tiles not valid\n"
+																					 "need to be between 1 and 64"),
+			cErrorMessage::errorMessage);
+		parser.showHelp(cliErrorTilesInvalid);
+	}
+	gPar->Set("tiles", tiles);
+
+	// JPEG files cannot be written line by line
+	if (cliData.imageFileFormat == "jpg")
+	{
+		cErrorMessage::showMessage(
+			QObject::tr("JPEG format is not supported for tiled rendering, PNG will be used"),
+			cErrorMessage::warningMessage);
+		cliData.imageFileFormat = "png";
+	}
+}
+
 void cCommandLineInterface::handleFlight()
 {
 	if (gAnimFrames->GetNumberOfFrames() > 0)
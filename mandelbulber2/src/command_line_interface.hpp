@@ -66,6 +66,7 @@ public:
 		cliErrorFPKInvalid = -15,
 		cliErrorImageFileFormatInvalid = -16,
 		cliErrorSettingsFileNotSpecified = -17,
+		cliErrorTilesInvalid = -18,
 
 		cliErrorFlightNoFrames = -30,
 		cliErrorFlightStartFrameOutOfRange = -31,
@@ -110,6 +111,7 @@ private:
 	void handleResolution();
 	void handleFpk();
 	void handleImageFileFormat();
+	void handleTiles();
 	void handleFlight();
 	void handleKeyframe();
 	void handleStartFrame();
@@ -141,6 +143,7 @@ private:
 		QString overrideParametersText;
 		QString imageFileFormat;
 		QString resolution;
+		QString tilesText;
 		QString fpkText;
 		QString host;
 		QString portText;
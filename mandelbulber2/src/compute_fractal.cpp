@@ -34,6 +34,7 @@
 
 #include "compute_fractal.hpp"
 
+#include "formula/definition/all_fractal_definitions.h"
 #include "formula/definition/legacy_fractal_transforms.hpp"
 #include "common_math.h"
 #include "fractal.h"
@@ -43,11 +44,97 @@
 
 using namespace fractal;
 
-template <fractal::enumCalculationMode Mode>
-void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out)
+// formula called through the virtual function (any formula)
+struct sFormulaCallVirtual
+{
+	static inline void Call(
+		cAbstractFractal *function, CVector4 &z, const sFractal *fractal, sExtendedAux &aux)
+	{
+		function->FormulaCode(z, fractal, aux);
+	}
+};
+
+// formula called directly (class known at compile time, no virtual dispatch)
+template <class T>
+struct sFormulaCallDirect
+{
+	static inline void Call(
+		cAbstractFractal *function, CVector4 &z, const sFractal *fractal, sExtendedAux &aux)
+	{
+		static_cast<T *>(function)->T::FormulaCode(z, fractal, aux);
+	}
+};
+
+// properties of formula slot used in every iteration
+struct sFormulaSlotData
 {
-	cAbstractFractal *fractalFormulaFunction;
+	const sFractal *fractal;
+	cAbstractFractal *function;
+	enumFractalFormula formula;
+	double bailout;
+	bool checkForBailout;
+	bool additionalBailoutCond;
+	bool addC;
+	CVector4 constantC;
+};
+
+static inline void GetFormulaSlotData(
+	const cNineFractals &fractals, int sequence, const CVector4 &const_c, sFormulaSlotData *slot)
+{
+	slot->fractal = fractals.GetFractal(sequence);
+	slot->formula = slot->fractal->formula;
+	slot->function = fractals.GetFractalFormulaFunction(sequence);
+	slot->bailout = fractals.GetBailout(sequence);
+	slot->checkForBailout = fractals.IsCheckForBailout(sequence);
+	slot->additionalBailoutCond = fractals.UseAdditionalBailoutCond(sequence);
+	slot->addC = fractals.IsAddCConstant(sequence);
+
+	// addition of constant
+	if (slot->addC)
+	{
+		switch (slot->formula)
+		{
+			case aboxMod1:
+			case amazingSurf:
+				// case amazingSurfMod1:
+				{
+					if (fractals.IsJuliaEnabled(sequence))
+					{
+						CVector3 juliaC =
+							fractals.GetJuliaConstant(sequence) * fractals.GetConstantMultiplier(sequence);
+						slot->constantC = CVector4(juliaC.y, juliaC.x, juliaC.z, 0.0);
+					}
+					else
+					{
+						slot->constantC = CVector4(const_c.y, const_c.x, const_c.z, 0.0)
+															* fractals.GetConstantMultiplier(sequence);
+					}
+					break;
+				}
+
+			default:
+			{
+				if (fractals.IsJuliaEnabled(sequence))
+				{
+					slot->constantC = CVector4(
+						fractals.GetJuliaConstant(sequence) * fractals.GetConstantMultiplier(sequence), 0.0);
+				}
+				else
+				{
+					slot->constantC = const_c * fractals.GetConstantMultiplier(sequence);
+				}
+				break;
+			}
+		}
+	}
+}
 
+// main fractal iteration loop
+// singleFormula - only one formula slot is used (not hybrid), so all properties of the slot are
+// read once before the loop
+template <fractal::enumCalculationMode Mode, class FormulaCall, bool singleFormula>
+static void ComputeIterations(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out)
+{
 	// repeat, move and rotate
 	CVector3 pointTransformed = (in.point - in.common->fractalPosition).mod(in.common->repeat);
 	pointTransformed = in.common->mRotFractalRotation.RotateVector(pointTransformed);
@@ -102,7 +189,14 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 
 	// main iteration loop
 	int i;
-	int sequence = 0;
+	int sequence = fractalIndex;
+
+	sFormulaSlotData slot;
+	if (singleFormula)
+	{
+		GetFormulaSlotData(fractals, sequence, extendedAux.const_c, &slot);
+		formula = slot.formula;
+	}
 
 	CVector4 lastGoodZ;
 	CVector4 lastZ;
@@ -117,13 +211,18 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 		lastZ = z;
 
 		// hybrid fractal sequence
-		if (in.forcedFormulaIndex >= 0)
+		if (!singleFormula)
 		{
-			sequence = in.forcedFormulaIndex;
-		}
-		else
-		{
-			sequence = fractals.GetSequence(i);
+			if (in.forcedFormulaIndex >= 0)
+			{
+				sequence = in.forcedFormulaIndex;
+			}
+			else
+			{
+				sequence = fractals.GetSequence(i);
+			}
+			GetFormulaSlotData(fractals, sequence, extendedAux.const_c, &slot);
+			formula = slot.formula;
 		}
 
 		// foldings
@@ -140,8 +239,7 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 			r = z.Length();
 		}
 
-		const sFractal *fractal = fractals.GetFractal(sequence);
-		formula = fractal->formula;
+		const sFractal *fractal = slot.fractal;
 
 		// temporary vector for weight function
 		CVector4 tempZ = z;
@@ -149,18 +247,16 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 		extendedAux.r = r;
 		extendedAux.i = i;
 
-		fractalFormulaFunction = fractals.GetFractalFormulaFunction(sequence);
-
-		if (!fractals.IsHybrid() || fractals.GetWeight(sequence) > 0.0)
+		if (singleFormula || !fractals.IsHybrid() || fractals.GetWeight(sequence) > 0.0)
 		{
 			// -------------- call for fractal formulas by function pointers ---------------
-			if (fractalFormulaFunction && formula != none)
+			if (slot.function && formula != none)
 			{
-				fractalFormulaFunction->FormulaCode(z, fractal, extendedAux);
+				FormulaCall::Call(slot.function, z, fractal, extendedAux);
 			}
 			else
 			{
-				double high = fractals.GetBailout(sequence) * 10.0;
+				double high = slot.bailout * 10.0;
 				z = CVector4(high, high, high, high);
 				out->distance = 10.0;
 				out->iters = 1;
@@ -171,46 +267,9 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 		}
 
 		// addition of constant
-		if (fractals.IsAddCConstant(sequence))
-		{
-			switch (formula)
-			{
-				case aboxMod1:
-				case amazingSurf:
-					// case amazingSurfMod1:
-					{
-						if (fractals.IsJuliaEnabled(sequence))
-						{
-							CVector3 juliaC =
-								fractals.GetJuliaConstant(sequence) * fractals.GetConstantMultiplier(sequence);
-							z += CVector4(juliaC.y, juliaC.x, juliaC.z, 0.0);
-						}
-						else
-						{
-							z +=
-								CVector4(extendedAux.const_c.y, extendedAux.const_c.x, extendedAux.const_c.z, 0.0)
-								* fractals.GetConstantMultiplier(sequence);
-						}
-						break;
-					}
-
-				default:
-				{
-					if (fractals.IsJuliaEnabled(sequence))
-					{
-						z += CVector4(
-							fractals.GetJuliaConstant(sequence) * fractals.GetConstantMultiplier(sequence), 0.0);
-					}
-					else
-					{
-						z += extendedAux.const_c * fractals.GetConstantMultiplier(sequence);
-					}
-					break;
-				}
-			}
-		}
+		if (slot.addC) z += slot.constantC;
 
-		if (fractals.IsHybrid())
+		if (!singleFormula && fractals.IsHybrid())
 		{
 			z = SmoothCVector(tempZ, z, fractals.GetWeight(sequence));
 		}
@@ -229,24 +288,24 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 		}
 
 		// escape conditions
-		if (fractals.IsCheckForBailout(sequence))
+		if (slot.checkForBailout)
 		{
 			if (Mode == calcModeNormal || Mode == calcModeDeltaDE1)
 			{
-				if (r > fractals.GetBailout(sequence))
+				if (r > slot.bailout)
 				{
 					out->maxiter = false;
 					break;
 				}
 
-				if (fractals.UseAdditionalBailoutCond(sequence))
+				if (slot.additionalBailoutCond)
 				{
 					out->maxiter = false; // maxiter flag has to be always disabled for pseudo klienian
-					if ((z - lastZ).Length() / r < 0.1 / fractals.GetBailout(sequence))
+					if ((z - lastZ).Length() / r < 0.1 / slot.bailout)
 					{
 						break;
 					}
-					if ((z - lastLastZ).Length() / r < 0.1 / fractals.GetBailout(sequence))
+					if ((z - lastLastZ).Length() / r < 0.1 / slot.bailout)
 					{
 						break;
 					}
@@ -303,9 +362,9 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 					if (fractal->formula != mandelbox)
 					{
 						if (len < colorMin) colorMin = len;
-						if (r > fractals.GetBailout(sequence)) break;
+						if (r > slot.bailout) break;
 
-						if (fractals.UseAdditionalBailoutCond(sequence) && (z - lastZ).Length() / r < 1e-15)
+						if (slot.additionalBailoutCond && (z - lastZ).Length() / r < 1e-15)
 							break;
 					}
 					else // for Mandelbox. Note in Normal Mode (abox_color) colorMin = 0, else has a value
@@ -317,7 +376,7 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 						else
 						{
 							if (len < colorMin) colorMin = len;
-							if (r > fractals.GetBailout(sequence) || (z - lastZ).Length() / r < 1e-15) break;
+							if (r > slot.bailout || (z - lastZ).Length() / r < 1e-15) break;
 						}
 					}
 				}
@@ -342,7 +401,7 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 
 				if (i >= in.common->fakeLightsMinIter && i <= in.common->fakeLightsMaxIter)
 					orbitTrapTotal += (1.0 / (distance * distance));
-				if (distance > fractals.GetBailout(sequence))
+				if (distance > slot.bailout)
 				{
 					out->orbitTrapR = orbitTrapTotal;
 					break;
@@ -502,6 +561,32 @@ void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *o
 	out->z = z.GetXYZ();
 }
 
+template <fractal::enumCalculationMode Mode>
+void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out)
+{
+	if (!fractals.UseSpecializedCompute())
+	{
+		ComputeIterations<Mode, sFormulaCallVirtual, false>(fractals, in, out);
+		return;
+	}
+
+	// most used formulas are called directly, all other single formulas use virtual call
+	int fractalIndex = (in.forcedFormulaIndex >= 0) ? in.forcedFormulaIndex : 0;
+	switch (fractals.GetFractal(fractalIndex)->formula)
+	{
+		case mandelbulb:
+			ComputeIterations<Mode, sFormulaCallDirect<cFractalMandelbulb>, true>(fractals, in, out);
+			break;
+		case mandelbox:
+			ComputeIterations<Mode, sFormulaCallDirect<cFractalMandelbox>, true>(fractals, in, out);
+			break;
+		case mengerSponge:
+			ComputeIterations<Mode, sFormulaCallDirect<cFractalMengerSponge>, true>(fractals, in, out);
+			break;
+		default: ComputeIterations<Mode, sFormulaCallVirtual, true>(fractals, in, out); break;
+	}
+}
+
 template void Compute<calcModeNormal>(
 	const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out);
 template void Compute<calcModeDeltaDE1>(
@@ -0,0 +1,314 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * CalculateDistancePacket() - distance estimation for a packet of points calculated together
+ */
+
+#include "compute_fractal_packet.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include "common_math.h"
+#include "fractal.h"
+#include "fractparams.hpp"
+#include "material.h"
+#include "nine_fractals.hpp"
+#include "render_data.hpp"
+
+using namespace fractal;
+using namespace std;
+
+// checks if number is NaN or infinity. Bits are tested directly because with -ffast-math
+// the compiler can assume that all numbers are finite
+static inline bool IsNotFinite(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return (bits & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL;
+}
+
+// batched versions of formulas. They have to give the same results as FormulaCode() of
+// cFractalMandelbulb, cFractalMandelbox and cFractalMengerSponge, but without branches which
+// prevent vectorization
+static inline void PacketMandelbulb(
+	const sFractal *fractal, double r, double &x, double &y, double &z, double &DE)
+{
+	const double th0 = asin(z / r) + fractal->bulb.betaAngleOffset;
+	const double ph0 = atan2(y, x) + fractal->bulb.alphaAngleOffset;
+	double rp = pow(r, fractal->bulb.power - 1.0);
+	const double th = th0 * fractal->bulb.power;
+	const double ph = ph0 * fractal->bulb.power;
+	const double cth = cos(th);
+	DE = (rp * DE) * fractal->bulb.power + 1.0;
+	rp *= r;
+	x = cth * cos(ph) * rp;
+	y = cth * sin(ph) * rp;
+	z = sin(th) * rp;
+}
+
+static inline void PacketMandelbox(
+	const sFractal *fractal, double &x, double &y, double &z, double &w, double &DE)
+{
+	const double limit = fractal->mandelbox.foldingLimit;
+	const double value = fractal->mandelbox.foldingValue;
+	x = (fabs(x) > limit) ? (x > 0.0 ? value : -value) - x : x;
+	y = (fabs(y) > limit) ? (y > 0.0 ? value : -value) - y : y;
+	z = (fabs(z) > limit) ? (z > 0.0 ? value : -value) - z : z;
+
+	const double r2 = x * x + y * y + z * z + w * w;
+
+	const CVector4 &offset = fractal->mandelbox.offset;
+	const double factor = (r2 < fractal->mandelbox.mR2)
+													? fractal->mandelbox.mboxFactor1
+													: ((r2 < fractal->mandelbox.fR2) ? fractal->mandelbox.fR2 / r2 : 1.0);
+	x = (x + offset.x) * factor - offset.x;
+	y = (y + offset.y) * factor - offset.y;
+	z = (z + offset.z) * factor - offset.z;
+	w = (w + offset.w) * factor - offset.w;
+	DE *= factor;
+
+	const double scale = fractal->mandelbox.scale;
+	x *= scale;
+	y *= scale;
+	z *= scale;
+	w *= scale;
+	DE = DE * fabs(scale) + 1.0;
+}
+
+static inline void PacketMengerSponge(
+	const sFractal *fractal, double &x, double &y, double &z, double &w, double &DE)
+{
+	x = fabs(x);
+	y = fabs(y);
+	z = fabs(z);
+
+	// sorting of coordinates in descending order (the same as swaps in original formula)
+	const double a = max(x, y);
+	const double b = min(x, y);
+	const double c = min(a, z);
+	x = max(a, z);
+	y = max(b, c);
+	z = min(b, c);
+
+	const double scale = fractal->transformCommon.scale3;
+	x = x * scale - 2.0;
+	y = y * scale - 2.0;
+	z *= scale;
+	w *= scale;
+	z = (z > 1.0) ? z - 2.0 : z;
+
+	DE *= scale;
+}
+
+bool IsPacketDistanceSupported(
+	const sParamRender &params, const cNineFractals &fractals, sRenderData *data)
+{
+	if (params.booleanOperatorsEnabled || params.limitsEnabled || params.interiorMode) return false;
+	if (params.common.iterThreshMode) return false;
+	if (params.common.foldings.boxEnable || params.common.foldings.sphericalEnable) return false;
+	if (params.primitives.IsAnyPrimitive()) return false;
+
+	if (fractals.IsHybrid() || fractals.GetDEType(-1) != analyticDEType) return false;
+	if (!fractals.IsCheckForBailout(0) || fractals.UseAdditionalBailoutCond(0)) return false;
+
+	switch (fractals.GetDEAnalyticFunction(0))
+	{
+		case analyticFunctionLogarithmic:
+		case analyticFunctionLinear:
+		case analyticFunctionIFS: break;
+		default: return false;
+	}
+
+	if (data)
+	{
+		const cMaterial *mat = data->GetObjectMaterial(0);
+		if (mat->displacementTexture.IsLoaded() || mat->textureFractalize) return false;
+	}
+
+	const sFractal *fractal = fractals.GetFractal(0);
+	switch (fractal->formula)
+	{
+		case mandelbulb: return true;
+		case mandelbox:
+			return !fractal->mandelbox.rotationsEnabled && !fractal->mandelbox.mainRotationEnabled;
+		case mengerSponge: return true;
+		default: return false;
+	}
+}
+
+template <enumFractalFormula formula>
+static void ComputePacket(
+	const sParamRender &params, const cNineFractals &fractals, sDistancePacket *packet)
+{
+	const int size = FRACTAL_PACKET_SIZE;
+	const sFractal *fractal = fractals.GetFractal(0);
+	const double bailout = fractals.GetBailout(0);
+
+	double zx[size], zy[size], zz[size], zw[size];
+	double cx[size], cy[size], cz[size], cw[size];
+	double r[size], DE[size];
+	int iters[size];
+	bool running[size];
+
+	// repeat, move and rotate (the same as in Compute())
+	const double initialW = fractals.GetInitialWAxis(0);
+	for (int l = 0; l < size; l++)
+	{
+		CVector3 point(packet->x[l], packet->y[l], packet->z[l]);
+		point = (point - params.common.fractalPosition).mod(params.common.repeat);
+		point = params.common.mRotFractalRotation.RotateVector(point);
+		zx[l] = point.x;
+		zy[l] = point.y;
+		zz[l] = point.z;
+		zw[l] = initialW;
+		r[l] = sqrt(zx[l] * zx[l] + zy[l] * zy[l] + zz[l] * zz[l] + zw[l] * zw[l]);
+		DE[l] = 1.0;
+		iters[l] = 0;
+		running[l] = packet->active[l];
+	}
+
+	// constant added in every iteration
+	const CVector3 multiplier = fractals.GetConstantMultiplier(0);
+	const bool addC = fractals.IsAddCConstant(0);
+	const bool julia = fractals.IsJuliaEnabled(0);
+	const CVector3 juliaC = fractals.GetJuliaConstant(0) * multiplier;
+	for (int l = 0; l < size; l++)
+	{
+		cx[l] = !addC ? 0.0 : (julia ? juliaC.x : zx[l] * multiplier.x);
+		cy[l] = !addC ? 0.0 : (julia ? juliaC.y : zy[l] * multiplier.y);
+		cz[l] = !addC ? 0.0 : (julia ? juliaC.z : zz[l] * multiplier.z);
+		cw[l] = !addC ? 0.0 : (julia ? 0.0 : zw[l]);
+	}
+
+	for (int i = 0; i < params.N; i++)
+	{
+		int numberOfRunning = 0;
+
+#pragma omp simd reduction(+ : numberOfRunning)
+		for (int l = 0; l < size; l++)
+		{
+			double x = zx[l];
+			double y = zy[l];
+			double z = zz[l];
+			double w = zw[l];
+			double newDE = DE[l];
+
+			switch (formula)
+			{
+				case mandelbulb: PacketMandelbulb(fractal, r[l], x, y, z, newDE); break;
+				case mandelbox: PacketMandelbox(fractal, x, y, z, w, newDE); break;
+				case mengerSponge: PacketMengerSponge(fractal, x, y, z, w, newDE); break;
+				default: break;
+			}
+
+			x += cx[l];
+			y += cy[l];
+			z += cz[l];
+			w += cw[l];
+
+			const double newR = sqrt(x * x + y * y + z * z + w * w);
+
+			// dead computation: last good z is kept (as in Compute())
+			const bool notANumber = IsNotFinite(newR);
+			const bool update = running[l] && !notANumber;
+			zx[l] = update ? x : zx[l];
+			zy[l] = update ? y : zy[l];
+			zz[l] = update ? z : zz[l];
+			zw[l] = update ? w : zw[l];
+			r[l] = update ? newR : r[l];
+			DE[l] = running[l] ? newDE : DE[l];
+			iters[l] += running[l] ? 1 : 0;
+			running[l] = running[l] && !notANumber && !(newR > bailout);
+			numberOfRunning += running[l] ? 1 : 0;
+		}
+
+		if (numberOfRunning == 0) break;
+	}
+
+	const enumDEAnalyticFunction DEFunction = fractals.GetDEAnalyticFunction(0);
+	for (int l = 0; l < size; l++)
+	{
+		// Compute() returns maxN + 1 when bailout was not reached
+		if (running[l]) iters[l]++;
+
+		double distance;
+		if (DE[l] > 0.0)
+		{
+			switch (DEFunction)
+			{
+				case analyticFunctionLogarithmic: distance = 0.5 * r[l] * log(r[l]) / DE[l]; break;
+				case analyticFunctionIFS: distance = (r[l] - 2.0) / DE[l]; break;
+				default: distance = r[l] / DE[l]; break;
+			}
+		}
+		else
+		{
+			distance = r[l];
+		}
+
+		packet->distance[l] = distance;
+		packet->iters[l] = iters[l];
+	}
+}
+
+// calculates distances for all active points of the packet. Gives the same results as
+// CalculateDistance() for scenes accepted by IsPacketDistanceSupported()
+void CalculateDistancePacket(
+	const sParamRender &params, const cNineFractals &fractals, sDistancePacket *packet)
+{
+	switch (fractals.GetFractal(0)->formula)
+	{
+		case mandelbulb: ComputePacket<mandelbulb>(params, fractals, packet); break;
+		case mandelbox: ComputePacket<mandelbox>(params, fractals, packet); break;
+		case mengerSponge: ComputePacket<mengerSponge>(params, fractals, packet); break;
+		default: return;
+	}
+
+	// the same corrections as in CalculateDistanceSimple() and CalculateDistance()
+	for (int l = 0; l < FRACTAL_PACKET_SIZE; l++)
+	{
+		double distance = packet->distance[l];
+
+		if (packet->iters[l] < params.minN && distance < packet->detailSize[l])
+			distance = packet->detailSize[l];
+		if (distance < 0.0) distance = 0.0;
+		if (distance > 10.0) distance = 10.0;
+
+		if (CheckNAN(distance)) distance = 0.0;
+
+		CVector3 point(packet->x[l], packet->y[l], packet->z[l]);
+		const double distFromCamera = (point - params.camera).Length();
+		distance = max(distance, params.viewDistanceMin - distFromCamera);
+
+		packet->distance[l] = distance;
+	}
+}
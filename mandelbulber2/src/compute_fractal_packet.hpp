@@ -0,0 +1,73 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * CalculateDistancePacket() - distance estimation for a packet of points calculated together
+ *
+ * Points are stored as structure of arrays, so iteration loops can be vectorized by compiler
+ * (4 lanes for AVX2, 8 lanes for AVX-512). Lanes which reached bailout are masked off.
+ * Only simple scenes with single non-hybrid formula with batched implementation are supported
+ * (see IsPacketDistanceSupported()). Other scenes have to use scalar CalculateDistance().
+ */
+
+#ifndef MANDELBULBER2_SRC_COMPUTE_FRACTAL_PACKET_HPP_
+#define MANDELBULBER2_SRC_COMPUTE_FRACTAL_PACKET_HPP_
+
+#if defined(__AVX512F__)
+#define FRACTAL_PACKET_SIZE 8
+#else
+#define FRACTAL_PACKET_SIZE 4
+#endif
+
+// forward declarations
+struct sParamRender;
+struct sRenderData;
+class cNineFractals;
+
+struct sDistancePacket
+{
+	// input
+	double x[FRACTAL_PACKET_SIZE];
+	double y[FRACTAL_PACKET_SIZE];
+	double z[FRACTAL_PACKET_SIZE];
+	double detailSize[FRACTAL_PACKET_SIZE];
+	bool active[FRACTAL_PACKET_SIZE];
+
+	// output
+	double distance[FRACTAL_PACKET_SIZE];
+	int iters[FRACTAL_PACKET_SIZE];
+};
+
+bool IsPacketDistanceSupported(
+	const sParamRender &params, const cNineFractals &fractals, sRenderData *data);
+void CalculateDistancePacket(
+	const sParamRender &params, const cNineFractals &fractals, sDistancePacket *packet);
+
+#endif /* MANDELBULBER2_SRC_COMPUTE_FRACTAL_PACKET_HPP_ */
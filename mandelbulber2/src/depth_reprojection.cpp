@@ -0,0 +1,192 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cDepthReprojection class - temporal reprojection of the depth buffer for animations
+ */
+
+#include "depth_reprojection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "camera_target.hpp"
+#include "cimage.hpp"
+#include "fractparams.hpp"
+#include "projection_3d.hpp"
+
+cDepthReprojection::cDepthReprojection()
+{
+	previousWidth = 0;
+	previousHeight = 0;
+	width = 0;
+	height = 0;
+	ready = false;
+}
+
+bool cDepthReprojection::IsPossible(const sParamRender *params)
+{
+	// Monte Carlo DOF moves start points of rays, so the depth from the camera is not valid
+	return params->temporalReprojectionEnabled && params->perspectiveType == params::perspThreePoint
+				 && !params->DOFMonteCarlo;
+}
+
+cDepthReprojection::sCamera cDepthReprojection::CameraFromParams(
+	const sParamRender *params, int width, int height)
+{
+	// the same rotation matrix as in cRenderWorker::PrepareMainVectors()
+	sCamera camera;
+	cCameraTarget cameraTarget(params->camera, params->target, params->topVector);
+	CVector3 viewAngle = cameraTarget.GetRotation();
+	camera.mRot.RotateZ(viewAngle.x); // yaw
+	camera.mRot.RotateX(viewAngle.y); // pitch
+	camera.mRot.RotateY(viewAngle.z); // roll
+	camera.mRotInv = camera.mRot.Transpose();
+	camera.position = params->camera;
+	camera.fov = params->fov;
+	camera.aspectRatio = double(width) / height;
+	return camera;
+}
+
+void cDepthReprojection::Clear()
+{
+	previousDepth.clear();
+	startDistance.clear();
+	previousWidth = 0;
+	previousHeight = 0;
+	ready = false;
+}
+
+void cDepthReprojection::StoreFrame(const sParamRender *params, const cImage *image)
+{
+	if (!IsPossible(params))
+	{
+		Clear();
+		return;
+	}
+
+	previousWidth = int(image->GetWidth());
+	previousHeight = int(image->GetHeight());
+	previousCamera = CameraFromParams(params, previousWidth, previousHeight);
+
+	previousDepth.resize(size_t(previousWidth) * previousHeight);
+	for (int y = 0; y < previousHeight; y++)
+	{
+		for (int x = 0; x < previousWidth; x++)
+		{
+			previousDepth[size_t(y) * previousWidth + x] = image->GetPixelZBuffer(x, y);
+		}
+	}
+}
+
+void cDepthReprojection::Prepare(const sParamRender *params, int _width, int _height,
+	const cRegion<int> &screenRegion, const cRegion<double> &imageRegion)
+{
+	ready = false;
+	width = _width;
+	height = _height;
+
+	if (!IsPossible(params) || previousDepth.empty() || previousWidth != width
+			|| previousHeight != height)
+	{
+		startDistance.clear();
+		return;
+	}
+
+	const float noData = std::numeric_limits<float>::max();
+	std::vector<float> reprojectedDepth(size_t(width) * height, noData);
+
+	sCamera camera = CameraFromParams(params, width, height);
+	cRegion<double> screenRegionDouble(
+		screenRegion.x1, screenRegion.y1, screenRegion.x2, screenRegion.y2);
+
+	// forward projection of every point from the previous frame. Each point is written to 2x2
+	// pixels around its new position to avoid holes when the camera moves towards the surface
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			double depth = previousDepth[size_t(y) * width + x];
+			if (depth >= 1e19 || depth <= 0.0) continue; // background
+
+			CVector2<double> imagePoint = screenRegion.transpose(imageRegion, CVector2<int>(x, y));
+			imagePoint.x *= previousCamera.aspectRatio;
+			CVector3 viewVector = CalculateViewVector(
+				imagePoint, previousCamera.fov, params::perspThreePoint, previousCamera.mRot);
+			CVector3 point = previousCamera.position + viewVector * depth;
+
+			CVector3 relativePoint = point - camera.position;
+			CVector3 localPoint = camera.mRotInv.RotateVector(relativePoint);
+			if (localPoint.y <= 0.0) continue; // behind the camera
+
+			CVector2<double> newImagePoint(
+				localPoint.x / localPoint.y / camera.fov / camera.aspectRatio,
+				localPoint.z / localPoint.y / camera.fov);
+			CVector2<double> screenPoint = imageRegion.transpose(screenRegionDouble, newImagePoint);
+
+			float newDepth = float(relativePoint.Length());
+			int sx = int(floor(screenPoint.x));
+			int sy = int(floor(screenPoint.y));
+			for (int yy = sy; yy <= sy + 1; yy++)
+			{
+				if (yy < 0 || yy >= height) continue;
+				for (int xx = sx; xx <= sx + 1; xx++)
+				{
+					if (xx < 0 || xx >= width) continue;
+					float &pixel = reprojectedDepth[size_t(yy) * width + xx];
+					pixel = std::min(pixel, newDepth);
+				}
+			}
+		}
+	}
+
+	// minimum from 3x3 neighborhood compensates for edges of objects moved by sub-pixel offsets
+	double factor = params->temporalReprojectionFactor;
+	startDistance.assign(size_t(width) * height, 0.0f);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			if (reprojectedDepth[size_t(y) * width + x] == noData) continue; // disocclusion
+
+			float minDepth = noData;
+			for (int yy = std::max(y - 1, 0); yy <= std::min(y + 1, height - 1); yy++)
+			{
+				for (int xx = std::max(x - 1, 0); xx <= std::min(x + 1, width - 1); xx++)
+				{
+					minDepth = std::min(minDepth, reprojectedDepth[size_t(yy) * width + xx]);
+				}
+			}
+			startDistance[size_t(y) * width + x] = float(factor * minDepth);
+		}
+	}
+
+	ready = true;
+}
@@ -0,0 +1,97 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cDepthReprojection class - temporal reprojection of the depth buffer for animations
+ *
+ * Z-buffer of the last rendered frame is projected into the camera of the next frame. Primary
+ * rays of the next frame start at a fraction of the reprojected depth (minimum from 3x3
+ * neighborhood) instead of starting at the camera. Pixels which were not visible in the previous
+ * frame (disocclusions, new areas at the image borders) have no reprojected depth and are
+ * ray-marched from the camera. The render worker additionally checks if the start point is not
+ * inside the object. Objects which were entirely outside the previous frame and now appear in
+ * front of visible surfaces can be missed, so the factor should be lower for fast camera motion.
+ */
+
+#ifndef MANDELBULBER2_SRC_DEPTH_REPROJECTION_HPP_
+#define MANDELBULBER2_SRC_DEPTH_REPROJECTION_HPP_
+
+#include <vector>
+
+#include "algebra.hpp"
+#include "region.hpp"
+
+// forward declarations
+struct sParamRender;
+class cImage;
+
+class cDepthReprojection
+{
+public:
+	cDepthReprojection();
+
+	// stores z-buffer of rendered frame together with camera used for rendering
+	void StoreFrame(const sParamRender *params, const cImage *image);
+
+	// reprojects stored z-buffer into camera of the next frame and calculates start distances
+	void Prepare(const sParamRender *params, int width, int height,
+		const cRegion<int> &screenRegion, const cRegion<double> &imageRegion);
+
+	void Clear();
+	bool IsReady() const { return ready; }
+
+	// distance where primary ray can start. 0 if pixel was not visible in the previous frame
+	double GetStartDistance(int x, int y) const { return startDistance[size_t(y) * width + x]; }
+
+	static bool IsPossible(const sParamRender *params);
+
+private:
+	struct sCamera
+	{
+		CVector3 position;
+		CRotationMatrix mRot;
+		CRotationMatrix mRotInv;
+		double fov;
+		double aspectRatio;
+	};
+
+	static sCamera CameraFromParams(const sParamRender *params, int width, int height);
+
+	sCamera previousCamera;
+	std::vector<float> previousDepth;
+	int previousWidth;
+	int previousHeight;
+
+	std::vector<float> startDistance;
+	int width;
+	int height;
+	bool ready;
+};
+
+#endif /* MANDELBULBER2_SRC_DEPTH_REPROJECTION_HPP_ */
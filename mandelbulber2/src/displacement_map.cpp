@@ -45,13 +45,13 @@ double DisplacementMap(
 	double distance = oldDistance;
 	if (data)
 	{
-		const cMaterial *mat = &data->materials[data->objectData[objectId].materialId];
+		const cMaterial *mat = data->GetObjectMaterial(objectId);
 
 		if (mat->displacementTexture.IsLoaded())
 		{
 			CVector2<float> textureCoordinates;
 			textureCoordinates =
-				TextureMapping(point, CVector3(0.0, 0.0, 1.0), data->objectData[objectId], mat)
+				TextureMapping(point, CVector3(0.0, 0.0, 1.0), data->GetObject(objectId), mat)
 				+ CVector2<float>(0.5f, 0.5f);
 			sRGBFloat bump3 = mat->displacementTexture.Pixel(textureCoordinates);
 			double bump = double(bump3.R);
@@ -71,7 +71,7 @@ CVector3 FractalizeTexture(const CVector3 &point, sRenderData *data, const sPara
 	CVector3 pointFractalized = point;
 	if (data)
 	{
-		const cMaterial *mat = &data->materials[data->objectData[objectId].materialId];
+		const cMaterial *mat = data->GetObjectMaterial(objectId);
 		if (mat->textureFractalize)
 		{
 			sFractalIn fractIn(point, 0, params.N, &params.common, forcedFormulaIndex, false, mat);
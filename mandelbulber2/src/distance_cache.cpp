@@ -0,0 +1,182 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cDistanceCache class - sparse cache of distance lower bounds for animations of static scenes
+ */
+
+#include "distance_cache.hpp"
+
+#include <QCryptographicHash>
+#include <QStringList>
+
+#include "fractal_container.hpp"
+#include "parameters.hpp"
+#include "write_log.hpp"
+
+cDistanceCache::cDistanceCache()
+{
+	usedLevels = 0;
+	maxNumberOfCells = 0;
+}
+
+void cDistanceCache::Validate(const QByteArray &signature, int memoryLimit)
+{
+	if (signature != sceneSignature)
+	{
+		if (!cells.empty()) WriteLog("Distance cache: scene changed, cache cleared", 2);
+		cells.clear();
+		usedLevels = 0;
+		sceneSignature = signature;
+	}
+	maxNumberOfCells = size_t(memoryLimit) * 1024 * 1024 / bytesPerCell;
+}
+
+int cDistanceCache::CellLevel(double distance)
+{
+	// diagonal of the cell is not bigger than 1/4 of the distance
+	return int(floor(log2(distance / (4.0 * sqrt(3.0)))));
+}
+
+cDistanceCache::sCellKey cDistanceCache::CellKey(const CVector3 &point, int level)
+{
+	const double scale = ldexp(1.0, -level);
+	return sCellKey{level, qint64(floor(point.x * scale)), qint64(floor(point.y * scale)),
+		qint64(floor(point.z * scale))};
+}
+
+double cDistanceCache::LowerBound(const CVector3 &point, double expectedDistance) const
+{
+	if (usedLevels == 0) return 0.0;
+
+	int firstLevel = maxLevel;
+	int lastLevel = minLevel;
+	if (expectedDistance > 0.0)
+	{
+		// cells created for distances from 1/4 to 4 times bigger than expected one
+		int level = CellLevel(expectedDistance);
+		firstLevel = qMin(level + 2, maxLevel);
+		lastLevel = qMax(level - 2, minLevel);
+	}
+
+	// the biggest cells give the longest steps, so they are checked first
+	for (int level = firstLevel; level >= lastLevel; level--)
+	{
+		if (!(usedLevels & (1ULL << (level - minLevel)))) continue;
+
+		tCellMap::const_iterator it = cells.find(CellKey(point, level));
+		if (it != cells.end()) return double(it->second);
+	}
+	return 0.0;
+}
+
+void cDistanceCache::AddDistance(
+	const CVector3 &point, double distance, tCellMap *newCells) const
+{
+	if (cells.size() + newCells->size() >= maxNumberOfCells) return;
+
+	int level = CellLevel(distance);
+	if (level < minLevel || level > maxLevel) return;
+
+	// coordinates too big for the cell size can't be indexed
+	const double scale = ldexp(1.0, -level);
+	const double limit = 1e18;
+	if (fabs(point.x * scale) > limit || fabs(point.y * scale) > limit
+			|| fabs(point.z * scale) > limit)
+		return;
+
+	// the bound is valid for every point of the cell
+	float bound = float((distance - CellSize(level) * sqrt(3.0)) * 0.999);
+
+	float &cellBound = (*newCells)[CellKey(point, level)];
+	if (bound > cellBound) cellBound = bound;
+}
+
+void cDistanceCache::Merge(tCellMap *newCells)
+{
+	for (const auto &newCell : *newCells)
+	{
+		tCellMap::iterator it = cells.find(newCell.first);
+		if (it != cells.end())
+		{
+			if (newCell.second > it->second) it->second = newCell.second;
+		}
+		else if (cells.size() < maxNumberOfCells)
+		{
+			cells.insert(newCell);
+			usedLevels |= 1ULL << (newCell.first.level - minLevel);
+		}
+	}
+	newCells->clear();
+}
+
+QByteArray cDistanceCache::SceneSignature(
+	const cParameterContainer *params, const cFractalContainer *fractals)
+{
+	// parameters of camera and animation are changed in every frame of flight animation, but they
+	// don't change distance estimation
+	const QStringList ignoredPrefixes = {"camera", "target", "fov", "frame_no", "flight_", "anim_",
+		"keyframe_", "distance_cache_"};
+
+	QString text;
+	bool waterPrimitive = false;
+	QList<QString> listOfParameters = params->GetListOfParameters();
+	for (const QString &parameterName : listOfParameters)
+	{
+		if (parameterName.startsWith("primitive_water_")) waterPrimitive = true;
+		if (params->GetParameterType(parameterName) != paramStandard) continue;
+
+		bool ignored = false;
+		for (const QString &prefix : ignoredPrefixes)
+		{
+			if (parameterName.startsWith(prefix)) ignored = true;
+		}
+		if (ignored) continue;
+
+		text += parameterName + "=" + params->Get<QString>(parameterName) + "\n";
+	}
+
+	// waves of water primitive are animated, so its distance changes in every frame
+	if (waterPrimitive) text += "frame_no=" + params->Get<QString>("frame_no") + "\n";
+
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		const cParameterContainer &fractal = fractals->at(i);
+		listOfParameters = fractal.GetListOfParameters();
+		for (const QString &parameterName : listOfParameters)
+		{
+			text += QString::number(i) + parameterName + "=" + fractal.Get<QString>(parameterName) + "\n";
+		}
+	}
+
+	QCryptographicHash hashCrypt(QCryptographicHash::Md4);
+	hashCrypt.addData(text.toLocal8Bit());
+	return hashCrypt.result();
+}
@@ -0,0 +1,128 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cDistanceCache class - sparse cache of distance lower bounds for animations of static scenes
+ *
+ * Space is divided into cubic cells of sizes 2^level. When distance d is estimated at some
+ * point, the cell with size about d/7 containing this point gets lower bound d - cell diagonal,
+ * which is valid for every point of the cell. Ray-marching uses the bounds to step through empty
+ * space without distance estimation. Cells are collected by render workers and merged into the
+ * cache between rendering passes, so the cache is read-only while workers are running. The cache
+ * is kept in sRenderData between frames of the animation and cleared when any parameter which
+ * can change the scene (other than the camera) is changed.
+ */
+
+#ifndef MANDELBULBER2_SRC_DISTANCE_CACHE_HPP_
+#define MANDELBULBER2_SRC_DISTANCE_CACHE_HPP_
+
+#include <cmath>
+#include <unordered_map>
+
+#include <QByteArray>
+
+#include "algebra.hpp"
+
+// forward declarations
+class cParameterContainer;
+class cFractalContainer;
+
+class cDistanceCache
+{
+public:
+	struct sCellKey
+	{
+		int level;
+		qint64 x;
+		qint64 y;
+		qint64 z;
+
+		bool operator==(const sCellKey &other) const
+		{
+			return level == other.level && x == other.x && y == other.y && z == other.z;
+		}
+	};
+
+	struct sCellKeyHash
+	{
+		size_t operator()(const sCellKey &key) const
+		{
+			size_t hash = size_t(key.level) * 0x9e3779b97f4a7c15ULL;
+			hash ^= size_t(key.x) * 0xbf58476d1ce4e5b9ULL;
+			hash ^= size_t(key.y) * 0x94d049bb133111ebULL;
+			hash ^= size_t(key.z) * 0xd6e8feb86659fd93ULL;
+			return hash ^ (hash >> 29);
+		}
+	};
+
+	// cells with lower bounds of distance
+	typedef std::unordered_map<sCellKey, float, sCellKeyHash> tCellMap;
+
+	cDistanceCache();
+
+	// clears the cache when the scene has changed. Memory limit is given in MB
+	void Validate(const QByteArray &signature, int memoryLimit);
+
+	// returns lower bound of distance at the point or 0 if there is nothing in the cache. Search is
+	// limited to the cells fitting to the expected distance (if it's known, i.e. > 0)
+	double LowerBound(const CVector3 &point, double expectedDistance) const;
+
+	// adds cell for distance estimated at the point to the map of new cells of one worker. New cells
+	// are not added when the cache together with the map would exceed the memory limit
+	void AddDistance(const CVector3 &point, double distance, tCellMap *newCells) const;
+
+	// moves new cells collected by a worker to the cache (only when no worker is running)
+	void Merge(tCellMap *newCells);
+
+	bool IsEmpty() const { return cells.empty(); }
+	size_t GetNumberOfCells() const { return cells.size(); }
+
+	// hash of all parameters which can change distance estimation
+	static QByteArray SceneSignature(
+		const cParameterContainer *params, const cFractalContainer *fractals);
+
+private:
+	static int CellLevel(double distance);
+	static double CellSize(int level) { return ldexp(1.0, level); }
+	static sCellKey CellKey(const CVector3 &point, int level);
+
+	tCellMap cells;
+	// bit (level - minLevel) is set if there is any cell of the level
+	quint64 usedLevels;
+	size_t maxNumberOfCells;
+	QByteArray sceneSignature;
+
+	static const int minLevel = -40;
+	static const int maxLevel = 23;
+	// approximated memory used by one cell in the hash map
+	static const int bytesPerCell = 64;
+};
+
+#endif /* MANDELBULBER2_SRC_DISTANCE_CACHE_HPP_ */
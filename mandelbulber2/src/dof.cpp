@@ -35,9 +35,11 @@
 #include "dof.hpp"
 
 #include <algorithm>
+#include <vector>
 
 #include "common_math.h"
 #include "global_data.hpp"
+#include "post_effect_hdr_blur.h"
 #include "progress_text.hpp"
 #include "system_data.hpp"
 
@@ -362,6 +364,174 @@ void cPostRenderingDOF::Render(cRegion<int> screenRegion, float deep, float neut
 	}
 }
 
+// Depth of field rendered as a stack of layers with constant blur radius. Every pixel is split
+// between two neighbouring layers (by its blur radius), each layer is blurred with separable box
+// blurs (premultiplied by the layer weight) and the layers are composited from back to front.
+void cPostRenderingDOF::RenderLayered(
+	cRegion<int> screenRegion, float deep, float neutral, float maxRadius, bool *stopRequest)
+{
+	const int width = screenRegion.width;
+	const int height = screenRegion.height;
+	const qint64 numberOfPixels = qint64(width) * height;
+
+	QString statusText = QObject::tr("Rendering Depth Of Field effect - layers");
+	cProgressText progressText;
+	progressText.ResetTimer();
+
+	emit updateProgressAndStatus(statusText, progressText.getText(0.0), 0.0);
+	gApplication->processEvents();
+
+	// signed blur radius: positive behind the focus plane, negative in front of it
+	std::vector<float> blurRadius(numberOfPixels);
+
+#pragma omp parallel for
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float z = image->GetPixelZBuffer(x + screenRegion.x1, y + screenRegion.y1);
+			float blur = 0.0f;
+			if (z >= 1e-14f)
+			{
+				blur = (z - neutral) / z * deep;
+				blur = clamp(blur, -maxRadius, maxRadius);
+			}
+			blurRadius[x + qint64(y) * width] = blur;
+		}
+	}
+
+	float maxBlur = 0.0f;
+	for (qint64 i = 0; i < numberOfPixels; i++)
+		maxBlur = max(maxBlur, fabsf(blurRadius[i]));
+
+	if (maxBlur < 0.5f)
+	{
+		emit updateProgressAndStatus(statusText, progressText.getText(1.0), 1.0);
+		return;
+	}
+
+	// layers are placed not more than 2 pixels of blur radius apart
+	int layersPerSide = int(ceilf(maxBlur / 2.0f));
+	if (layersPerSide > maxLayersPerSide) layersPerSide = maxLayersPerSide;
+	const float layerStep = maxBlur / layersPerSide;
+	const int numberOfLayers = 2 * layersPerSide + 1;
+
+	std::vector<bool> layerUsed(numberOfLayers, false);
+	for (qint64 i = 0; i < numberOfPixels; i++)
+	{
+		int layer = int(floorf(blurRadius[i] / layerStep)) + layersPerSide;
+		layerUsed[clamp(layer, 0, numberOfLayers - 1)] = true;
+		layerUsed[clamp(layer + 1, 0, numberOfLayers - 1)] = true;
+	}
+
+	// composited R, G, B, alpha (premultiplied) and coverage
+	std::vector<float> accumulated(5 * numberOfPixels, 0.0f);
+	std::vector<float> coverage(numberOfPixels);
+	std::vector<float> channel(numberOfPixels);
+	std::vector<float> buffer(numberOfPixels);
+
+	try
+	{
+		for (int layer = layersPerSide; layer >= -layersPerSide; layer--)
+		{
+			if (!layerUsed[layer + layersPerSide]) continue;
+
+			QVector<int> boxRadii;
+			if (layer != 0)
+			{
+				// standard deviation of uniform disc is radius / 2
+				boxRadii = cPostEffectHdrBlur::BoxRadiiForGaussian(abs(layer) * layerStep * 0.5);
+			}
+
+			// channel 4 is the weight of the layer, channels 0-3 are color and alpha multiplied by it
+			for (int c = 4; c >= 0; c--)
+			{
+				if (*stopRequest || systemData.globalStopRequest) throw tr("DOF terminated");
+
+				float *layerChannel = (c == 4) ? coverage.data() : channel.data();
+
+#pragma omp parallel for
+				for (int y = 0; y < height; y++)
+				{
+					for (int x = 0; x < width; x++)
+					{
+						qint64 i = x + qint64(y) * width;
+						float weight = 1.0f - fabsf(blurRadius[i] / layerStep - layer);
+						float value = 0.0f;
+						if (weight > 0.0f)
+						{
+							int xx = x + screenRegion.x1;
+							int yy = y + screenRegion.y1;
+							switch (c)
+							{
+								case 0: value = image->GetPixelPostImage(xx, yy).R; break;
+								case 1: value = image->GetPixelPostImage(xx, yy).G; break;
+								case 2: value = image->GetPixelPostImage(xx, yy).B; break;
+								case 3: value = image->GetPixelAlpha(xx, yy) / 65535.0f; break;
+								default: value = 1.0f; break;
+							}
+							value *= weight;
+						}
+						layerChannel[i] = value;
+					}
+				}
+
+				for (int boxRadius : boxRadii)
+				{
+					cPostEffectHdrBlur::BoxBlurRows(layerChannel, buffer.data(), width, height, boxRadius);
+					cPostEffectHdrBlur::BoxBlurColumns(
+						buffer.data(), layerChannel, width, height, boxRadius);
+				}
+
+				// "over" operator with the layers which are behind
+				float *target = &accumulated[c * numberOfPixels];
+#pragma omp parallel for
+				for (qint64 i = 0; i < numberOfPixels; i++)
+				{
+					float opacity = clamp(coverage[i], 0.0f, 1.0f);
+					target[i] = layerChannel[i] + (1.0f - opacity) * target[i];
+				}
+			}
+
+			double percentDone = double(layersPerSide - layer + 1) / numberOfLayers;
+			emit updateProgressAndStatus(statusText, progressText.getText(percentDone), percentDone);
+			gApplication->processEvents();
+		}
+
+		// normalization by coverage removes dark borders of layers
+#pragma omp parallel for
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				qint64 i = x + qint64(y) * width;
+				float totalCoverage = accumulated[4 * numberOfPixels + i];
+				if (totalCoverage < 1e-6f) continue;
+				sRGBFloat pixel(accumulated[i] / totalCoverage,
+					accumulated[numberOfPixels + i] / totalCoverage,
+					accumulated[2 * numberOfPixels + i] / totalCoverage);
+				float alpha = clamp(accumulated[3 * numberOfPixels + i] / totalCoverage, 0.0f, 1.0f);
+				image->PutPixelPostImage(x + screenRegion.x1, y + screenRegion.y1, pixel);
+				image->PutPixelAlpha(x + screenRegion.x1, y + screenRegion.y1, quint16(alpha * 65535.0f));
+			}
+		}
+
+		image->CompileImage();
+		if (image->IsPreview())
+		{
+			image->ConvertTo8bit();
+			image->UpdatePreview();
+			emit updateImage();
+		}
+
+		throw progressText.getText(1.0);
+	}
+	catch (QString &status)
+	{
+		emit updateProgressAndStatus(statusText, status, 1.0);
+	}
+}
+
 template <class T>
 void cPostRenderingDOF::QuickSortZBuffer(sSortZ<T> *buffer, quint64 l, quint64 r)
 {
@@ -53,11 +53,18 @@ public:
 
 	void Render(cRegion<int> screenRegion, float deep, float neutral, int numberOfPasses,
 		float blurOpacity, float maxRadius, bool *stopRequest);
+	// alternative algorithm with rendering time which doesn't depend on the blur radius
+	void RenderLayered(
+		cRegion<int> screenRegion, float deep, float neutral, float maxRadius, bool *stopRequest);
 	template <class T>
 	static void QuickSortZBuffer(sSortZ<T> *buffer, quint64 l, quint64 p);
 
 	cImage *image;
 
+private:
+	// maximum number of blur layers on each side of the focus plane
+	static const int maxLayersPerSide = 8;
+
 signals:
 	void updateProgressAndStatus(const QString &text, const QString &progressText, double progress);
 	void updateImage();
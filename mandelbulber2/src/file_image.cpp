@@ -130,6 +130,7 @@ QString ImageFileSave::ImageChannelName(enumImageContentType imageContentType)
 		case IMAGE_CONTENT_NORMAL_WORLD: return "normalWorld";
 		case IMAGE_CONTENT_SPECULAR: return "specular";
 		case IMAGE_CONTENT_DIFFUSE: return "diffuse";
+		case IMAGE_CONTENT_SAMPLE_COUNT: return "sampleCount";
 		case IMAGE_CONTENT_WORLD_POSITION: return "world";
 	}
 	return "";
@@ -138,7 +139,8 @@ QString ImageFileSave::ImageChannelName(enumImageContentType imageContentType)
 QStringList ImageFileSave::ImageChannelNames()
 {
 	return QStringList(
-		{"color", "alpha", "zbuffer", "normal", "specular", "diffuse", "world", "normalWorld"});
+		{"color", "alpha", "zbuffer", "normal", "specular", "diffuse", "world", "normalWorld",
+		"sampleCount"});
 }
 
 ImageFileSave::enumImageFileType ImageFileSave::ImageFileType(QString imageFileExtension)
@@ -276,6 +278,7 @@ QStringList ImageFileSavePNG::SaveImage()
 			case IMAGE_CONTENT_NORMAL_WORLD:
 			case IMAGE_CONTENT_SPECULAR:
 			case IMAGE_CONTENT_DIFFUSE:
+			case IMAGE_CONTENT_SAMPLE_COUNT:
 			case IMAGE_CONTENT_WORLD_POSITION:
 			default:
 			{
@@ -383,6 +386,7 @@ QStringList ImageFileSaveJPG::SaveImage()
 			case IMAGE_CONTENT_NORMAL_WORLD:
 			case IMAGE_CONTENT_SPECULAR:
 			case IMAGE_CONTENT_DIFFUSE:
+			case IMAGE_CONTENT_SAMPLE_COUNT:
 			case IMAGE_CONTENT_WORLD_POSITION:
 				SaveJPEGQt32(fullFilename, channel.value(), int(image->GetWidth()), int(image->GetHeight()),
 					gPar->Get<int>("jpeg_quality"), image->getMeta());
@@ -433,6 +437,7 @@ QStringList ImageFileSaveTIFF::SaveImage()
 			case IMAGE_CONTENT_NORMAL_WORLD:
 			case IMAGE_CONTENT_SPECULAR:
 			case IMAGE_CONTENT_DIFFUSE:
+			case IMAGE_CONTENT_SAMPLE_COUNT:
 			case IMAGE_CONTENT_WORLD_POSITION:
 			default: SaveTIFF(fullFilename, image, channel.value()); break;
 		}
@@ -521,6 +526,7 @@ void ImageFileSavePNG::SavePNG(
 			case IMAGE_CONTENT_NORMAL_WORLD: colorType = PNG_COLOR_TYPE_RGB; break;
 			case IMAGE_CONTENT_SPECULAR: colorType = PNG_COLOR_TYPE_RGB; break;
 			case IMAGE_CONTENT_DIFFUSE: colorType = PNG_COLOR_TYPE_RGB; break;
+			case IMAGE_CONTENT_SAMPLE_COUNT: colorType = PNG_COLOR_TYPE_RGB; break;
 			case IMAGE_CONTENT_WORLD_POSITION: colorType = PNG_COLOR_TYPE_RGB; break;
 			default: colorType = PNG_COLOR_TYPE_RGB; break;
 		}
@@ -547,6 +553,7 @@ void ImageFileSavePNG::SavePNG(
 			case IMAGE_CONTENT_NORMAL_WORLD: pixelSize *= 3; break;
 			case IMAGE_CONTENT_SPECULAR: pixelSize *= 3; break;
 			case IMAGE_CONTENT_DIFFUSE: pixelSize *= 3; break;
+			case IMAGE_CONTENT_SAMPLE_COUNT: pixelSize *= 3; break;
 			case IMAGE_CONTENT_WORLD_POSITION: pixelSize *= 3; break;
 		}
 
@@ -588,6 +595,7 @@ void ImageFileSavePNG::SavePNG(
 				case IMAGE_CONTENT_NORMAL_WORLD:
 				case IMAGE_CONTENT_SPECULAR:
 				case IMAGE_CONTENT_DIFFUSE:
+				case IMAGE_CONTENT_SAMPLE_COUNT:
 				case IMAGE_CONTENT_WORLD_POSITION:
 					// zbuffer and normals are float, so direct buffer write is not applicable
 					break;
@@ -728,6 +736,10 @@ void ImageFileSavePNG::SavePNG(
 						case IMAGE_CONTENT_DIFFUSE:
 							SavePngRgbPixel(imageChannel, &colorPtr[ptr], image->GetPixelDiffuse(x, y), false);
 							break;
+						case IMAGE_CONTENT_SAMPLE_COUNT:
+							SavePngRgbPixel(
+								imageChannel, &colorPtr[ptr], image->GetPixelSampleCount(x, y), false);
+							break;
 						case IMAGE_CONTENT_WORLD_POSITION:
 							SavePngRgbPixel(imageChannel, &colorPtr[ptr], image->GetPixelWorld(x, y), false);
 							break;
@@ -1080,6 +1092,7 @@ bool ImageFileSaveJPG::SaveJPEGQt32(QString filename, structSaveImageChannel ima
 				case IMAGE_CONTENT_NORMAL_WORLD: pixel = image->GetPixelNormalWorld(x, y); break;
 				case IMAGE_CONTENT_SPECULAR: pixel = image->GetPixelSpecular(x, y); break;
 				case IMAGE_CONTENT_DIFFUSE: pixel = image->GetPixelDiffuse(x, y); break;
+				case IMAGE_CONTENT_SAMPLE_COUNT: pixel = image->GetPixelSampleCount(x, y); break;
 				case IMAGE_CONTENT_WORLD_POSITION: pixel = image->GetPixelWorld(x, y); break;
 				default: pixel = sRGBAfloat();
 			}
@@ -1374,6 +1387,12 @@ void ImageFileSaveEXR::SaveEXR(
 			&header, &frameBuffer, width, height);
 	}
 
+	if (imageConfig.contains(IMAGE_CONTENT_SAMPLE_COUNT))
+	{
+		SaveExrRgbChannel(QStringList{"sc.R", "sc.G", "sc.B"}, imageConfig[IMAGE_CONTENT_SAMPLE_COUNT],
+			&header, &frameBuffer, width, height);
+	}
+
 	// insert meta data
 	QMapIterator<QString, QString> i(image->getMeta());
 	while (i.hasNext())
@@ -1427,6 +1446,7 @@ void ImageFileSaveEXR::SaveExrRgbChannel(QStringList names, structSaveImageChann
 				case IMAGE_CONTENT_NORMAL_WORLD: pixel = image->GetPixelNormalWorld(x, y); break;
 				case IMAGE_CONTENT_SPECULAR: pixel = image->GetPixelSpecular(x, y); break;
 				case IMAGE_CONTENT_DIFFUSE: pixel = image->GetPixelDiffuse(x, y); break;
+				case IMAGE_CONTENT_SAMPLE_COUNT: pixel = image->GetPixelSampleCount(x, y); break;
 				case IMAGE_CONTENT_WORLD_POSITION: pixel = image->GetPixelWorld(x, y); break;
 				default: pixel = sRGBFloat();
 			}
@@ -1500,6 +1520,7 @@ bool ImageFileSaveTIFF::SaveTIFF(
 		case IMAGE_CONTENT_NORMAL_WORLD: colorType = PHOTOMETRIC_RGB; break;
 		case IMAGE_CONTENT_SPECULAR: colorType = PHOTOMETRIC_RGB; break;
 		case IMAGE_CONTENT_DIFFUSE: colorType = PHOTOMETRIC_RGB; break;
+		case IMAGE_CONTENT_SAMPLE_COUNT: colorType = PHOTOMETRIC_RGB; break;
 		case IMAGE_CONTENT_WORLD_POSITION: colorType = PHOTOMETRIC_RGB; break;
 		default: colorType = PHOTOMETRIC_RGB; break;
 	}
@@ -1514,6 +1535,7 @@ bool ImageFileSaveTIFF::SaveTIFF(
 		case IMAGE_CONTENT_NORMAL_WORLD: samplesPerPixel = 3; break;
 		case IMAGE_CONTENT_SPECULAR: samplesPerPixel = 3; break;
 		case IMAGE_CONTENT_DIFFUSE: samplesPerPixel = 3; break;
+		case IMAGE_CONTENT_SAMPLE_COUNT: samplesPerPixel = 3; break;
 		case IMAGE_CONTENT_WORLD_POSITION: samplesPerPixel = 3; break;
 	}
 
@@ -1720,6 +1742,9 @@ bool ImageFileSaveTIFF::SaveTIFF(
 				case IMAGE_CONTENT_DIFFUSE:
 					SaveTiffRgbPixel(imageChannel, &colorPtr[ptr], image->GetPixelDiffuse(x, y));
 					break;
+				case IMAGE_CONTENT_SAMPLE_COUNT:
+					SaveTiffRgbPixel(imageChannel, &colorPtr[ptr], image->GetPixelSampleCount(x, y));
+					break;
 				case IMAGE_CONTENT_WORLD_POSITION:
 					SaveTiffRgbPixel(imageChannel, &colorPtr[ptr], image->GetPixelWorld(x, y));
 					break;
@@ -100,7 +100,10 @@ public:
 
 		IMAGE_CONTENT_WORLD_POSITION = 6,
 
-		IMAGE_CONTENT_NORMAL_WORLD = 7
+		IMAGE_CONTENT_NORMAL_WORLD = 7,
+
+		// number of Monte Carlo samples used per pixel, normalized to the sample limit
+		IMAGE_CONTENT_SAMPLE_COUNT = 8
 	};
 
 	enum enumImageChannelQualityType
@@ -0,0 +1,457 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * ImageFileStream class - image files written tile by tile
+ */
+
+#include "file_image_stream.hpp"
+
+#include <exception>
+
+// custom includes
+#ifdef USE_EXR
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfTileDescription.h>
+#endif // USE_EXR
+
+#include <QDebug>
+
+#include "cimage.hpp"
+#include "color_structures.hpp"
+#include "initparameters.hpp"
+#include "parameters.hpp"
+
+ImageFileStream *ImageFileStream::create(QString filename,
+	ImageFileSave::enumImageFileType fileType, int width, int height, int tileWidth, int tileHeight,
+	ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha)
+{
+	switch (fileType)
+	{
+		case ImageFileSave::IMAGE_FILE_TYPE_PNG:
+			return new ImageFileStreamPNG(
+				filename, width, height, tileWidth, tileHeight, quality, appendAlpha);
+#ifdef USE_TIFF
+		case ImageFileSave::IMAGE_FILE_TYPE_TIFF:
+			return new ImageFileStreamTIFF(
+				filename, width, height, tileWidth, tileHeight, quality, appendAlpha);
+#endif /* USE_TIFF */
+#ifdef USE_EXR
+		case ImageFileSave::IMAGE_FILE_TYPE_EXR:
+			return new ImageFileStreamEXR(
+				filename, width, height, tileWidth, tileHeight, quality, appendAlpha);
+#endif /* USE_EXR */
+		default: break;
+	}
+	qCritical() << "fileType " << ImageFileSave::ImageFileExtension(fileType)
+							<< " cannot be written in tiles!";
+	return nullptr;
+}
+
+ImageFileStream::ImageFileStream(QString filename, int width, int height, int tileWidth,
+	int tileHeight, ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha)
+{
+	this->filename = filename;
+	this->width = width;
+	this->height = height;
+	this->tileWidth = qMax(tileWidth, 1);
+	this->tileHeight = qMax(tileHeight, 1);
+	this->quality = quality;
+	this->appendAlpha = appendAlpha;
+
+	int bytesPerSample;
+	switch (quality)
+	{
+		case ImageFileSave::IMAGE_CHANNEL_QUALITY_8: bytesPerSample = 1; break;
+		case ImageFileSave::IMAGE_CHANNEL_QUALITY_16: bytesPerSample = 2; break;
+		default: bytesPerSample = 4; break;
+	}
+	pixelSize = quint64(bytesPerSample) * (appendAlpha ? 4 : 3);
+}
+
+void ImageFileStream::CopyTile(cImage *image, int imageX, int imageY, int copyWidth,
+	int copyHeight, char *buffer, int bufferWidth) const
+{
+	PrepareImage(image);
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int y = 0; y < copyHeight; y++)
+	{
+		char *output = buffer + quint64(y) * quint64(bufferWidth) * pixelSize;
+		for (int x = 0; x < copyWidth; x++)
+		{
+			PutPixel(image, quint64(imageX + x), quint64(imageY + y), output + x * pixelSize);
+		}
+	}
+}
+
+void ImageFileStream::PrepareImage(cImage *image) const
+{
+	if (quality == ImageFileSave::IMAGE_CHANNEL_QUALITY_8)
+	{
+		image->ConvertTo8bit();
+		if (appendAlpha) image->ConvertAlphaTo8bit();
+	}
+}
+
+// the same pixel values as saved by ImageFileSavePNG and ImageFileSaveTIFF
+void ImageFileStream::PutPixel(const cImage *image, quint64 x, quint64 y, char *output) const
+{
+	switch (quality)
+	{
+		case ImageFileSave::IMAGE_CHANNEL_QUALITY_8:
+		{
+			if (appendAlpha)
+			{
+				sRGBA8 *typedOutput = reinterpret_cast<sRGBA8 *>(output);
+				*typedOutput = sRGBA8(image->GetPixelImage8(x, y));
+				typedOutput->A = image->GetPixelAlpha8(x, y);
+			}
+			else
+			{
+				*reinterpret_cast<sRGB8 *>(output) = image->GetPixelImage8(x, y);
+			}
+			break;
+		}
+		case ImageFileSave::IMAGE_CHANNEL_QUALITY_16:
+		{
+			if (appendAlpha)
+			{
+				sRGBA16 *typedOutput = reinterpret_cast<sRGBA16 *>(output);
+				*typedOutput = sRGBA16(image->GetPixelImage16(x, y));
+				typedOutput->A = image->GetPixelAlpha(x, y);
+			}
+			else
+			{
+				*reinterpret_cast<sRGB16 *>(output) = image->GetPixelImage16(x, y);
+			}
+			break;
+		}
+		default:
+		{
+			sRGB16 pixel = image->GetPixelImage16(x, y);
+			float *typedOutput = reinterpret_cast<float *>(output);
+			typedOutput[0] = pixel.R / 65536.0f;
+			typedOutput[1] = pixel.G / 65536.0f;
+			typedOutput[2] = pixel.B / 65536.0f;
+			if (appendAlpha) typedOutput[3] = image->GetPixelAlpha(x, y) / 65536.0f;
+			break;
+		}
+	}
+}
+
+ImageFileStreamPNG::ImageFileStreamPNG(QString filename, int width, int height, int tileWidth,
+	int tileHeight, ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha)
+		: ImageFileStream(filename, width, height, tileWidth, tileHeight,
+				// for PNG no more than 16 bit per channel possible
+				quality == ImageFileSave::IMAGE_CHANNEL_QUALITY_32 ? ImageFileSave::IMAGE_CHANNEL_QUALITY_16
+																													 : quality,
+				appendAlpha)
+{
+	file = nullptr;
+	pngPtr = nullptr;
+	infoPtr = nullptr;
+	writtenLines = 0;
+}
+
+ImageFileStreamPNG::~ImageFileStreamPNG()
+{
+	Close();
+}
+
+bool ImageFileStreamPNG::Open()
+{
+	file = fopen(filename.toLocal8Bit().constData(), "wb");
+	if (!file)
+	{
+		qCritical() << "ImageFileStreamPNG::Open(): cannot open file" << filename;
+		return false;
+	}
+
+	pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!pngPtr) return false;
+	infoPtr = png_create_info_struct(pngPtr);
+	if (!infoPtr) return false;
+
+	if (setjmp(png_jmpbuf(pngPtr)))
+	{
+		qCritical() << "ImageFileStreamPNG::Open(): error during writing header";
+		return false;
+	}
+
+	png_init_io(pngPtr, file);
+	int bitDepth = (quality == ImageFileSave::IMAGE_CHANNEL_QUALITY_8) ? 8 : 16;
+	png_set_IHDR(pngPtr, infoPtr, png_uint_32(width), png_uint_32(height), bitDepth,
+		appendAlpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+	png_write_info(pngPtr, infoPtr);
+	png_set_swap(pngPtr);
+	return true;
+}
+
+bool ImageFileStreamPNG::WriteTile(cImage *image, int imageX, int imageY, int frameX, int frameY)
+{
+	// PNG is written line by line, so tiles are collected in the band of the whole row of tiles
+	const int copyWidth = qMin(tileWidth, width - frameX);
+	const int bandHeight = qMin(tileHeight, height - frameY);
+	quint64 bandSize = quint64(bandHeight) * quint64(width) * pixelSize;
+	if (buffer.size() < bandSize) buffer.resize(bandSize);
+
+	CopyTile(image, imageX, imageY, copyWidth, bandHeight, &buffer[quint64(frameX) * pixelSize],
+		width);
+
+	// lines are written when the last tile of the row is ready
+	if (frameX + copyWidth < width) return true;
+
+	if (setjmp(png_jmpbuf(pngPtr)))
+	{
+		qCritical() << "ImageFileStreamPNG::WriteTile(): error during writing bytes";
+		return false;
+	}
+
+	for (int y = 0; y < bandHeight; y++)
+	{
+		png_write_row(pngPtr, reinterpret_cast<png_bytep>(&buffer[quint64(y) * width * pixelSize]));
+	}
+	writtenLines += bandHeight;
+	return true;
+}
+
+void ImageFileStreamPNG::Close()
+{
+	if (pngPtr)
+	{
+		// file is finished only if all lines were written
+		if (writtenLines == height)
+		{
+			if (setjmp(png_jmpbuf(pngPtr)) == 0) png_write_end(pngPtr, nullptr);
+		}
+		png_destroy_write_struct(&pngPtr, &infoPtr);
+		pngPtr = nullptr;
+		infoPtr = nullptr;
+	}
+	if (file)
+	{
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+#ifdef USE_TIFF
+// dimensions of TIFF tiles have to be multiples of 16
+ImageFileStreamTIFF::ImageFileStreamTIFF(QString filename, int width, int height, int tileWidth,
+	int tileHeight, ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha)
+		: ImageFileStream(filename, width, height, (tileWidth + 15) / 16 * 16,
+				(tileHeight + 15) / 16 * 16, quality, appendAlpha)
+{
+	tiff = nullptr;
+}
+
+ImageFileStreamTIFF::~ImageFileStreamTIFF()
+{
+	Close();
+}
+
+bool ImageFileStreamTIFF::Open()
+{
+	tiff = TIFFOpen(filename.toLocal8Bit().constData(), "w");
+	if (!tiff)
+	{
+		qCritical() << "ImageFileStreamTIFF::Open(): cannot open file" << filename;
+		return false;
+	}
+
+	int qualitySize;
+	int sampleFormat;
+	switch (quality)
+	{
+		case ImageFileSave::IMAGE_CHANNEL_QUALITY_8:
+			qualitySize = 8;
+			sampleFormat = SAMPLEFORMAT_UINT;
+			break;
+		case ImageFileSave::IMAGE_CHANNEL_QUALITY_16:
+			qualitySize = 16;
+			sampleFormat = SAMPLEFORMAT_UINT;
+			break;
+		default:
+			qualitySize = 32;
+			sampleFormat = SAMPLEFORMAT_IEEEFP;
+			break;
+	}
+
+	TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
+	TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
+	TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, qualitySize);
+	TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, appendAlpha ? 4 : 3);
+	TIFFSetField(tiff, TIFFTAG_TILEWIDTH, uint32_t(tileWidth));
+	TIFFSetField(tiff, TIFFTAG_TILELENGTH, uint32_t(tileHeight));
+
+	TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
+	TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+	TIFFSetField(tiff, TIFFTAG_FILLORDER, FILLORDER_MSB2LSB);
+	TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+	TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, sampleFormat);
+	return true;
+}
+
+bool ImageFileStreamTIFF::WriteTile(
+	cImage *image, int imageX, int imageY, int frameX, int frameY)
+{
+	// tiles at the right and bottom borders are padded with zeros
+	const int copyWidth = qMin(tileWidth, width - frameX);
+	const int copyHeight = qMin(tileHeight, height - frameY);
+	buffer.assign(quint64(tileWidth) * quint64(tileHeight) * pixelSize, 0);
+
+	CopyTile(image, imageX, imageY, copyWidth, copyHeight, buffer.data(), tileWidth);
+
+	if (TIFFWriteTile(tiff, buffer.data(), uint32_t(frameX), uint32_t(frameY), 0, 0) < 0)
+	{
+		qCritical() << "ImageFileStreamTIFF::WriteTile(): error during writing tile";
+		return false;
+	}
+	return true;
+}
+
+void ImageFileStreamTIFF::Close()
+{
+	if (tiff)
+	{
+		TIFFClose(tiff);
+		tiff = nullptr;
+	}
+}
+#endif /* USE_TIFF */
+
+#ifdef USE_EXR
+ImageFileStreamEXR::ImageFileStreamEXR(QString filename, int width, int height, int tileWidth,
+	int tileHeight, ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha)
+		: ImageFileStream(filename, width, height, tileWidth, tileHeight, quality, appendAlpha)
+{
+	// tile buffer is always float, EXR library converts it to half if needed
+	pixelSize = sizeof(float) * (appendAlpha ? 4 : 3);
+	outputFile = nullptr;
+}
+
+ImageFileStreamEXR::~ImageFileStreamEXR()
+{
+	Close();
+}
+
+bool ImageFileStreamEXR::Open()
+{
+	Imf::Header header(width, height);
+	header.setTileDescription(Imf::TileDescription(tileWidth, tileHeight, Imf::ONE_LEVEL));
+
+	// each tile is compressed on its own
+	header.compression() = Imf::ZIP_COMPRESSION;
+
+	bool linear = gPar->Get<bool>("linear_colorspace");
+	Imf::PixelType imfQuality =
+		quality == ImageFileSave::IMAGE_CHANNEL_QUALITY_32 ? Imf::FLOAT : Imf::HALF;
+	header.channels().insert("R", Imf::Channel(imfQuality, 1, 1, linear));
+	header.channels().insert("G", Imf::Channel(imfQuality, 1, 1, linear));
+	header.channels().insert("B", Imf::Channel(imfQuality, 1, 1, linear));
+	if (appendAlpha) header.channels().insert("A", Imf::Channel(imfQuality, 1, 1, linear));
+
+	try
+	{
+		outputFile = new Imf::TiledOutputFile(filename.toStdString().c_str(), header);
+	}
+	catch (const std::exception &ex)
+	{
+		qCritical() << "ImageFileStreamEXR::Open():" << ex.what();
+		return false;
+	}
+	return true;
+}
+
+bool ImageFileStreamEXR::WriteTile(cImage *image, int imageX, int imageY, int frameX, int frameY)
+{
+	// tiles at the right and bottom borders are clipped by the library to the data window
+	const int copyWidth = qMin(tileWidth, width - frameX);
+	const int copyHeight = qMin(tileHeight, height - frameY);
+	quint64 tileSize = quint64(tileWidth) * quint64(tileHeight) * pixelSize;
+	if (buffer.size() < tileSize) buffer.resize(tileSize);
+
+	CopyTile(image, imageX, imageY, copyWidth, copyHeight, buffer.data(), tileWidth);
+
+	// slices are addressed with coordinates of the whole image
+	const quint64 xStride = pixelSize;
+	const quint64 yStride = pixelSize * tileWidth;
+	char *base = buffer.data() - quint64(frameY) * yStride - quint64(frameX) * xStride;
+
+	Imf::FrameBuffer frameBuffer;
+	const char *names[] = {"R", "G", "B", "A"};
+	for (int i = 0; i < (appendAlpha ? 4 : 3); i++)
+	{
+		frameBuffer.insert(
+			names[i], Imf::Slice(Imf::FLOAT, base + i * sizeof(float), xStride, yStride));
+	}
+
+	try
+	{
+		outputFile->setFrameBuffer(frameBuffer);
+		outputFile->writeTile(frameX / tileWidth, frameY / tileHeight);
+	}
+	catch (const std::exception &ex)
+	{
+		qCritical() << "ImageFileStreamEXR::WriteTile():" << ex.what();
+		return false;
+	}
+	return true;
+}
+
+void ImageFileStreamEXR::Close()
+{
+	if (outputFile)
+	{
+		delete outputFile;
+		outputFile = nullptr;
+	}
+}
+
+void ImageFileStreamEXR::PrepareImage(cImage *image) const
+{
+	// EXR is written from the float image
+	Q_UNUSED(image);
+}
+
+// the same pixel values as saved by ImageFileSaveEXR
+void ImageFileStreamEXR::PutPixel(const cImage *image, quint64 x, quint64 y, char *output) const
+{
+	sRGBFloat pixel = image->GetPixelImage(x, y);
+	float *typedOutput = reinterpret_cast<float *>(output);
+	typedOutput[0] = pixel.R;
+	typedOutput[1] = pixel.G;
+	typedOutput[2] = pixel.B;
+	if (appendAlpha) typedOutput[3] = image->GetPixelAlpha(x, y) / 65536.0f;
+}
+#endif /* USE_EXR */
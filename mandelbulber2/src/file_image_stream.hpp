@@ -0,0 +1,156 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * ImageFileStream class - image files written tile by tile
+ *
+ * Used for out-of-core tiled rendering of very big images. Every rendered tile is written to the
+ * file as soon as it is finished, so the complete frame never exists in memory. TIFF and EXR files
+ * are stored as tiled images. PNG can be written only line by line, so tiles of one row are
+ * collected in a band buffer. Only the color channel (with optionally appended alpha) is written.
+ * JPEG cannot be written this way.
+ */
+
+#ifndef MANDELBULBER2_SRC_FILE_IMAGE_STREAM_HPP_
+#define MANDELBULBER2_SRC_FILE_IMAGE_STREAM_HPP_
+
+#include <cstdio>
+#include <vector>
+
+#include <QString>
+
+#include "file_image.hpp"
+
+// custom includes
+#ifdef USE_EXR
+#include <ImfTiledOutputFile.h>
+#endif // USE_EXR
+#ifdef USE_TIFF
+#include "tiffio.h"
+#endif // USE_TIFF
+
+// forward declarations
+class cImage;
+
+class ImageFileStream
+{
+public:
+	virtual ~ImageFileStream() = default;
+
+	// returns nullptr if file type cannot be written in tiles
+	static ImageFileStream *create(QString filename, ImageFileSave::enumImageFileType fileType,
+		int width, int height, int tileWidth, int tileHeight,
+		ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha);
+
+	virtual bool Open() = 0;
+	// writes rectangle of the image starting at imageX, imageY as the tile at frameX, frameY.
+	// Tiles are aligned to the tile grid and have to be written row by row, from left to right
+	virtual bool WriteTile(cImage *image, int imageX, int imageY, int frameX, int frameY) = 0;
+	virtual void Close() = 0;
+
+	QString GetFilename() const { return filename; }
+	// tile size can be bigger than requested if the file format needs it
+	int GetTileWidth() const { return tileWidth; }
+	int GetTileHeight() const { return tileHeight; }
+
+protected:
+	ImageFileStream(QString filename, int width, int height, int tileWidth, int tileHeight,
+		ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha);
+
+	// copies rectangle of the image into the buffer with lines of bufferWidth pixels
+	void CopyTile(cImage *image, int imageX, int imageY, int copyWidth, int copyHeight,
+		char *buffer, int bufferWidth) const;
+	virtual void PrepareImage(cImage *image) const;
+	virtual void PutPixel(const cImage *image, quint64 x, quint64 y, char *output) const;
+
+	QString filename;
+	int width;
+	int height;
+	int tileWidth;
+	int tileHeight;
+	ImageFileSave::enumImageChannelQualityType quality;
+	bool appendAlpha;
+	quint64 pixelSize;
+	std::vector<char> buffer;
+};
+
+class ImageFileStreamPNG : public ImageFileStream
+{
+public:
+	ImageFileStreamPNG(QString filename, int width, int height, int tileWidth, int tileHeight,
+		ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha);
+	~ImageFileStreamPNG() override;
+	bool Open() override;
+	bool WriteTile(cImage *image, int imageX, int imageY, int frameX, int frameY) override;
+	void Close() override;
+
+private:
+	FILE *file;
+	png_structp pngPtr;
+	png_infop infoPtr;
+	int writtenLines;
+};
+
+#ifdef USE_TIFF
+class ImageFileStreamTIFF : public ImageFileStream
+{
+public:
+	ImageFileStreamTIFF(QString filename, int width, int height, int tileWidth, int tileHeight,
+		ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha);
+	~ImageFileStreamTIFF() override;
+	bool Open() override;
+	bool WriteTile(cImage *image, int imageX, int imageY, int frameX, int frameY) override;
+	void Close() override;
+
+private:
+	TIFF *tiff;
+};
+#endif /* USE_TIFF */
+
+#ifdef USE_EXR
+class ImageFileStreamEXR : public ImageFileStream
+{
+public:
+	ImageFileStreamEXR(QString filename, int width, int height, int tileWidth, int tileHeight,
+		ImageFileSave::enumImageChannelQualityType quality, bool appendAlpha);
+	~ImageFileStreamEXR() override;
+	bool Open() override;
+	bool WriteTile(cImage *image, int imageX, int imageY, int frameX, int frameY) override;
+	void Close() override;
+
+protected:
+	void PrepareImage(cImage *image) const override;
+	void PutPixel(const cImage *image, quint64 x, quint64 y, char *output) const override;
+
+private:
+	Imf::TiledOutputFile *outputFile;
+};
+#endif /* USE_EXR */
+
+#endif /* MANDELBULBER2_SRC_FILE_IMAGE_STREAM_HPP_ */
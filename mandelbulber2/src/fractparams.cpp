@@ -34,6 +34,7 @@
 
 #include "fractparams.hpp"
 
+#include "material.h"
 #include "object_data.hpp"
 #include "parameters.hpp"
 
@@ -44,6 +45,7 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	absMaxMarchingStep = container->Get<double>("abs_max_marching_step");
 	absMinMarchingStep = container->Get<double>("abs_min_marching_step");
 	antialiasingAdaptive = container->Get<bool>("antialiasing_adaptive");
+	antialiasingAdaptiveThreshold = container->Get<double>("antialiasing_adaptive_threshold");
 	antialiasingEnabled = container->Get<bool>("antialiasing_enabled");
 	antialiasingOclDepth = container->Get<int>("antialiasing_ocl_depth");
 	antialiasingSize = container->Get<int>("antialiasing_size");
@@ -66,6 +68,9 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	auxLightRandomColor = toRGBFloat(container->Get<sRGB>("random_lights_color"));
 	auxLightVisibility = container->Get<double>("aux_light_visibility");
 	auxLightVisibilitySize = container->Get<double>("aux_light_visibility_size");
+	auxLightInfluenceThreshold = container->Get<double>("aux_light_influence_threshold");
+	auxLightMonteCarloSampling = container->Get<bool>("MC_aux_lights_sampling");
+	auxLightMonteCarloSamples = container->Get<int>("MC_aux_lights_samples");
 	background3ColorsEnable = container->Get<bool>("background_3_colors_enable");
 	background_color1 = toRGBFloat(container->Get<sRGB>("background_color", 1));
 	background_color2 = toRGBFloat(container->Get<sRGB>("background_color", 2));
@@ -78,6 +83,9 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	backgroundVScale = container->Get<double>("background_v_scale");
 	backgroundRotation = container->Get<CVector3>("background_rotation");
 	booleanOperatorsEnabled = container->Get<bool>("boolean_operators");
+	boundingSphereCenter = container->Get<CVector3>("bounding_sphere_center");
+	boundingSphereEnabled = container->Get<bool>("bounding_sphere_enabled");
+	boundingSphereRadius = container->Get<double>("bounding_sphere_radius");
 	camera = container->Get<CVector3>("camera");
 	cameraDistanceToTarget = container->Get<double>("camera_distance_to_target");
 	cloudsAmbientLight = container->Get<double>("clouds_ambient_light");
@@ -93,6 +101,9 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	cloudsDistanceMode = container->Get<bool>("clouds_distance_mode");
 	cloudsEnable = container->Get<bool>("clouds_enable");
 	cloudsLightsBoost = container->Get<double>("clouds_lights_boost");
+	cloudsNoiseVolume = container->Get<bool>("clouds_noise_volume");
+	cloudsNoiseVolumeResolution = container->Get<int>("clouds_noise_volume_resolution");
+	cloudsNoiseVolumeTile = container->Get<int>("clouds_noise_volume_tile");
 	cloudsPeriod = container->Get<double>("clouds_period");
 	cloudsPlaneShape = container->Get<bool>("clouds_plane_shape");
 	cloudsHeight = container->Get<double>("clouds_height");
@@ -100,6 +111,7 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	cloudsOpacity = container->Get<double>("clouds_opacity");
 	cloudsRandomSeed = container->Get<int>("clouds_random_seed");
 	cloudsRotation = container->Get<CVector3>("clouds_rotation");
+	conePrepassEnabled = container->Get<bool>("cone_prepass_enabled");
 	constantDEThreshold = container->Get<bool>("constant_DE_threshold");
 	constantFactor = container->Get<double>("fractal_constant_factor");
 	DEFactor = container->Get<double>("DE_factor");
@@ -109,12 +121,15 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	detailLevel = container->Get<double>("detail_level");
 	detailSizeMax = container->Get<double>("detail_size_max");
 	detailSizeMin = container->Get<double>("detail_size_min");
+	distanceCacheEnabled = container->Get<bool>("distance_cache_enabled");
+	distanceCacheMemoryLimit = container->Get<int>("distance_cache_memory_limit");
 	DEThresh = container->Get<double>("DE_thresh");
 	DOFEnabled = container->Get<bool>("DOF_enabled");
 	DOFFocus = container->Get<double>("DOF_focus");
 	DOFRadius = container->Get<double>("DOF_radius");
 	DOFMaxRadius = container->Get<double>("DOF_max_radius");
 	DOFHDRMode = container->Get<bool>("DOF_HDR");
+	DOFLayered = container->Get<bool>("DOF_layered");
 	DOFMonteCarlo = container->Get<bool>("DOF_monte_carlo");
 	DOFMonteCarloGlobalIllumination = container->Get<bool>("DOF_MC_global_illumination");
 	DOFNumberOfPasses = container->Get<int>("DOF_number_of_passes");
@@ -122,6 +137,7 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	DOFMinSamples = container->Get<int>("DOF_min_samples");
 	DOFBlurOpacity = container->Get<double>("DOF_blur_opacity");
 	DOFMaxNoise = container->Get<double>("DOF_max_noise");
+	DOFMonteCarloTileConvergence = container->Get<bool>("DOF_MC_tile_convergence");
 	DOFMonteCarloChromaticAberration = container->Get<bool>("DOF_MC_CA_enable");
 	DOFMonteCarloCADispersionGain = container->Get<float>("DOF_MC_CA_dispersion_gain");
 	DOFMonteCarloCACameraDispersion = container->Get<float>("DOF_MC_CA_camera_dispersion");
@@ -183,6 +199,9 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	monteCarloGIRadianceLimit = container->Get<float>("MC_GI_radiance_limit");
 	monteCarloGIVolumetric = container->Get<bool>("MC_global_illumination_volumetric");
 	N = container->Get<int>("N");
+	normalVectorMode = params::enumNormalVectorMode(container->Get<int>("normal_vector_mode"));
+	overRelaxationEnabled = container->Get<bool>("over_relaxation_enabled");
+	overRelaxationFactor = container->Get<double>("over_relaxation_factor");
 	penetratingLights = container->Get<bool>("penetrating_lights");
 	raytracedReflections = container->Get<bool>("raytraced_reflections");
 	reflectionsMax = container->Get<int>("reflections_max");
@@ -193,6 +212,7 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	shadow = container->Get<bool>("shadows_enabled");
 	shadowConeAngle = container->Get<double>("shadows_cone_angle");
 	slowShading = container->Get<bool>("slow_shading");
+	slowShadingAdaptive = container->Get<bool>("slow_shading_adaptive");
 	smoothness = container->Get<double>("smoothness");
 	SSAO_random_mode = container->Get<bool>("SSAO_random_mode");
 	stereoEyeDistance = container->Get<double>("stereo_eye_distance");
@@ -202,6 +222,8 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 	sweetSpotVAngle = container->Get<double>("sweet_spot_vertical_angle") / 180.0 * M_PI;
 	target = container->Get<CVector3>("target");
 	target = container->Get<CVector3>("target");
+	temporalReprojectionEnabled = container->Get<bool>("temporal_reprojection_enabled");
+	temporalReprojectionFactor = container->Get<double>("temporal_reprojection_factor");
 	texturedBackground = container->Get<bool>("textured_background");
 	texturedBackgroundMapType =
 		params::enumTextureMapType(container->Get<int>("textured_background_map_type"));
@@ -261,6 +283,22 @@ sParamRender::sParamRender(const cParameterContainer *container, QVector<cObject
 		mRotFormulaRotation[i].SetRotation2(formulaRotation[i] * (M_PI / 180.0));
 		formulaMaterialId[i] = container->Get<int>("formula_material_id", i + 1);
 
+		// bounding sphere is centered at formula position. Repeated formulas are unbounded and
+		// formulas with undefined material can get unknown displacement
+		QString useDisplacementName =
+			cMaterial::Name("use_displacement_texture", formulaMaterialId[i]);
+		formulaBoundingSphereEnabled[i] =
+			container->Get<bool>("formula_bounding_sphere_enabled", i + 1)
+			&& formulaRepeat[i].Length() == 0.0 && container->IfExists(useDisplacementName);
+		formulaBoundingSphereRadius[i] =
+			container->Get<double>("formula_bounding_sphere_radius", i + 1);
+		formulaDisplacementHeight[i] = 0.0;
+		if (formulaBoundingSphereEnabled[i] && container->Get<bool>(useDisplacementName))
+		{
+			formulaDisplacementHeight[i] = fabs(container->Get<double>(
+				cMaterial::Name("displacement_texture_height", formulaMaterialId[i])));
+		}
+
 		if (objectData)
 		{
 			cObjectData oneObjectData;
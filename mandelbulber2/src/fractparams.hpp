@@ -62,6 +62,12 @@ enum enumBooleanOperator
 	booleanOperatorSUB = 2
 };
 
+enum enumNormalVectorMode
+{
+	normalVectorCentralDifference = 0,
+	normalVectorTetrahedral = 1
+};
+
 } // namespace params
 
 struct sParamRender
@@ -75,8 +81,12 @@ struct sParamRender
 	int auxLightNumber;
 	int auxLightRandomNumber;
 	int auxLightRandomSeed;
+	int auxLightMonteCarloSamples;
 	int cloudsIterations;
+	int cloudsNoiseVolumeResolution;
+	int cloudsNoiseVolumeTile;
 	int cloudsRandomSeed;
+	int distanceCacheMemoryLimit; // [MB]
 	int frameNo;
 	int imageHeight; // image height
 	int imageWidth;	 // image width
@@ -93,6 +103,7 @@ struct sParamRender
 	params::enumAOMode ambientOcclusionMode;
 	params::enumTextureMapType texturedBackgroundMapType;
 	params::enumBooleanOperator booleanOperator[NUMBER_OF_FRACTALS - 1];
+	params::enumNormalVectorMode normalVectorMode;
 	fractal::enumDEMethod delta_DE_method;
 	fractal::enumDEFunctionType delta_DE_function;
 
@@ -103,18 +114,26 @@ struct sParamRender
 	bool auxLightPreEnabled[4];
 	bool auxLightRandomEnabled;
 	bool auxLightRandomInOneColor;
+	bool auxLightMonteCarloSampling; // one or few lights selected randomly for each sample
 	bool background3ColorsEnable;
 	bool booleanOperatorsEnabled;
+	bool boundingSphereEnabled; // everything outside the sphere is cut away
 	bool cloudsCastShadows;
 	bool cloudsDistanceMode;
 	bool cloudsEnable;
+	bool cloudsNoiseVolume;
 	bool cloudsPlaneShape;
+	bool conePrepassEnabled; // cone marching of pixel blocks in the coarse pass
 	bool constantDEThreshold;
+	bool distanceCacheEnabled;
+	bool formulaBoundingSphereEnabled[NUMBER_OF_FRACTALS];
 	bool DOFEnabled;
 	bool DOFHDRMode;
+	bool DOFLayered;
 	bool DOFMonteCarlo;
 	bool DOFMonteCarloGlobalIllumination;
 	bool DOFMonteCarloChromaticAberration;
+	bool DOFMonteCarloTileConvergence;
 	bool envMappingEnable;
 	bool fakeLightsEnabled;
 	bool fogEnabled;
@@ -131,12 +150,15 @@ struct sParamRender
 	bool mainLightPositionAsRelative;
 	bool monteCarloSoftShadows;
 	bool monteCarloGIVolumetric;
+	bool overRelaxationEnabled;
 	bool penetratingLights;
 	bool raytracedReflections;
 	bool shadow;			// enable shadows
 	bool slowShading; // enable fake gradient calculation for shading
+	bool slowShadingAdaptive; // fake gradient calculated with early termination
 	bool SSAO_random_mode;
 	bool stereoSwapEyes;
+	bool temporalReprojectionEnabled; // primary rays start at depth from the previous frame
 	bool texturedBackground; // enable textured background
 	bool useDefaultBailout;
 	bool volumetricLightEnabled[5];
@@ -167,6 +189,8 @@ struct sParamRender
 	double absMinMarchingStep;
 	float ambientOcclusion;
 	double ambientOcclusionFastTune;
+	double antialiasingAdaptiveThreshold;
+	double auxLightInfluenceThreshold; // lights weaker than this are skipped
 	float auxLightPreIntensity[4];
 	double auxLightVisibility;
 	double auxLightVisibilitySize;
@@ -178,6 +202,7 @@ struct sParamRender
 	double backgroundVScale;
 	double backgroundTextureOffsetX;
 	double backgroundTextureOffsetY;
+	double boundingSphereRadius;
 	double cameraDistanceToTarget; // zoom
 	double cloudsAmbientLight;
 	double cloudsDEApproaching;
@@ -208,6 +233,8 @@ struct sParamRender
 	float fakeLightsVisibility;
 	float fakeLightsVisibilitySize;
 	double fogVisibility;
+	double formulaBoundingSphereRadius[NUMBER_OF_FRACTALS]; // 0.0 - estimated before render
+	double formulaDisplacementHeight[NUMBER_OF_FRACTALS];
 	double formulaScale[NUMBER_OF_FRACTALS];
 	double fov; // perspective factor
 	float glowIntensity;
@@ -226,6 +253,7 @@ struct sParamRender
 	double mainLightVisibility;
 	double mainLightVisibilitySize;
 	float monteCarloGIRadianceLimit;
+	double overRelaxationFactor; // step multiplier of over-relaxed sphere tracing
 	double relMaxMarchingStep;
 	double relMinMarchingStep;
 	double resolution; // resolution of image in fractal coordinates
@@ -235,6 +263,7 @@ struct sParamRender
 	double stereoInfiniteCorrection;
 	double sweetSpotHAngle;
 	double sweetSpotVAngle;
+	double temporalReprojectionFactor;
 	double viewDistanceMax;
 	double viewDistanceMin;
 	double volFogColour1Distance;
@@ -250,6 +279,7 @@ struct sParamRender
 	CVector3 auxLightPre[4];
 	CVector3 auxLightRandomCenter;
 	CVector3 backgroundRotation;
+	CVector3 boundingSphereCenter;
 	CVector3 cloudsCenter;
 	CVector3 cloudsRotation;
 	CVector3 formulaPosition[NUMBER_OF_FRACTALS];
@@ -34,11 +34,15 @@
 
 #include "headless.h"
 
+#include <cmath>
+
 #include "animation_flight.hpp"
 #include "animation_keyframes.hpp"
+#include "ao_modes.h"
 #include "cimage.hpp"
 #include "error_message.hpp"
 #include "file_image.hpp"
+#include "file_image_stream.hpp"
 #include "files.h"
 #include "fractal_container.hpp"
 #include "global_data.hpp"
@@ -49,6 +53,7 @@
 #include "opencl_engine_render_ssao.h"
 #include "opencl_global.h"
 #include "queue.hpp"
+#include "region.hpp"
 #include "render_job.hpp"
 #include "rendering_configuration.hpp"
 #include "system_data.hpp"
@@ -118,6 +123,151 @@ void cHeadless::RenderStillImage(QString filename, QString imageFileFormat)
 	emit finished();
 }
 
+void cHeadless::RenderStillImageTiled(QString filename, QString imageFileFormat)
+{
+	const int frameWidth = gPar->Get<int>("image_width");
+	const int frameHeight = gPar->Get<int>("image_height");
+	const int tiles = gPar->Get<int>("tiles");
+
+	ImageFileSave::enumImageFileType imageFileType;
+	ImageFileSave::enumImageChannelQualityType quality =
+		ImageFileSave::enumImageChannelQualityType(gPar->Get<int>("color_quality"));
+	bool appendAlpha = gPar->Get<bool>("alpha_enabled") && gPar->Get<bool>("append_alpha_png");
+	if (imageFileFormat == "png16" || imageFileFormat == "png16alpha")
+	{
+		imageFileType = ImageFileSave::IMAGE_FILE_TYPE_PNG;
+		quality = ImageFileSave::IMAGE_CHANNEL_QUALITY_16;
+		appendAlpha = (imageFileFormat == "png16alpha");
+	}
+	else
+	{
+		imageFileType = ImageFileSave::ImageFileType(imageFileFormat);
+		// EXR keeps all channels in one file
+		if (imageFileType == ImageFileSave::IMAGE_FILE_TYPE_EXR)
+			appendAlpha = gPar->Get<bool>("alpha_enabled");
+	}
+
+	QString fullFilename = ImageFileSave::ImageNameWithoutExtension(filename) + "."
+												 + ImageFileSave::ImageFileExtension(imageFileType);
+
+	ImageFileStream *imageFileStream = ImageFileStream::create(fullFilename, imageFileType,
+		frameWidth, frameHeight, (frameWidth + tiles - 1) / tiles, (frameHeight + tiles - 1) / tiles,
+		quality, appendAlpha);
+	if (!imageFileStream || !imageFileStream->Open())
+	{
+		cErrorMessage::showMessage(QObject::tr("Cannot write image %1 in tiles").arg(fullFilename),
+			cErrorMessage::errorMessage);
+		delete imageFileStream;
+		emit finished();
+		return;
+	}
+
+	// rendered tiles are the same as tiles of the file, which can be bigger than requested
+	const int tileWidth = imageFileStream->GetTileWidth();
+	const int tileHeight = imageFileStream->GetTileHeight();
+	const int numberOfTiles =
+		((frameWidth + tileWidth - 1) / tileWidth) * ((frameHeight + tileHeight - 1) / tileHeight);
+
+	// tiles are rendered with overlap, so post effects have valid surrounding at the tile borders
+	const int overlap = TileOverlap(frameWidth, frameHeight, tileWidth, tileHeight);
+	const int imageWidth = qMin(frameWidth, tileWidth + 2 * overlap);
+	const int imageHeight = qMin(frameHeight, tileHeight + 2 * overlap);
+
+	// every tile is rendered as separate image. OpenCL and stereoscopic rendering always
+	// render the whole frame, so they are disabled
+	cParameterContainer tileParams(*gPar);
+	tileParams.Set("image_width", imageWidth);
+	tileParams.Set("image_height", imageHeight);
+	tileParams.Set("opencl_enabled", false);
+	tileParams.Set("stereo_enabled", false);
+
+	cImage *image = new cImage(imageWidth, imageHeight);
+	cRenderJob *renderJob =
+		new cRenderJob(&tileParams, gParFractal, image, &gMainInterface->stopRequest);
+
+	QObject::connect(renderJob,
+		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
+		SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
+	QObject::connect(renderJob, SIGNAL(updateStatistics(cStatistics)), this,
+		SLOT(slotUpdateStatistics(cStatistics)));
+
+	cRenderingConfiguration config;
+	config.DisableRefresh();
+	config.DisableProgressiveRender();
+
+	bool result = renderJob->Init(cRenderJob::still, config);
+
+	int tileIndex = 0;
+	for (int tileY = 0; tileY < frameHeight && result; tileY += tileHeight)
+	{
+		// image is shifted at the frame borders to keep the overlap inside the frame
+		const int imageY = qBound(0, tileY - overlap, frameHeight - imageHeight);
+
+		for (int tileX = 0; tileX < frameWidth; tileX += tileWidth)
+		{
+			const int imageX = qBound(0, tileX - overlap, frameWidth - imageWidth);
+
+			renderJob->SetFrameRegion(
+				cRegion<int>(-imageX, -imageY, frameWidth - imageX, frameHeight - imageY));
+			if (!renderJob->Execute())
+			{
+				result = false;
+				break;
+			}
+			if (!imageFileStream->WriteTile(image, tileX - imageX, tileY - imageY, tileX, tileY))
+			{
+				result = false;
+				break;
+			}
+
+			tileIndex++;
+			slotUpdateProgressAndStatus(tr("Tiled rendering"),
+				tr("Tile %1 of %2 rendered").arg(tileIndex).arg(numberOfTiles),
+				double(tileIndex) / numberOfTiles);
+		}
+	}
+	imageFileStream->Close();
+
+	if (result)
+	{
+		QTextStream out(stdout);
+		out << tr("Image saved to: %1\n").arg(fullFilename);
+	}
+	else
+	{
+		cErrorMessage::showMessage(
+			QObject::tr("Tiled rendering of image %1 was not finished").arg(fullFilename),
+			cErrorMessage::errorMessage);
+	}
+
+	delete imageFileStream;
+	delete renderJob;
+	delete image;
+	emit finished();
+}
+
+int cHeadless::TileOverlap(int frameWidth, int frameHeight, int tileWidth, int tileHeight)
+{
+	double overlap = 0.0;
+
+	if (gPar->Get<bool>("DOF_enabled") && !gPar->Get<bool>("DOF_monte_carlo"))
+		overlap = qMax(overlap, gPar->Get<double>("DOF_max_radius"));
+
+	if (gPar->Get<bool>("hdr_blur_enabled"))
+	{
+		double blurSize = gPar->Get<double>("hdr_blur_radius") * (frameWidth + frameHeight) * 0.001;
+		overlap = qMax(overlap, blurSize);
+	}
+
+	// SSAO samples reach up to half of the frame, only the nearest part is taken into account
+	if (gPar->Get<bool>("ambient_occlusion_enabled")
+			&& gPar->Get<int>("ambient_occlusion_mode") == params::AOModeScreenSpace)
+		overlap = qMax(overlap, 0.25 * qMin(tileWidth, tileHeight));
+
+	// limited to keep memory usage proportional to the tile size
+	return qMin(int(ceil(overlap)), qMax(tileWidth, tileHeight));
+}
+
 void cHeadless::RenderQueue()
 {
 	gQueue->slotQueueRender();
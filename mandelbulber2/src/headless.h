@@ -62,6 +62,8 @@ public:
 	};
 
 	void RenderStillImage(QString filename, QString imageFileFormat);
+	// renders still image tile by tile and writes it to the file in bands (out-of-core)
+	void RenderStillImageTiled(QString filename, QString imageFileFormat);
 	[[noreturn]] static void RenderQueue();
 	void RenderVoxel(QString voxelFormat);
 	void RenderFlightAnimation() const;
@@ -75,6 +77,9 @@ public:
 	static void MoveCursor(int leftRight, int downUp);
 	static void EraseLine();
 
+private:
+	static int TileOverlap(int frameWidth, int frameHeight, int tileWidth, int tileHeight);
+
 public slots:
 	void slotNetRender();
 	static void slotUpdateProgressAndStatus(const QString &text, const QString &progressText,
@@ -34,6 +34,8 @@
 
 #include "histogram.hpp"
 
+#include <QtGlobal>
+
 cHistogram::cHistogram()
 {
 	histSize = 0;
@@ -102,7 +104,13 @@ long cHistogram::GetHist(int index) const
 
 void cHistogram::Copy(const cHistogram &source)
 {
-	Resize(source.GetSize());
+	// memory is allocated again only if size is changed (statistics are copied very often)
+	if (!data || histSize != source.GetSize()) Resize(source.GetSize());
+	if (!source.data)
+	{
+		Clear();
+		return;
+	}
 
 	count = source.count;
 	sum = source.sum;
@@ -122,3 +130,16 @@ void cHistogram::Clear()
 	count = 0;
 	sum = 0;
 }
+
+void cHistogram::Merge(const cHistogram &source)
+{
+	if (!data || !source.data) return;
+
+	// bins which don't fit are accumulated in the overflow bin (the same as Add() does)
+	for (int i = 0; i <= source.histSize; i++)
+	{
+		data[qMin(i, histSize)] += source.data[i];
+	}
+	count += source.count;
+	sum += source.sum;
+}
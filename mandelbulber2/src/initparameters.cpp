@@ -67,6 +67,7 @@ void InitParams(cParameterContainer *par)
 	par->addParam("antialiasing_size", 2, 1, 10, morphNone, paramStandard);
 	par->addParam("antialiasing_ocl_depth", 1, 0, 5, morphNone, paramStandard);
 	par->addParam("antialiasing_adaptive", true, morphNone, paramStandard);
+	par->addParam("antialiasing_adaptive_threshold", 0.05, 1e-5, 1.0, morphNone, paramStandard);
 
 	// flight animation
 	par->addParam("flight_first_to_render", 0, 0, 9999999, morphNone, paramStandard);
@@ -161,6 +162,9 @@ void InitParams(cParameterContainer *par)
 		par->addParam("dont_add_c_constant", i, false, morphLinear, paramStandard);
 		par->addParam("check_for_bailout", i, true, morphLinear, paramStandard);
 		par->addParam("formula_material_id", i, 1, morphLinear, paramStandard);
+		par->addParam("formula_bounding_sphere_enabled", i, false, morphLinear, paramStandard);
+		par->addParam(
+			"formula_bounding_sphere_radius", i, 0.0, 0.0, 1e15, morphAkima, paramStandard);
 	}
 	par->addParam("formula_material_id", 1, morphLinear, paramStandard);
 
@@ -177,13 +181,26 @@ void InitParams(cParameterContainer *par)
 	par->addParam("iteration_threshold_mode", false, morphNone, paramStandard);
 	par->addParam("analityc_DE_mode", true, morphNone, paramStandard);
 	par->addParam("DE_factor", 1.0, 1e-15, 1e15, morphLinear, paramStandard);
+	par->addParam("over_relaxation_enabled", false, morphLinear, paramStandard);
+	par->addParam("over_relaxation_factor", 1.4, 1.0, 1.99, morphLinear, paramStandard);
 	par->addParam("slow_shading", false, morphLinear, paramStandard);
+	par->addParam("slow_shading_adaptive", false, morphNone, paramStandard);
+	par->addParam("normal_vector_mode", int(params::normalVectorCentralDifference), 0, 1, morphNone,
+		paramStandard);
 	par->addParam("view_distance_max", 50.0, 1e-15, 1e15, morphLinear, paramStandard);
 	par->addParam("view_distance_min", 1e-15, 1e-15, 1e15, morphLinear, paramStandard);
 	par->addParam("limit_min", CVector3(-10.0, -10.0, -10.0), morphLinear, paramStandard);
 	par->addParam("limit_max", CVector3(10.0, 10.0, 10.0), morphLinear, paramStandard);
 	par->addParam("limits_enabled", false, morphLinear, paramStandard);
 	par->addParam("limit_outer_bounding", 100.0, 1e-15, 1e15, morphLinear, paramStandard);
+	par->addParam("bounding_sphere_enabled", false, morphLinear, paramStandard);
+	par->addParam("bounding_sphere_center", CVector3(0.0, 0.0, 0.0), morphLinear, paramStandard);
+	par->addParam("bounding_sphere_radius", 10.0, 1e-15, 1e15, morphLinear, paramStandard);
+	par->addParam("cone_prepass_enabled", false, morphNone, paramStandard);
+	par->addParam("distance_cache_enabled", false, morphNone, paramStandard);
+	par->addParam("distance_cache_memory_limit", 512, 16, 65536, morphNone, paramStandard);
+	par->addParam("temporal_reprojection_enabled", false, morphNone, paramStandard);
+	par->addParam("temporal_reprojection_factor", 0.9, 0.0, 1.0, morphNone, paramStandard);
 	par->addParam("interior_mode", false, morphLinear, paramStandard);
 	par->addParam("constant_DE_threshold", false, morphLinear, paramStandard);
 	par->addParam("hybrid_fractal_enable", false, morphNone, paramStandard);
@@ -327,6 +344,9 @@ void InitParams(cParameterContainer *par)
 	par->addParam("clouds_detail_accuracy", 1.0, 0.0, 1e15, morphLinear, paramStandard);
 	par->addParam("clouds_DE_approaching", 1.0, 0.0, 1e15, morphLinear, paramStandard);
 	par->addParam("clouds_DE_multiplier", 1.0, 0.0, 1e15, morphLinear, paramStandard);
+	par->addParam("clouds_noise_volume", false, morphNone, paramStandard);
+	par->addParam("clouds_noise_volume_resolution", 32, 4, 256, morphNone, paramStandard);
+	par->addParam("clouds_noise_volume_tile", 4, 1, 64, morphNone, paramStandard);
 
 	par->addParam("hdr_blur_enabled", false, morphLinear, paramStandard);
 	par->addParam("hdr_blur_radius", 10.0, 0.1, 1000.0, morphLinear, paramStandard);
@@ -347,16 +367,20 @@ void InitParams(cParameterContainer *par)
 	par->addParam("DOF_HDR", false, morphLinear, paramStandard);
 	par->addParam("DOF_number_of_passes", 1, 1, 10, morphLinear, paramStandard);
 	par->addParam("DOF_blur_opacity", 4.0, 0.01, 10.0, morphLinear, paramStandard);
+	par->addParam("DOF_layered", false, morphLinear, paramStandard);
 	par->addParam("DOF_monte_carlo", false, morphLinear, paramStandard);
 	par->addParam("DOF_samples", 100, morphLinear, paramStandard);
 	par->addParam("DOF_min_samples", 10, morphLinear, paramStandard);
 	par->addParam("DOF_max_noise", 1.0, 0.00001, 100.0, morphLinear, paramStandard);
+	par->addParam("DOF_MC_tile_convergence", false, morphNone, paramStandard);
 	par->addParam("DOF_MC_global_illumination", false, morphLinear, paramStandard);
 	par->addParam("MC_global_illumination_volumetric", false, morphLinear, paramStandard);
 	par->addParam("DOF_MC_CA_enable", false, morphLinear, paramStandard);
 	par->addParam("DOF_MC_CA_dispersion_gain", 1.0, 1e-15, 1000.0, morphLinear, paramStandard);
 	par->addParam("DOF_MC_CA_camera_dispersion", 1.0, 1e-15, 1000.0, morphLinear, paramStandard);
 	par->addParam("MC_soft_shadows_enable", false, morphLinear, paramStandard);
+	par->addParam("MC_aux_lights_sampling", false, morphLinear, paramStandard);
+	par->addParam("MC_aux_lights_samples", 1, 1, 16, morphLinear, paramStandard);
 	par->addParam("MC_GI_radiance_limit", 10.0, 0.001, 1e10, morphLinear, paramStandard);
 
 	// main light
@@ -395,6 +419,7 @@ void InitParams(cParameterContainer *par)
 	par->addParam("aux_light_colour", 3, sRGB(64884, 64928, 48848), morphLinear, paramStandard);
 	par->addParam("aux_light_colour", 4, sRGB(52704, 62492, 45654), morphLinear, paramStandard);
 	par->addParam("aux_light_place_behind", false, morphNone, paramStandard);
+	par->addParam("aux_light_influence_threshold", 0.0, 0.0, 1e15, morphLinear, paramStandard);
 
 	par->addParam("volumetric_light_DE_Factor", 1.0, 1e-15, 1e15, morphLinear, paramStandard);
 	for (int i = 1; i <= 4; i++)
@@ -533,6 +558,10 @@ void InitParams(cParameterContainer *par)
 	par->addParam("display_tooltips", true, morphNone, paramApp);
 
 	par->addParam("limit_CPU_cores", get_cpu_count(), 1, get_cpu_count(), morphNone, paramApp);
+	par->addParam("cpu_tile_scheduler", false, morphNone, paramApp);
+	par->addParam("cpu_tile_size", 32, 4, 1024, morphNone, paramApp);
+	par->addParam("cpu_packet_raymarching", false, morphNone, paramApp);
+	par->addParam("image_compact_storage", false, morphNone, paramApp);
 
 	par->addParam(
 		"randomizer_preview_quality", 1, morphNone, paramApp, QStringList({"low", "medium", "high"}));
@@ -548,6 +577,7 @@ void InitParams(cParameterContainer *par)
 	par->addParam("specular_enabled", false, morphNone, paramApp);
 	par->addParam("diffuse_enabled", false, morphNone, paramApp);
 	par->addParam("world_enabled", false, morphNone, paramApp);
+	par->addParam("sampleCount_enabled", false, morphNone, paramApp);
 
 	par->addParam("color_quality", int(ImageFileSave::IMAGE_CHANNEL_QUALITY_8), morphNone, paramApp);
 	par->addParam("alpha_quality", int(ImageFileSave::IMAGE_CHANNEL_QUALITY_8), morphNone, paramApp);
@@ -562,6 +592,8 @@ void InitParams(cParameterContainer *par)
 	par->addParam(
 		"diffuse_quality", int(ImageFileSave::IMAGE_CHANNEL_QUALITY_32), morphNone, paramApp);
 	par->addParam("world_quality", int(ImageFileSave::IMAGE_CHANNEL_QUALITY_32), morphNone, paramApp);
+	par->addParam(
+		"sampleCount_quality", int(ImageFileSave::IMAGE_CHANNEL_QUALITY_16), morphNone, paramApp);
 
 	par->addParam("color_postfix", QString(""), morphNone, paramApp);
 	par->addParam("alpha_postfix", QString("_alpha"), morphNone, paramApp);
@@ -571,6 +603,7 @@ void InitParams(cParameterContainer *par)
 	par->addParam("specular_postfix", QString("_specular"), morphNone, paramApp);
 	par->addParam("diffuse_postfix", QString("_diffuse"), morphNone, paramApp);
 	par->addParam("world_postfix", QString("_world"), morphNone, paramApp);
+	par->addParam("sampleCount_postfix", QString("_sampleCount"), morphNone, paramApp);
 
 	par->addParam("append_alpha_png", true, morphNone, paramApp);
 	par->addParam("linear_colorspace", true, morphNone, paramApp);
@@ -1043,6 +1043,7 @@ void cInterface::RefreshPostEffects()
 				sRenderData data;
 				data.stopRequest = &stopRequest;
 				data.screenRegion = cRegion<int>(0, 0, mainImage->GetWidth(), mainImage->GetHeight());
+				data.frameRegion = data.screenRegion;
 				cRenderSSAO rendererSSAO(&params, &data, mainImage);
 				QObject::connect(&rendererSSAO,
 					SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), mainWindow,
@@ -1080,10 +1081,16 @@ void cInterface::RefreshPostEffects()
 					mainWindow, SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
 				connect(&dof, SIGNAL(updateImage()), renderedImage, SLOT(update()));
 				cRegion<int> screenRegion(0, 0, mainImage->GetWidth(), mainImage->GetHeight());
-				dof.Render(screenRegion,
-					params.DOFRadius * (mainImage->GetWidth() + mainImage->GetHeight()) / 2000.0,
-					params.DOFFocus, params.DOFNumberOfPasses, params.DOFBlurOpacity, params.DOFMaxRadius,
-					&stopRequest);
+				double deep = params.DOFRadius * (mainImage->GetWidth() + mainImage->GetHeight()) / 2000.0;
+				if (params.DOFLayered)
+				{
+					dof.RenderLayered(screenRegion, deep, params.DOFFocus, params.DOFMaxRadius, &stopRequest);
+				}
+				else
+				{
+					dof.Render(screenRegion, deep, params.DOFFocus, params.DOFNumberOfPasses,
+						params.DOFBlurOpacity, params.DOFMaxRadius, &stopRequest);
+				}
 			}
 		}
 
@@ -2605,7 +2612,8 @@ void cInterface::ResetFormula(int fractalNumber) const
 	QStringList listToReset = {"formula_iterations", "formula_weight", "formula_start_iteration",
 		"formula_stop_iteration", "julia_mode", "julia_c", "fractal_constant_factor", "initial_waxis",
 		"formula_position", "formula_rotation", "formula_repeat", "formula_scale",
-		"dont_add_c_constant", "check_for_bailout"};
+		"dont_add_c_constant", "check_for_bailout", "formula_bounding_sphere_enabled",
+		"formula_bounding_sphere_radius"};
 
 	for (int i = 0; i < listToReset.size(); i++)
 	{
@@ -34,6 +34,9 @@
 
 #include "lights.hpp"
 
+#include <algorithm>
+
+#include "bvh_builder.hpp"
 #include "calculate_distance.hpp"
 #include "common_math.h"
 #include "fractal_container.hpp"
@@ -183,6 +186,8 @@ void cLights::Set(const cParameterContainer *_params, const cFractalContainer *_
 		}
 	}
 
+	BuildInfluenceVolumes(params->auxLightInfluenceThreshold);
+
 	lightsReady = true;
 
 	delete params;
@@ -218,9 +223,45 @@ void cLights::Copy(const cLights &_lights)
 	if (lights) delete[] lights;
 	lights = new sLight[numberOfLights];
 	isAnyLight = _lights.isAnyLight;
+	influenceNodes = _lights.influenceNodes;
 
 	for (int i = 0; i < numberOfLights; i++)
 	{
 		lights[i] = _lights.lights[i];
 	}
 }
+
+void cLights::BuildInfluenceVolumes(double influenceThreshold)
+{
+	influenceNodes.clear();
+	if (influenceThreshold <= 0.0) return;
+
+	// the same intensity formula as in cRenderWorker::LightShading():
+	// 100 * intensity / distance^2 / number / 6
+	int number = max(numberOfLights, 4);
+
+	QVector<sLightBvhNode> leafs;
+	for (int i = 0; i < numberOfLights; i++)
+	{
+		if (!lights[i].enabled) continue;
+
+		sLightBvhNode leaf;
+		leaf.influenceRadius =
+			sqrt(100.0 * max(double(lights[i].intensity), 0.0) / (number * 6.0 * influenceThreshold));
+		CVector3 radius(leaf.influenceRadius, leaf.influenceRadius, leaf.influenceRadius);
+		leaf.boxMin = lights[i].position - radius;
+		leaf.boxMax = lights[i].position + radius;
+		leaf.firstChild = -1;
+		leaf.lightIndex = i;
+		leafs.append(leaf);
+	}
+
+	if (leafs.isEmpty()) return;
+
+	// light position is in the center of the box, so leafs are split by light positions
+	BuildBvh(&influenceNodes, &leafs,
+		[](sLightBvhNode *node, const sLightBvhNode &, const sLightBvhNode &) {
+			node->influenceRadius = 0.0;
+			node->lightIndex = -1;
+		});
+}
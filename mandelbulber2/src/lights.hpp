@@ -36,6 +36,7 @@
 #define MANDELBULBER2_SRC_LIGHTS_HPP_
 
 #include <QObject>
+#include <QVector>
 
 #include "algebra.hpp"
 #include "color_structures.hpp"
@@ -53,6 +54,17 @@ struct sLight
 	sLight() {}
 };
 
+// node of bounding volume hierarchy of light influence spheres
+struct sLightBvhNode
+{
+	CVector3 boxMin;
+	CVector3 boxMax;
+	double influenceRadius;
+	// children are stored at firstChild and firstChild + 1. Leaf has firstChild = -1
+	int firstChild;
+	int lightIndex;
+};
+
 class cLights : public QObject
 {
 	Q_OBJECT
@@ -66,14 +78,57 @@ public:
 	int GetNumberOfLights() const { return numberOfLights; }
 	int IsAnyLightEnabled() const { return isAnyLight; };
 
+	// calls function(const sLight &) for every enabled light. When influence threshold is used,
+	// lights which are too far to reach the threshold at the point are skipped
+	template <typename Function>
+	void ForEachLight(const CVector3 &point, Function function) const
+	{
+		if (!lightsReady) return;
+
+		if (influenceNodes.isEmpty())
+		{
+			for (int i = 0; i < numberOfLights; i++)
+			{
+				if (lights[i].enabled) function(lights[i]);
+			}
+			return;
+		}
+
+		// tree is balanced, so stack depth is limited by log2 of number of lights
+		int stack[64];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const sLightBvhNode &node = influenceNodes.at(stack[--stackSize]);
+			if (point.x < node.boxMin.x || point.x > node.boxMax.x || point.y < node.boxMin.y
+					|| point.y > node.boxMax.y || point.z < node.boxMin.z || point.z > node.boxMax.z)
+				continue;
+
+			if (node.firstChild < 0)
+			{
+				const sLight &light = lights[node.lightIndex];
+				CVector3 d = light.position - point;
+				if (d.Dot(d) < node.influenceRadius * node.influenceRadius) function(light);
+			}
+			else
+			{
+				stack[stackSize++] = node.firstChild;
+				stack[stackSize++] = node.firstChild + 1;
+			}
+		}
+	}
+
 private:
 	void Copy(const cLights &);
+	void BuildInfluenceVolumes(double influenceThreshold);
 
 	sLight *lights;
 	sLight dummyLight;
 	int numberOfLights;
 	bool lightsReady;
 	bool isAnyLight;
+	QVector<sLightBvhNode> influenceNodes;
 
 signals:
 	void updateProgressAndStatus(const QString &text, const QString &progressText, double progress);
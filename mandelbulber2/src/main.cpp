@@ -52,6 +52,7 @@
 #include "queue.hpp"
 #include "render_data.hpp"
 #include "render_window.hpp"
+#include "render_worker_pool.hpp"
 #include "rendered_image_widget.hpp"
 #include "settings.hpp"
 #include "system.hpp"
@@ -146,6 +147,9 @@ int main(int argc, char *argv[])
 	// Netrender
 	gNetRender = new cNetRender();
 
+	// threads for CPU rendering
+	gRenderWorkerPool = new cRenderWorkerPool();
+
 	// loading AppSettings
 	QString iniFileName = systemData.GetIniFile();
 	if (QFile(iniFileName).exists())
@@ -244,6 +248,7 @@ int main(int argc, char *argv[])
 	delete gKeyframes;
 	delete gNetRender;
 	delete gQueue;
+	delete gRenderWorkerPool;
 #ifdef USE_OPENCL
 	delete gOpenCl;
 #endif
@@ -447,8 +447,7 @@ __declspec(target(mic))
 
 	double dist = CalculateDistance(*params, *fractals, distanceIn, &distanceOut, renderData);
 
-	cObjectData objectData = renderData->objectData[distanceOut.objectId];
-	cMaterial *material = &renderData->materials[objectData.materialId];
+	cMaterial *material = renderData->GetObjectMaterial(distanceOut.objectId);
 
 	sFractalIn fractIn(point, params->minN, params->N, &params->common, -1, false, material);
 	sFractalOut fractOut;
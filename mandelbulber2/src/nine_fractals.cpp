@@ -71,6 +71,7 @@ cNineFractals::cNineFractals(const cFractalContainer *par, const cParameterConta
 	double commonBailout = generalPar->Get<double>("bailout");
 	isHybrid = generalPar->Get<bool>("hybrid_fractal_enable");
 	isBoolean = generalPar->Get<bool>("boolean_operators");
+	useSpecializedCompute = !isHybrid;
 	double maxBailout = 0.0;
 
 	// getting data from all formuala slots
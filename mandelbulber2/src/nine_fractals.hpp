@@ -60,6 +60,9 @@ public:
 	sFractal **fractals;
 	int GetSequence(const int i) const;
 	bool IsHybrid() const { return isHybrid; }
+	// Compute() may use loop specialized for single (not hybrid) formula
+	inline bool UseSpecializedCompute() const { return useSpecializedCompute; }
+	void DisableSpecializedCompute() { useSpecializedCompute = false; }
 	fractal::enumDEType GetDEType(int formulaIndex) const;
 	fractal::enumDEFunctionType GetDEFunctionType(int formulaIndex) const;
 	inline double GetWeight(int formulaIndex) const { return formulaWeight[formulaIndex]; }
@@ -104,6 +107,7 @@ private:
 	bool forceAnalyticDE;
 	bool isHybrid;
 	bool isBoolean;
+	bool useSpecializedCompute;
 	fractal::enumDEFunctionType optimizedDEType;
 	bool useOptimizedDE;
 	int maxFractalIndex;
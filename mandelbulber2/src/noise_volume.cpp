@@ -0,0 +1,121 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cNoiseVolume class - multi-octave Perlin noise precalculated in a tileable 3D texture
+ */
+
+#include "noise_volume.hpp"
+
+#include <cmath>
+
+#include "perlin_noise_octaves.h"
+#include "write_log.hpp"
+
+QMutex cNoiseVolume::cacheMutex;
+QSharedPointer<const cNoiseVolume> cNoiseVolume::cache;
+
+QSharedPointer<const cNoiseVolume> cNoiseVolume::Get(const sSettings &settings)
+{
+	QMutexLocker lock(&cacheMutex);
+	if (!cache || !(cache->settings == settings))
+	{
+		// the old volume is freed before baking (unless it's still used by some worker)
+		cache.reset();
+		cache.reset(new cNoiseVolume(settings));
+	}
+	return cache;
+}
+
+cNoiseVolume::cNoiseVolume(const sSettings &_settings) : settings(_settings)
+{
+	int resolution = settings.resolution;
+	if (resolution * settings.tile > maxSize) resolution = qMax(1, maxSize / settings.tile);
+	size = resolution * settings.tile;
+	voxelsPerUnit = resolution;
+
+	// octaves with period shorter than two voxels can't be represented in the volume. They are
+	// skipped, but the amplitude is normalized for all octaves like in the analytic noise
+	int bakedOctaves = 1;
+	while (bakedOctaves < settings.octaves && (2 << bakedOctaves) <= resolution)
+		bakedOctaves++;
+	const double amplitudeRatio =
+		cPerlinNoiseOctaves::Weight(bakedOctaves) / cPerlinNoiseOctaves::Weight(settings.octaves);
+
+	WriteLog(QString("Baking noise volume: %1^3 voxels, %2 octaves").arg(size).arg(bakedOctaves), 2);
+
+	voxels.resize(size_t(size) * size * size);
+	cPerlinNoiseOctaves perlinNoise(settings.seed);
+
+#pragma omp parallel for
+	for (int z = 0; z < size; z++)
+	{
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				double noise = perlinNoise.normalizedOctaveNoise3DTiled_0_1(x / voxelsPerUnit,
+					y / voxelsPerUnit, z / voxelsPerUnit, bakedOctaves, settings.tile);
+				voxels[(size_t(z) * size + y) * size + x] = float((noise - 0.5) * amplitudeRatio + 0.5);
+			}
+		}
+	}
+}
+
+double cNoiseVolume::Noise(double x, double y, double z) const
+{
+	x *= voxelsPerUnit;
+	y *= voxelsPerUnit;
+	z *= voxelsPerUnit;
+
+	const double fx = std::floor(x);
+	const double fy = std::floor(y);
+	const double fz = std::floor(z);
+
+	// voxel coordinates wrapped to the size of the volume
+	const int x0 = int(fx - std::floor(fx / size) * size) % size;
+	const int y0 = int(fy - std::floor(fy / size) * size) % size;
+	const int z0 = int(fz - std::floor(fz / size) * size) % size;
+	const int x1 = (x0 + 1) % size;
+	const int y1 = (y0 + 1) % size;
+	const int z1 = (z0 + 1) % size;
+
+	const double u = x - fx;
+	const double v = y - fy;
+	const double w = z - fz;
+
+	const double c00 = Voxel(x0, y0, z0) + (Voxel(x1, y0, z0) - Voxel(x0, y0, z0)) * u;
+	const double c10 = Voxel(x0, y1, z0) + (Voxel(x1, y1, z0) - Voxel(x0, y1, z0)) * u;
+	const double c01 = Voxel(x0, y0, z1) + (Voxel(x1, y0, z1) - Voxel(x0, y0, z1)) * u;
+	const double c11 = Voxel(x0, y1, z1) + (Voxel(x1, y1, z1) - Voxel(x0, y1, z1)) * u;
+	const double c0 = c00 + (c10 - c00) * v;
+	const double c1 = c01 + (c11 - c01) * v;
+	return c0 + (c1 - c0) * w;
+}
@@ -0,0 +1,91 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cNoiseVolume class - multi-octave Perlin noise precalculated in a tileable 3D texture
+ *
+ * The volume covers 'tile' noise periods in every direction and is repeated in space. Values
+ * between voxels are interpolated trilinearly. The last baked volume is cached, so it is shared
+ * read-only by all render threads and reused in the next animation frames until the settings
+ * are changed.
+ */
+
+#ifndef MANDELBULBER2_SRC_NOISE_VOLUME_HPP_
+#define MANDELBULBER2_SRC_NOISE_VOLUME_HPP_
+
+#include <vector>
+
+#include <QMutex>
+#include <QSharedPointer>
+
+class cNoiseVolume
+{
+public:
+	struct sSettings
+	{
+		int seed;
+		int octaves;
+		// voxels per noise period
+		int resolution;
+		// size of the volume in noise periods
+		int tile;
+
+		bool operator==(const sSettings &other) const
+		{
+			return seed == other.seed && octaves == other.octaves && resolution == other.resolution
+						 && tile == other.tile;
+		}
+	};
+
+	// returns the volume for given settings. It's baked only if the cached one doesn't match
+	static QSharedPointer<const cNoiseVolume> Get(const sSettings &settings);
+
+	// noise in the range [0, 1] with the same coordinates as
+	// cPerlinNoiseOctaves::normalizedOctaveNoise3D_0_1()
+	double Noise(double x, double y, double z) const;
+
+private:
+	explicit cNoiseVolume(const sSettings &settings);
+
+	float Voxel(int x, int y, int z) const { return voxels[(size_t(z) * size + y) * size + x]; }
+
+	sSettings settings;
+	int size;
+	double voxelsPerUnit;
+	std::vector<float> voxels;
+
+	static QMutex cacheMutex;
+	static QSharedPointer<const cNoiseVolume> cache;
+
+	// limit of volume size (256^3 voxels = 64 MB)
+	static const int maxSize = 256;
+};
+
+#endif /* MANDELBULBER2_SRC_NOISE_VOLUME_HPP_ */
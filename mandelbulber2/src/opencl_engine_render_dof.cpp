@@ -86,28 +86,33 @@ bool cOpenClEngineRenderDOF::RenderDOF(const sParamRender *paramRender,
 	cProgressText progressText;
 	progressText.ResetTimer();
 
-	dofEnginePhase1->Lock();
-	dofEnginePhase1->SetParameters(paramRender, screenRegion);
 	bool result = false;
-	if (dofEnginePhase1->LoadSourcesAndCompile(params))
+
+	// layered DOF is rendered only on CPU
+	if (!paramRender->DOFLayered)
 	{
-		dofEnginePhase1->CreateKernel4Program(params);
-		quint64 neededMem = dofEnginePhase1->CalcNeededMemory();
-		WriteLogDouble("OpenCl render DOF Phase 1 - needed mem:", neededMem / 1048576.0, 2);
-		if (neededMem / 1048576 < size_t(params->Get<int>("opencl_memory_limit")))
-		{
-			dofEnginePhase1->PreAllocateBuffers(params);
-			dofEnginePhase1->CreateCommandQueue();
-			result = dofEnginePhase1->Render(image, stopRequest);
-		}
-		else
+		dofEnginePhase1->Lock();
+		dofEnginePhase1->SetParameters(paramRender, screenRegion);
+		if (dofEnginePhase1->LoadSourcesAndCompile(params))
 		{
-			qCritical() << "Not enough GPU mem!";
-			result = false;
+			dofEnginePhase1->CreateKernel4Program(params);
+			quint64 neededMem = dofEnginePhase1->CalcNeededMemory();
+			WriteLogDouble("OpenCl render DOF Phase 1 - needed mem:", neededMem / 1048576.0, 2);
+			if (neededMem / 1048576 < size_t(params->Get<int>("opencl_memory_limit")))
+			{
+				dofEnginePhase1->PreAllocateBuffers(params);
+				dofEnginePhase1->CreateCommandQueue();
+				result = dofEnginePhase1->Render(image, stopRequest);
+			}
+			else
+			{
+				qCritical() << "Not enough GPU mem!";
+				result = false;
+			}
 		}
+		dofEnginePhase1->ReleaseMemory();
+		dofEnginePhase1->Unlock();
 	}
-	dofEnginePhase1->ReleaseMemory();
-	dofEnginePhase1->Unlock();
 
 	if (!result)
 	{
@@ -116,10 +121,17 @@ bool cOpenClEngineRenderDOF::RenderDOF(const sParamRender *paramRender,
 			SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
 		connect(&dof, SIGNAL(updateImage()), this, SIGNAL(updateImage()));
 
-		dof.Render(screenRegion,
-			paramRender->DOFRadius * (screenRegion.width + screenRegion.height) / 2000.0,
-			paramRender->DOFFocus, paramRender->DOFNumberOfPasses, paramRender->DOFBlurOpacity,
-			paramRender->DOFMaxRadius, stopRequest);
+		double deep = paramRender->DOFRadius * (screenRegion.width + screenRegion.height) / 2000.0;
+		if (paramRender->DOFLayered)
+		{
+			dof.RenderLayered(
+				screenRegion, deep, paramRender->DOFFocus, paramRender->DOFMaxRadius, stopRequest);
+		}
+		else
+		{
+			dof.Render(screenRegion, deep, paramRender->DOFFocus, paramRender->DOFNumberOfPasses,
+				paramRender->DOFBlurOpacity, paramRender->DOFMaxRadius, stopRequest);
+		}
 
 		// refresh image at end
 		WriteLog("image->CompileImage()", 2);
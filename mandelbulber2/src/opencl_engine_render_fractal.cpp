@@ -553,10 +553,17 @@ void cOpenClEngineRenderFractal::SetParametersForShaders(
 			definesCollector += " -DAO_MODE_MULTIPLE_RAYS";
 	}
 	if (paramRender->slowShading) definesCollector += " -DSLOW_SHADING";
+	if (paramRender->slowShadingAdaptive) definesCollector += " -DSLOW_SHADING_ADAPTIVE";
+	if (paramRender->normalVectorMode == params::normalVectorTetrahedral)
+		definesCollector += " -DNORMAL_VECTOR_TETRAHEDRAL";
 
 	if (renderData->lights.IsAnyLightEnabled())
 	{
 		definesCollector += " -DAUX_LIGHTS";
+		if (paramRender->auxLightInfluenceThreshold > 0.0)
+			definesCollector += " -DAUX_LIGHTS_INFLUENCE_CULLING";
+		if (paramRender->DOFMonteCarlo && paramRender->auxLightMonteCarloSampling)
+			definesCollector += " -DAUX_LIGHTS_MC_SAMPLING";
 		if (paramRender->auxLightVisibility > 0.0)
 		{
 			definesCollector += " -DVISIBLE_AUX_LIGHTS";
@@ -840,7 +847,10 @@ void cOpenClEngineRenderFractal::SetParameters(const cParameterContainer *paramC
 	if (meshExportMode) definesCollector += " -DMESH_EXPORT";
 	if (distanceMode) definesCollector += " -DDISTANCE_CALCULATION_MODE";
 	if (paramRender->limitsEnabled) definesCollector += " -DLIMITS_ENABLED";
+	if (paramRender->boundingSphereEnabled) definesCollector += " -DBOUNDING_SPHERE_ENABLED";
 	if (paramRender->advancedQuality) definesCollector += " -DADVANCED_QUALITY";
+	if (cRenderWorker::UseOverRelaxation(paramRender, renderData))
+		definesCollector += " -DOVER_RELAXATION";
 
 	// define distance estimation method
 	SetParametersForDistanceEstimationMethod(fractals, paramRender);
@@ -1161,7 +1171,8 @@ int cOpenClEngineRenderFractal::PeriodicRefreshOfTiles(int lastRefreshTime,
 {
 	timerImageRefresh.restart();
 	image->NullPostEffect(&lastRenderedRects);
-	image->CompileImage(&lastRenderedRects);
+	// in compact storage mode 16-bit image is not needed before the end of rendering
+	if (!image->IsCompactStorage() || image->IsPreview()) image->CompileImage(&lastRenderedRects);
 	if (image->IsPreview())
 	{
 		image->ConvertTo8bit(&lastRenderedRects);
@@ -247,6 +247,72 @@ double cPerlinNoiseOctaves::normalizedOctaveNoise3D_0_1(
 	return normalizedOctaveNoise3D(x, y, z, octaves) * double(0.5) + double(0.5);
 }
 
+///////////////////////////////////////
+//
+//	Tileable noise
+//
+
+double cPerlinNoiseOctaves::noise3DTiled(double x, double y, double z, std::int32_t period) const
+{
+	// lattice coordinates are wrapped to the period and then to the size of permutation table
+	auto wrap = [period](double v) {
+		return static_cast<std::int32_t>(v - std::floor(v / period) * period) % period;
+	};
+
+	const double fx = std::floor(x);
+	const double fy = std::floor(y);
+	const double fz = std::floor(z);
+
+	const std::int32_t X0 = wrap(fx);
+	const std::int32_t Y0 = wrap(fy);
+	const std::int32_t Z0 = wrap(fz);
+	const std::int32_t X1 = ((X0 + 1) % period) & 255;
+	const std::int32_t Y1 = ((Y0 + 1) % period) & 255;
+	const std::int32_t Z1 = ((Z0 + 1) % period) & 255;
+	const std::int32_t X = X0 & 255;
+	const std::int32_t Y = Y0 & 255;
+	const std::int32_t Z = Z0 & 255;
+
+	x -= fx;
+	y -= fy;
+	z -= fz;
+
+	const double u = Fade(x);
+	const double v = Fade(y);
+	const double w = Fade(z);
+
+	const std::int32_t A0 = p[p[X] + Y];
+	const std::int32_t A1 = p[p[X] + Y1];
+	const std::int32_t B0 = p[p[X1] + Y];
+	const std::int32_t B1 = p[p[X1] + Y1];
+
+	return Lerp(w,
+		Lerp(v, Lerp(u, Grad(p[A0 + Z], x, y, z), Grad(p[B0 + Z], x - 1, y, z)),
+			Lerp(u, Grad(p[A1 + Z], x, y - 1, z), Grad(p[B1 + Z], x - 1, y - 1, z))),
+		Lerp(v, Lerp(u, Grad(p[A0 + Z1], x, y, z - 1), Grad(p[B0 + Z1], x - 1, y, z - 1)),
+			Lerp(u, Grad(p[A1 + Z1], x, y - 1, z - 1), Grad(p[B1 + Z1], x - 1, y - 1, z - 1))));
+}
+
+double cPerlinNoiseOctaves::normalizedOctaveNoise3DTiled_0_1(
+	double x, double y, double z, std::int32_t octaves, std::int32_t period) const
+{
+	double result = 0;
+	double amp = 1;
+
+	for (std::int32_t i = 0; i < octaves; ++i)
+	{
+		result += noise3DTiled(x, y, z, period) * amp;
+		x *= 2.0;
+		y *= 2.0;
+		z *= 2.0;
+		// for multiples of 256 wrapping is done by the permutation table, so period can stop growing
+		if (period % 256 != 0) period *= 2;
+		amp /= 2.0;
+	}
+
+	return result / Weight(octaves) * double(0.5) + double(0.5);
+}
+
 ///////////////////////////////////////
 //
 //	Serialization
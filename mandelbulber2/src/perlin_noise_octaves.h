@@ -135,6 +135,16 @@ public:
 	double normalizedOctaveNoise2D_0_1(double x, double y, std::int32_t octaves) const;
 	double normalizedOctaveNoise3D_0_1(double x, double y, double z, std::int32_t octaves) const;
 
+	///////////////////////////////////////
+	//
+	//	Tileable noise
+	//	* Noise repeats every 'period' units (in coordinates of the first octave)
+	//
+
+	double noise3DTiled(double x, double y, double z, std::int32_t period) const;
+	double normalizedOctaveNoise3DTiled_0_1(
+		double x, double y, double z, std::int32_t octaves, std::int32_t period) const;
+
 	///////////////////////////////////////
 	//
 	//	Serialization
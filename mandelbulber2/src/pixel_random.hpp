@@ -0,0 +1,82 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cPixelRandom - counter based random number generator for render threads
+ *
+ * Sequence of numbers depends only on frame, pixel and sample index (not on thread which renders
+ * the pixel), so image rendered with the same settings is the same for any number of threads.
+ * Generator is based on PCG32 (http://www.pcg-random.org/) with state initialized by SplitMix64
+ * hash of the counters.
+ */
+
+#ifndef MANDELBULBER2_SRC_PIXEL_RANDOM_HPP_
+#define MANDELBULBER2_SRC_PIXEL_RANDOM_HPP_
+
+#include <cstdint>
+
+class cPixelRandom
+{
+public:
+	cPixelRandom() { state = 0x853c49e6748fea9bULL; }
+
+	// starts new sequence for given frame, pixel and sample
+	inline void Seed(int frame, int x, int y, int sample)
+	{
+		uint64_t pixel = (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+		uint64_t counter = (uint64_t(uint32_t(frame)) << 32) | uint32_t(sample);
+		state = Hash(pixel ^ Hash(counter));
+	}
+
+	// returns random number from 0 to max (the same range as global Random())
+	inline int Random(int max) { return int(NextUInt() % (uint32_t(max) + 1)); }
+
+private:
+	inline uint32_t NextUInt()
+	{
+		uint64_t oldState = state;
+		state = oldState * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint32_t xorShifted = uint32_t(((oldState >> 18) ^ oldState) >> 27);
+		uint32_t rot = uint32_t(oldState >> 59);
+		return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+	}
+
+	static inline uint64_t Hash(uint64_t x)
+	{
+		x += 0x9e3779b97f4a7c15ULL;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	uint64_t state;
+};
+
+#endif /* MANDELBULBER2_SRC_PIXEL_RANDOM_HPP_ */
@@ -34,6 +34,10 @@
 
 #include "post_effect_hdr_blur.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "cimage.hpp"
 #include "global_data.hpp"
 #include "progress_text.hpp"
@@ -53,10 +57,33 @@ cPostEffectHdrBlur::~cPostEffectHdrBlur()
 
 void cPostEffectHdrBlur::Render(bool *stopRequest)
 {
+	const sRGBFloat *postImage = image->GetPostImageFloatPtr();
+	if (postImage)
+	{
+		memcpy(tempImage, postImage, image->GetHeight() * image->GetWidth() * sizeof(sRGBFloat));
+	}
+	else
+	{
+		// image stored in half precision
+		const qint64 width = qint64(image->GetWidth());
+#pragma omp parallel for
+		for (qint64 y = 0; y < qint64(image->GetHeight()); y++)
+		{
+			for (qint64 x = 0; x < width; x++)
+				tempImage[x + y * width] = image->GetPixelPostImage(x, y);
+		}
+	}
 
-	memcpy(tempImage, image->GetPostImageFloatPtr(),
-		image->GetHeight() * image->GetWidth() * sizeof(sRGBFloat));
+	const double blurSize = radius * (image->GetWidth() + image->GetHeight()) * 0.001;
+	if (blurSize <= maxDirectBlurSize)
+		RenderDirect(stopRequest);
+	else
+		RenderSeparable(stopRequest);
+}
 
+// brute-force gather over the whole kernel window
+void cPostEffectHdrBlur::RenderDirect(bool *stopRequest)
+{
 	const double blurSize = radius * (image->GetWidth() + image->GetHeight()) * 0.001;
 	const double blurSize2 = blurSize * blurSize;
 	const int intBlurSize = int(blurSize + 1);
@@ -96,7 +123,7 @@ void cPostEffectHdrBlur::Render(bool *stopRequest)
 					double r2 = dx * dx + dy * dy;
 					if (r2 < blurSize2)
 					{
-						double value = 1.0 / (r2 / (0.2 * blurSize) + limiter);
+						double value = KernelValue(r2, blurSize, limiter);
 						// if(dx == 0 && dy == 0) value = 10.0;
 						weight += value;
 						sRGBFloat oldPixel = tempImage[xx + yy * image->GetWidth()];
@@ -131,6 +158,343 @@ void cPostEffectHdrBlur::Render(bool *stopRequest)
 	emit updateProgressAndStatus(statusText, progressText.getText(1.0), 1.0);
 }
 
+// exact central part of the kernel is gathered directly, and the tail is a sum of gaussians
+// calculated with separable box blur passes. Both parts are also applied to the image mask (all
+// ones inside the image), which gives the same normalization near the image borders as
+// RenderDirect()
+void cPostEffectHdrBlur::RenderSeparable(bool *stopRequest)
+{
+	const int width = int(image->GetWidth());
+	const int height = int(image->GetHeight());
+	const double blurSize = radius * (width + height) * 0.001;
+	const double limiter = intensity;
+	const int r0 = directKernelRadius;
+
+	QString statusText = QObject::tr("Rendering HDR Blur effect");
+	cProgressText progressText;
+	progressText.ResetTimer();
+
+	QVector<sGaussianComponent> components = FitKernelTail(blurSize, limiter);
+
+	// central part of the kernel: exact value minus the part covered by the gaussians
+	const int kernelWidth = 2 * r0 + 1;
+	QVector<float> nearKernel(kernelWidth * kernelWidth, 0.0f);
+	double nearKernelSum = 0.0;
+	for (int dy = -r0; dy <= r0; dy++)
+	{
+		for (int dx = -r0; dx <= r0; dx++)
+		{
+			double r2 = dx * dx + dy * dy;
+			if (r2 > r0 * r0) continue;
+			double value = KernelValue(r2, blurSize, limiter);
+			for (const sGaussianComponent &component : components)
+				value -= component.weight * exp(-r2 / (2.0 * component.sigma * component.sigma));
+			nearKernel[(dy + r0) * kernelWidth + dx + r0] = float(value);
+			nearKernelSum += value;
+		}
+	}
+
+	// gaussians of the tail applied to the mask, separately for x and y
+	QVector<QVector<int>> boxRadii;
+	QVector<QVector<float>> maskX, maskY;
+	for (const sGaussianComponent &component : components)
+	{
+		boxRadii.append(BoxRadiiForGaussian(component.sigma));
+
+		QVector<float> lineX(width, 1.0f), lineY(height, 1.0f), lineBuffer(qMax(width, height));
+		for (int boxRadius : boxRadii.last())
+		{
+			BoxBlurLine(lineX.data(), lineBuffer.data(), width, boxRadius);
+			std::copy(lineBuffer.begin(), lineBuffer.begin() + width, lineX.begin());
+			BoxBlurLine(lineY.data(), lineBuffer.data(), height, boxRadius);
+			std::copy(lineBuffer.begin(), lineBuffer.begin() + height, lineY.begin());
+		}
+		maskX.append(lineX);
+		maskY.append(lineY);
+	}
+
+	// channels are processed one by one. Unnormalized sums are accumulated in float in the channel
+	// of tempImage (original values are kept in the source buffer) and the post image is written
+	// only once, after normalization
+	std::vector<float> source(size_t(width) * height);
+	std::vector<float> channel(size_t(width) * height);
+	std::vector<float> buffer(size_t(width) * height);
+
+	int numberOfPasses = (components.size() + 1) * 3;
+	int pass = 0;
+	for (int c = 0; c < 3; c++)
+	{
+		if (*stopRequest || systemData.globalStopRequest) return;
+
+#pragma omp parallel for
+		for (qint64 i = 0; i < qint64(width) * height; i++)
+			source[i] = c == 0 ? tempImage[i].R : (c == 1 ? tempImage[i].G : tempImage[i].B);
+
+		// central part of the kernel
+#pragma omp parallel for
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				float sum = 0.0f;
+				for (int dy = -r0; dy <= r0; dy++)
+				{
+					int yy = y + dy;
+					if (yy < 0 || yy >= height) continue;
+					for (int dx = -r0; dx <= r0; dx++)
+					{
+						int xx = x + dx;
+						if (xx < 0 || xx >= width) continue;
+						sum += source[xx + qint64(yy) * width] * nearKernel[(dy + r0) * kernelWidth + dx + r0];
+					}
+				}
+				sRGBFloat &pixel = tempImage[x + qint64(y) * width];
+				(c == 0 ? pixel.R : (c == 1 ? pixel.G : pixel.B)) = sum;
+			}
+		}
+		pass++;
+
+		// gaussians of the tail, each one with three box blur passes in both directions
+		for (int k = 0; k < components.size(); k++)
+		{
+			if (*stopRequest || systemData.globalStopRequest) return;
+
+			const sGaussianComponent &component = components[k];
+			// sum of the sampled gaussian (weight of the normalized blur)
+			const float gain = float(component.weight * 2.0 * M_PI * component.sigma * component.sigma);
+
+			std::copy(source.begin(), source.end(), channel.begin());
+			for (int boxRadius : boxRadii[k])
+			{
+				BoxBlurRows(channel.data(), buffer.data(), width, height, boxRadius);
+				BoxBlurColumns(buffer.data(), channel.data(), width, height, boxRadius);
+			}
+
+#pragma omp parallel for
+			for (qint64 i = 0; i < qint64(width) * height; i++)
+			{
+				float &out = c == 0 ? tempImage[i].R : (c == 1 ? tempImage[i].G : tempImage[i].B);
+				out += channel[i] * gain;
+			}
+			pass++;
+
+			double percentDone = double(pass) / numberOfPasses;
+			emit updateProgressAndStatus(statusText, progressText.getText(percentDone), percentDone);
+			gApplication->processEvents();
+		}
+	}
+
+	// normalization by the kernel applied to the mask
+#pragma omp parallel for
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			double weight = 0.0;
+			if (x >= r0 && x < width - r0 && y >= r0 && y < height - r0)
+			{
+				weight = nearKernelSum;
+			}
+			else
+			{
+				for (int dy = -r0; dy <= r0; dy++)
+				{
+					if (y + dy < 0 || y + dy >= height) continue;
+					for (int dx = -r0; dx <= r0; dx++)
+					{
+						if (x + dx < 0 || x + dx >= width) continue;
+						weight += nearKernel[(dy + r0) * kernelWidth + dx + r0];
+					}
+				}
+			}
+			for (int k = 0; k < components.size(); k++)
+			{
+				const sGaussianComponent &component = components[k];
+				weight += component.weight * 2.0 * M_PI * component.sigma * component.sigma
+									* maskX[k][x] * maskY[k][y];
+			}
+
+			sRGBFloat pixel = tempImage[x + qint64(y) * width];
+			if (weight > 0.0)
+			{
+				pixel.R /= weight;
+				pixel.G /= weight;
+				pixel.B /= weight;
+			}
+			image->PutPixelPostImage(x, y, pixel);
+		}
+	}
+
+	emit updateProgressAndStatus(statusText, progressText.getText(1.0), 1.0);
+}
+
+double cPostEffectHdrBlur::KernelValue(double r2, double blurSize, double limiter)
+{
+	return 1.0 / (r2 / (0.2 * blurSize) + limiter);
+}
+
+// Least squares fit of the kernel outside the central part with gaussians of geometrically
+// growing sizes. Kernel is weighted by the radius (as in 2D), and is zero outside the blur size.
+// Gaussians with negative weights are removed and the fit is repeated
+QVector<cPostEffectHdrBlur::sGaussianComponent> cPostEffectHdrBlur::FitKernelTail(
+	double blurSize, double limiter)
+{
+	const int numberOfGaussians = 8;
+	const int numberOfSamples = 512;
+	const double sigmaMin = 0.5 * directKernelRadius;
+	const double sigmaMax = qMax(0.5 * blurSize, sigmaMin * 2.0);
+	const double rMin = directKernelRadius;
+	const double rMax = 1.5 * blurSize;
+
+	QVector<double> sigmas;
+	for (int k = 0; k < numberOfGaussians; k++)
+		sigmas.append(sigmaMin * pow(sigmaMax / sigmaMin, double(k) / (numberOfGaussians - 1)));
+
+	QVector<bool> active(numberOfGaussians, true);
+	QVector<double> weights(numberOfGaussians, 0.0);
+
+	for (int iteration = 0; iteration < numberOfGaussians; iteration++)
+	{
+		QVector<int> index;
+		for (int k = 0; k < numberOfGaussians; k++)
+			if (active[k]) index.append(k);
+		const int n = index.size();
+		if (n == 0) break;
+
+		// normal equations
+		QVector<double> matrix(n * (n + 1), 0.0);
+		for (int s = 0; s < numberOfSamples; s++)
+		{
+			double r = rMin + (rMax - rMin) * (s + 0.5) / numberOfSamples;
+			double r2 = r * r;
+			double target = r < blurSize ? KernelValue(r2, blurSize, limiter) : 0.0;
+			QVector<double> basis(n);
+			for (int i = 0; i < n; i++)
+				basis[i] = exp(-r2 / (2.0 * sigmas[index[i]] * sigmas[index[i]]));
+			for (int i = 0; i < n; i++)
+			{
+				for (int j = 0; j < n; j++)
+					matrix[i * (n + 1) + j] += r * basis[i] * basis[j];
+				matrix[i * (n + 1) + n] += r * basis[i] * target;
+			}
+		}
+
+		// Gaussian elimination with partial pivoting
+		for (int col = 0; col < n; col++)
+		{
+			int pivot = col;
+			for (int row = col + 1; row < n; row++)
+				if (fabs(matrix[row * (n + 1) + col]) > fabs(matrix[pivot * (n + 1) + col])) pivot = row;
+			for (int j = 0; j <= n; j++)
+				std::swap(matrix[col * (n + 1) + j], matrix[pivot * (n + 1) + j]);
+			double diagonal = matrix[col * (n + 1) + col];
+			if (diagonal == 0.0) continue;
+			for (int row = 0; row < n; row++)
+			{
+				if (row == col) continue;
+				double factor = matrix[row * (n + 1) + col] / diagonal;
+				for (int j = col; j <= n; j++)
+					matrix[row * (n + 1) + j] -= factor * matrix[col * (n + 1) + j];
+			}
+		}
+
+		int mostNegative = -1;
+		for (int i = 0; i < n; i++)
+		{
+			double diagonal = matrix[i * (n + 1) + i];
+			weights[index[i]] = diagonal != 0.0 ? matrix[i * (n + 1) + n] / diagonal : 0.0;
+			if (weights[index[i]] < 0.0
+					&& (mostNegative < 0 || weights[index[i]] < weights[mostNegative]))
+				mostNegative = index[i];
+		}
+		if (mostNegative < 0) break;
+
+		active[mostNegative] = false;
+		weights[mostNegative] = 0.0;
+	}
+
+	QVector<sGaussianComponent> components;
+	for (int k = 0; k < numberOfGaussians; k++)
+	{
+		if (active[k] && weights[k] > 0.0) components.append({sigmas[k], weights[k]});
+	}
+	return components;
+}
+
+// radii of three box blurs which approximate gaussian blur
+// (W. Kovesi, "Fast Almost-Gaussian Filtering")
+QVector<int> cPostEffectHdrBlur::BoxRadiiForGaussian(double sigma)
+{
+	const int n = 3;
+	int widthLow = int(sqrt(12.0 * sigma * sigma / n + 1.0));
+	if (widthLow % 2 == 0) widthLow--;
+	int widthHigh = widthLow + 2;
+	int m = int(round((12.0 * sigma * sigma - n * widthLow * widthLow - 4.0 * n * widthLow - 3.0 * n)
+										/ (-4.0 * widthLow - 4.0)));
+
+	QVector<int> radii;
+	for (int i = 0; i < n; i++)
+		radii.append(((i < m ? widthLow : widthHigh) - 1) / 2);
+	return radii;
+}
+
+// box blur of one line. Pixels outside the image are zero
+void cPostEffectHdrBlur::BoxBlurLine(const float *in, float *out, int length, int radius)
+{
+	const double scale = 1.0 / (2 * radius + 1);
+	double sum = 0.0;
+	for (int i = 0; i < qMin(radius, length); i++)
+		sum += in[i];
+
+	for (int i = 0; i < length; i++)
+	{
+		if (i + radius < length) sum += in[i + radius];
+		if (i - radius - 1 >= 0) sum -= in[i - radius - 1];
+		out[i] = float(sum * scale);
+	}
+}
+
+void cPostEffectHdrBlur::BoxBlurRows(
+	const float *in, float *out, int width, int height, int radius)
+{
+#pragma omp parallel for
+	for (int y = 0; y < height; y++)
+		BoxBlurLine(&in[qint64(y) * width], &out[qint64(y) * width], width, radius);
+}
+
+// columns are processed in strips, so the memory is read line by line
+void cPostEffectHdrBlur::BoxBlurColumns(
+	const float *in, float *out, int width, int height, int radius)
+{
+	const int stripWidth = 64;
+	const int numberOfStrips = (width + stripWidth - 1) / stripWidth;
+	const double scale = 1.0 / (2 * radius + 1);
+
+#pragma omp parallel for
+	for (int strip = 0; strip < numberOfStrips; strip++)
+	{
+		int x1 = strip * stripWidth;
+		int x2 = qMin(x1 + stripWidth, width);
+		double sum[stripWidth] = {};
+
+		for (int y = 0; y < qMin(radius, height); y++)
+			for (int x = x1; x < x2; x++)
+				sum[x - x1] += in[qint64(y) * width + x];
+
+		for (int y = 0; y < height; y++)
+		{
+			const float *added = (y + radius < height) ? &in[qint64(y + radius) * width] : nullptr;
+			const float *removed = (y - radius - 1 >= 0) ? &in[qint64(y - radius - 1) * width] : nullptr;
+			for (int x = x1; x < x2; x++)
+			{
+				if (added) sum[x - x1] += added[x];
+				if (removed) sum[x - x1] -= removed[x];
+				out[qint64(y) * width + x] = float(sum[x - x1] * scale);
+			}
+		}
+	}
+}
+
 void cPostEffectHdrBlur::SetParameters(double _radius, double _intensity)
 {
 	radius = _radius;
@@ -30,12 +30,18 @@
  * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
  *
  * cPostEffectHdrBlur - Renders a weighted blur which works on HDR image data
+ *
+ * Small kernels are calculated directly. Bigger kernels are split into the exact central part
+ * (radius of directKernelRadius pixels) and the tail approximated by a sum of gaussians. Each
+ * gaussian is calculated with three separable box blur passes, so the rendering time doesn't
+ * depend on the blur radius.
  */
 
 #ifndef MANDELBULBER2_SRC_POST_EFFECT_HDR_BLUR_H_
 #define MANDELBULBER2_SRC_POST_EFFECT_HDR_BLUR_H_
 
 #include <QObject>
+#include <QVector>
 
 #include "color_structures.hpp"
 
@@ -53,11 +59,35 @@ public:
 
 	void Render(bool *stopRequest);
 
+	// separable box blur helpers, also used by the layered DOF
+	static QVector<int> BoxRadiiForGaussian(double sigma);
+	static void BoxBlurLine(const float *in, float *out, int length, int radius);
+	static void BoxBlurRows(const float *in, float *out, int width, int height, int radius);
+	static void BoxBlurColumns(const float *in, float *out, int width, int height, int radius);
+
 	cImage *image;
 	sRGBFloat *tempImage;
 	double radius;
 	double intensity;
 
+private:
+	// gaussian component of the kernel tail: weight * exp(-r^2 / (2 * sigma^2))
+	struct sGaussianComponent
+	{
+		double sigma;
+		double weight;
+	};
+
+	void RenderDirect(bool *stopRequest);
+	void RenderSeparable(bool *stopRequest);
+
+	static double KernelValue(double r2, double blurSize, double limiter);
+	static QVector<sGaussianComponent> FitKernelTail(double blurSize, double limiter);
+
+	// blur sizes up to this value are rendered directly
+	static constexpr double maxDirectBlurSize = 16.0;
+	static constexpr int directKernelRadius = 4;
+
 signals:
 	void updateProgressAndStatus(const QString &text, const QString &progressText, double progress);
 };
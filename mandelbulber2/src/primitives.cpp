@@ -34,10 +34,14 @@
 
 #include "primitives.h"
 
+#include <algorithm>
+
 #include <QtAlgorithms>
 
+#include "bvh_builder.hpp"
 #include "common_math.h"
 #include "displacement_map.hpp"
+#include "material.h"
 #include "parameters.hpp"
 #include "write_log.hpp"
 
@@ -251,6 +255,7 @@ cPrimitives::cPrimitives(const cParameterContainer *par, QVector<cObjectData> *o
 			{
 				qCritical() << "cannot handle " << PrimitiveNames(item.type)
 										<< " in cPrimitives::cPrimitives()";
+				BuildBoundingVolumes();
 				return;
 			}
 		}
@@ -264,18 +269,34 @@ cPrimitives::cPrimitives(const cParameterContainer *par, QVector<cObjectData> *o
 		primitive->booleanOperator =
 			enumPrimitiveBooleanOperator(par->Get<int>(item.name + "_boolean_operator"));
 
+		// displacement texture can move the surface towards the point by up to its height.
+		// Negative margin means that material is not known and primitive cannot be culled
+		double displacementMargin = -1.0;
+		QString useDisplacementName =
+			cMaterial::Name("use_displacement_texture", primitive->materialId);
+		if (par->IfExists(useDisplacementName))
+		{
+			displacementMargin = 0.0;
+			if (par->Get<bool>(useDisplacementName))
+				displacementMargin = fabs(par->Get<double>(
+					cMaterial::Name("displacement_texture_height", primitive->materialId)));
+		}
+
 		if (objectData)
 		{
 			objectData->append(*primitive);
 			primitive->objectId = objectData->size() - 1;
 		}
 		allPrimitives.append(primitive);
+		displacementMargins.append(displacementMargin);
 	}
 
 	allPrimitivesPosition = par->Get<CVector3>("all_primitives_position");
 	allPrimitivesRotation = par->Get<CVector3>("all_primitives_rotation");
 	mRotAllPrimitivesRotation.SetRotation2(allPrimitivesRotation / 180.0 * M_PI);
 
+	BuildBoundingVolumes();
+
 	WriteLog("cPrimitives::cPrimitives(const cParameterContainer *par) finished", 3);
 }
 
@@ -451,6 +472,230 @@ double sPrimitiveTorus::PrimitiveDistance(CVector3 _point) const
 	return empty ? fabs(dist) : dist;
 }
 
+bool sPrimitiveBox::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	if (repeat.Length() > 0.0) return false;
+	CVector3 halfSize = CVector3(fabs(size.x), fabs(size.y), fabs(size.z)) * 0.5;
+	halfSize += CVector3(1.0, 1.0, 1.0) * max(rounding, 0.0);
+	*boxMin = halfSize * (-1.0);
+	*boxMax = halfSize;
+	*distanceFactor = 1.0;
+	return true;
+}
+
+bool sPrimitiveSphere::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	if (repeat.Length() > 0.0) return false;
+	*boxMin = CVector3(-1.0, -1.0, -1.0) * fabs(radius);
+	*boxMax = CVector3(1.0, 1.0, 1.0) * fabs(radius);
+	*distanceFactor = 1.0;
+	return true;
+}
+
+bool sPrimitiveRectangle::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	*boxMin = CVector3(-fabs(width) * 0.5, -fabs(height) * 0.5, 0.0);
+	*boxMax = CVector3(fabs(width) * 0.5, fabs(height) * 0.5, 0.0);
+	*distanceFactor = 1.0;
+	return true;
+}
+
+bool sPrimitiveCylinder::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	if (repeat.Length() > 0.0) return false;
+	*boxMin = CVector3(-fabs(radius), -fabs(radius), -fabs(height) * 0.5);
+	*boxMax = CVector3(fabs(radius), fabs(radius), fabs(height) * 0.5);
+	*distanceFactor = 1.0;
+	return true;
+}
+
+bool sPrimitiveCircle::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	*boxMin = CVector3(-fabs(radius), -fabs(radius), 0.0);
+	*boxMax = CVector3(fabs(radius), fabs(radius), 0.0);
+	*distanceFactor = 1.0;
+	return true;
+}
+
+bool sPrimitiveCone::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	if (repeat.Length() > 0.0 || radius <= 0.0 || height <= 0.0) return false;
+	*boxMin = CVector3(-radius, -radius, 0.0);
+	*boxMax = CVector3(radius, radius, height);
+
+	// distance to the wall is measured to the infinite cone, so it underestimates distance
+	// above the apex and below the base
+	double k = radius / height;
+	double wallLength = sqrt(1.0 + k * k);
+	*distanceFactor = min(1.0 / (k + wallLength), min(1.0, k) / wallLength);
+	return true;
+}
+
+bool sPrimitiveTorus::LocalBoundingBox(
+	CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+{
+	// LengthPow() is not bounded by the largest coordinate for odd or fractional powers
+	if (repeat.Length() > 0.0) return false;
+	if (radiusLPow < 1.0 || radiusLPow != floor(radiusLPow)) return false;
+	if (tubeRadiusLPow < 1.0 || tubeRadiusLPow != floor(tubeRadiusLPow)) return false;
+
+	double outerRadius = fabs(radius) + fabs(tubeRadius);
+	*boxMin = CVector3(-outerRadius, -outerRadius, -fabs(tubeRadius));
+	*boxMax = CVector3(outerRadius, outerRadius, fabs(tubeRadius));
+	*distanceFactor = 1.0;
+	return true;
+}
+
+void cPrimitives::BuildBoundingVolumes()
+{
+	// Consecutive primitives joined with OR operator can be evaluated in any order, so they are
+	// grouped into BVH trees. Other operators depend on the distance accumulated so far and
+	// are evaluated one by one in calculation order
+	bvhNodes.clear();
+	evaluationSteps.clear();
+
+	QVector<sPrimitiveBvhNode> leafs;
+	for (int i = 0; i <= allPrimitives.size(); i++)
+	{
+		if (i < allPrimitives.size())
+		{
+			const sPrimitiveBasic *primitive = allPrimitives.at(i);
+			if (!primitive->enable) continue;
+
+			CVector3 localMin, localMax;
+			double distanceFactor;
+			if (primitive->booleanOperator == primBooleanOperatorOR && displacementMargins.at(i) >= 0.0
+					&& primitive->LocalBoundingBox(&localMin, &localMax, &distanceFactor))
+			{
+				// box in the primitive space enclosing all corners of the rotated local box
+				CRotationMatrix rotationInverse = primitive->rotationMatrix.Transpose();
+				sPrimitiveBvhNode leaf;
+				leaf.boxMin = CVector3(1e20, 1e20, 1e20);
+				leaf.boxMax = CVector3(-1e20, -1e20, -1e20);
+				for (int corner = 0; corner < 8; corner++)
+				{
+					CVector3 point((corner & 1) ? localMax.x : localMin.x,
+						(corner & 2) ? localMax.y : localMin.y, (corner & 4) ? localMax.z : localMin.z);
+					point = primitive->position + rotationInverse.RotateVector(point);
+					leaf.boxMin = CVector3(
+						min(leaf.boxMin.x, point.x), min(leaf.boxMin.y, point.y), min(leaf.boxMin.z, point.z));
+					leaf.boxMax = CVector3(
+						max(leaf.boxMax.x, point.x), max(leaf.boxMax.y, point.y), max(leaf.boxMax.z, point.z));
+				}
+				// Euclidean distance to the box is at most sqrt(3) times the Chebyshev distance
+				leaf.distanceFactor = distanceFactor / sqrt(3.0);
+				leaf.displacementMargin = displacementMargins.at(i);
+				leaf.firstChild = -1;
+				leaf.primitiveIndex = i;
+				leafs.append(leaf);
+				continue;
+			}
+		}
+
+		if (!leafs.isEmpty())
+		{
+			sPrimitiveStep step;
+			step.primitiveIndex = -1;
+			step.bvhRoot = BuildBvh(&bvhNodes, &leafs,
+				[](sPrimitiveBvhNode *node, const sPrimitiveBvhNode &child1,
+					const sPrimitiveBvhNode &child2) {
+					node->distanceFactor = min(child1.distanceFactor, child2.distanceFactor);
+					node->displacementMargin = max(child1.displacementMargin, child2.displacementMargin);
+					node->primitiveIndex = -1;
+				});
+			evaluationSteps.append(step);
+			leafs.clear();
+		}
+
+		if (i < allPrimitives.size())
+		{
+			sPrimitiveStep step;
+			step.primitiveIndex = i;
+			step.bvhRoot = -1;
+			evaluationSteps.append(step);
+		}
+	}
+}
+
+double cPrimitives::BvhNodeLowerBound(const sPrimitiveBvhNode &node, const CVector3 &point) const
+{
+	double dx = max(max(node.boxMin.x - point.x, point.x - node.boxMax.x), 0.0);
+	double dy = max(max(node.boxMin.y - point.y, point.y - node.boxMax.y), 0.0);
+	double dz = max(max(node.boxMin.z - point.z, point.z - node.boxMax.z), 0.0);
+	double boxDistance = sqrt(dx * dx + dy * dy + dz * dz);
+
+	// inside of the box primitive distance can be negative without limit
+	if (boxDistance <= 0.0) return -1e20;
+	return boxDistance * node.distanceFactor - node.displacementMargin;
+}
+
+void cPrimitives::BvhDistance(
+	int root, CVector3 point, double *distance, int *closestObject, sRenderData *data) const
+{
+	// nodes are skipped when lower bound of their distance is not smaller than current distance.
+	// For OR operator such primitives cannot change distance nor the closest object.
+	// Tree is balanced, so stack depth is limited by log2 of number of primitives
+	const int maxStackSize = 64;
+	int stackNodes[maxStackSize];
+	double stackBounds[maxStackSize];
+	int stackSize = 0;
+
+	stackNodes[stackSize] = root;
+	stackBounds[stackSize] = BvhNodeLowerBound(bvhNodes.at(root), point);
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		if (stackBounds[stackSize] >= *distance) continue;
+
+		const sPrimitiveBvhNode &node = bvhNodes.at(stackNodes[stackSize]);
+		if (node.firstChild < 0)
+		{
+			const sPrimitiveBasic *primitive = allPrimitives.at(node.primitiveIndex);
+			double distTemp = primitive->PrimitiveDistance(point);
+			distTemp = DisplacementMap(distTemp, point, primitive->objectId, data);
+			if (distTemp < *distance)
+			{
+				*closestObject = primitive->objectId;
+				*distance = distTemp;
+			}
+		}
+		else
+		{
+			int closerChild = node.firstChild;
+			int furtherChild = node.firstChild + 1;
+			double closerBound = BvhNodeLowerBound(bvhNodes.at(closerChild), point);
+			double furtherBound = BvhNodeLowerBound(bvhNodes.at(furtherChild), point);
+			if (furtherBound < closerBound)
+			{
+				swap(closerChild, furtherChild);
+				swap(closerBound, furtherBound);
+			}
+
+			// closer child is visited first, so it can shrink the distance for the other one
+			if (furtherBound < *distance)
+			{
+				stackNodes[stackSize] = furtherChild;
+				stackBounds[stackSize] = furtherBound;
+				stackSize++;
+			}
+			if (closerBound < *distance)
+			{
+				stackNodes[stackSize] = closerChild;
+				stackBounds[stackSize] = closerBound;
+				stackSize++;
+			}
+		}
+	}
+}
+
 double cPrimitives::TotalDistance(CVector3 point, double fractalDistance, double detailSize,
 	bool normalCalculationMode, int *closestObjectId, sRenderData *data) const
 {
@@ -463,110 +708,118 @@ double cPrimitives::TotalDistance(CVector3 point, double fractalDistance, double
 		CVector3 point2 = point - allPrimitivesPosition;
 		point2 = mRotAllPrimitivesRotation.RotateVector(point2);
 
-		for (auto primitive : allPrimitives)
+		for (const sPrimitiveStep &step : evaluationSteps)
 		{
-			if (primitive->enable)
+			if (step.bvhRoot >= 0)
 			{
-				sPrimitiveWater *water = dynamic_cast<sPrimitiveWater *>(primitive);
-				double distTemp;
-				if (water)
-				{
-					distTemp = water->PrimitiveDistanceWater(point2, distance);
-				}
-				else
+				BvhDistance(step.bvhRoot, point2, &distance, &closestObject, data);
+				continue;
+			}
+
+			sPrimitiveBasic *primitive = allPrimitives.at(step.primitiveIndex);
+
+			// subtraction doesn't change anything when the point is not inside previous objects
+			if (primitive->booleanOperator == primBooleanOperatorSUB && distance >= detailSize) continue;
+
+			sPrimitiveWater *water = dynamic_cast<sPrimitiveWater *>(primitive);
+			double distTemp;
+			if (water)
+			{
+				distTemp = water->PrimitiveDistanceWater(point2, distance);
+			}
+			else
+			{
+				distTemp = primitive->PrimitiveDistance(point2);
+			}
+			distTemp = DisplacementMap(distTemp, point2, primitive->objectId, data);
+
+			switch (primitive->booleanOperator)
+			{
+				case primBooleanOperatorOR:
 				{
-					distTemp = primitive->PrimitiveDistance(point2);
+					if (distTemp < distance)
+					{
+						closestObject = primitive->objectId;
+					}
+					distance = min(distance, distTemp);
+					// distance = smoothMin(distance, distTemp, 0.1);
+					break;
 				}
-				distTemp = DisplacementMap(distTemp, point2, primitive->objectId, data);
-
-				switch (primitive->booleanOperator)
+				case primBooleanOperatorAND:
 				{
-					case primBooleanOperatorOR:
+					if (distTemp > distance)
 					{
-						if (distTemp < distance)
-						{
-							closestObject = primitive->objectId;
-						}
-						distance = min(distance, distTemp);
-						// distance = smoothMin(distance, distTemp, 0.1);
-						break;
+						closestObject = primitive->objectId;
 					}
-					case primBooleanOperatorAND:
+					distance = max(distance, distTemp);
+					break;
+				}
+				case primBooleanOperatorSUB:
+				{
+					const double limit = 1.5;
+					if (distance < detailSize) // if inside 1st
 					{
-						if (distTemp > distance)
+						if (distTemp < detailSize * limit * 1.5)
 						{
 							closestObject = primitive->objectId;
 						}
-						distance = max(distance, distTemp);
-						break;
-					}
-					case primBooleanOperatorSUB:
-					{
-						const double limit = 1.5;
-						if (distance < detailSize) // if inside 1st
-						{
-							if (distTemp < detailSize * limit * 1.5)
-							{
-								closestObject = primitive->objectId;
-							}
 
-							if (distTemp < detailSize * limit) // if inside 2nd
+						if (distTemp < detailSize * limit) // if inside 2nd
+						{
+							if (normalCalculationMode)
 							{
-								if (normalCalculationMode)
-								{
-									distance = max(detailSize * limit - distTemp, distance);
-								}
-								else
-								{
-									distance = detailSize * limit;
-								}
+								distance = max(detailSize * limit - distTemp, distance);
 							}
-							else // if outside of 2nd
+							else
 							{
-								distance = max(detailSize * limit - distTemp, distance);
-								if (distance < 0) distance = 0;
+								distance = detailSize * limit;
 							}
 						}
-						break;
+						else // if outside of 2nd
+						{
+							distance = max(detailSize * limit - distTemp, distance);
+							if (distance < 0) distance = 0;
+						}
 					}
-					case primBooleanOperatorRevSUB:
+					break;
+				}
+				case primBooleanOperatorRevSUB:
+				{
+					int closestObjectTemp = closestObject;
+					closestObject = primitive->objectId;
+					const double limit = 1.5;
+					if (distTemp < detailSize) // if inside 2nd
 					{
-						int closestObjectTemp = closestObject;
-						closestObject = primitive->objectId;
-						const double limit = 1.5;
-						if (distTemp < detailSize) // if inside 2nd
+						if (distance < detailSize * limit * 1.5)
 						{
-							if (distance < detailSize * limit * 1.5)
-							{
-								closestObject = closestObjectTemp;
-							}
+							closestObject = closestObjectTemp;
+						}
 
-							if (distance < detailSize * limit) // if inside 1st
+						if (distance < detailSize * limit) // if inside 1st
+						{
+							if (normalCalculationMode)
 							{
-								if (normalCalculationMode)
-								{
-									distance = max(detailSize * limit - distance, distTemp);
-								}
-								else
-								{
-									distance = detailSize * limit;
-								}
+								distance = max(detailSize * limit - distance, distTemp);
 							}
-							else // if outside of 1st
+							else
 							{
-								distTemp = max(detailSize * limit - distance, distTemp);
-								distance = distTemp;
-								if (distance < 0) distance = 0;
+								distance = detailSize * limit;
 							}
 						}
-						else
+						else // if outside of 1st
 						{
+							distTemp = max(detailSize * limit - distance, distTemp);
 							distance = distTemp;
+							if (distance < 0) distance = 0;
 						}
-						break;
 					}
-				} // switch
-			}
+					else
+					{
+						distance = distTemp;
+					}
+					break;
+				}
+			} // switch
 		}
 
 	} // if is any primitive
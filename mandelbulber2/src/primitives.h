@@ -55,6 +55,26 @@ enum enumPrimitiveBooleanOperator
 class cParameterContainer;
 struct sRenderData;
 
+// node of bounding volume hierarchy for primitives joined with OR operator
+struct sPrimitiveBvhNode
+{
+	CVector3 boxMin;
+	CVector3 boxMax;
+	// minimum of distance factors and maximum of displacement heights of primitives in the node
+	double distanceFactor;
+	double displacementMargin;
+	// children are stored at firstChild and firstChild + 1. Leaf has firstChild = -1
+	int firstChild;
+	int primitiveIndex;
+};
+
+// one step of primitive evaluation. Either single primitive or BVH of OR primitives
+struct sPrimitiveStep
+{
+	int primitiveIndex;
+	int bvhRoot;
+};
+
 struct sPrimitiveItem
 {
 	sPrimitiveItem(fractal::enumObjectType _type, int _id, QString _name)
@@ -74,6 +94,17 @@ struct sPrimitiveBasic : cObjectData
 	enumPrimitiveBooleanOperator booleanOperator = primBooleanOperatorOR;
 	virtual ~sPrimitiveBasic() = default;
 	virtual double PrimitiveDistance(CVector3 _point) const = 0;
+
+	// conservative box in local coordinates (after rotation). Outside of the box
+	// PrimitiveDistance() >= distanceFactor * Chebyshev distance to the box.
+	// Returns false for unbounded primitives
+	virtual bool LocalBoundingBox(CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const
+	{
+		Q_UNUSED(boxMin);
+		Q_UNUSED(boxMax);
+		Q_UNUSED(distanceFactor);
+		return false;
+	}
 };
 
 struct sPrimitivePlane : sPrimitiveBasic
@@ -88,6 +119,8 @@ struct sPrimitiveBox : sPrimitiveBasic
 	double rounding;
 	CVector3 repeat;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 struct sPrimitiveSphere : sPrimitiveBasic
@@ -96,6 +129,8 @@ struct sPrimitiveSphere : sPrimitiveBasic
 	double radius;
 	CVector3 repeat;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 struct sPrimitiveWater : sPrimitiveBasic
@@ -122,6 +157,8 @@ struct sPrimitiveCone : sPrimitiveBasic
 	CVector2<double> wallNormal;
 	CVector3 repeat;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 struct sPrimitiveCylinder : sPrimitiveBasic
@@ -132,6 +169,8 @@ struct sPrimitiveCylinder : sPrimitiveBasic
 	double height;
 	CVector3 repeat;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 struct sPrimitiveTorus : sPrimitiveBasic
@@ -143,12 +182,16 @@ struct sPrimitiveTorus : sPrimitiveBasic
 	double tubeRadiusLPow;
 	CVector3 repeat;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 struct sPrimitiveCircle : sPrimitiveBasic
 {
 	double radius;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 struct sPrimitiveRectangle : sPrimitiveBasic
@@ -156,6 +199,8 @@ struct sPrimitiveRectangle : sPrimitiveBasic
 	double height;
 	double width;
 	double PrimitiveDistance(CVector3 _point) const override;
+	bool LocalBoundingBox(
+		CVector3 *boxMin, CVector3 *boxMax, double *distanceFactor) const override;
 };
 
 QString PrimitiveNames(fractal::enumObjectType primitiveType);
@@ -173,13 +218,22 @@ public:
 	double TotalDistance(CVector3 point, double fractalDistance, double detailSize,
 		bool normalCalculationMode, int *closestObjectId, sRenderData *data) const;
 	const QList<sPrimitiveBasic *> *GetListOfPrimitives() const { return &allPrimitives; }
+	bool IsAnyPrimitive() const { return isAnyPrimitive; }
 
 	CVector3 allPrimitivesPosition;
 	CVector3 allPrimitivesRotation;
 	CRotationMatrix mRotAllPrimitivesRotation;
 
 private:
+	void BuildBoundingVolumes();
+	double BvhNodeLowerBound(const sPrimitiveBvhNode &node, const CVector3 &point) const;
+	void BvhDistance(int root, CVector3 point, double *distance, int *closestObject,
+		sRenderData *data) const;
+
 	QList<sPrimitiveBasic *> allPrimitives;
+	QVector<double> displacementMargins;
+	QVector<sPrimitiveBvhNode> bvhNodes;
+	QVector<sPrimitiveStep> evaluationSteps;
 
 	static double Plane(CVector3 point, CVector3 position, CVector3 normal)
 	{
@@ -37,6 +37,8 @@
 
 #include <QDebug>
 
+#include "depth_reprojection.hpp"
+#include "distance_cache.hpp"
 #include "lights.hpp"
 #include "material.h"
 #include "object_data.hpp"
@@ -68,6 +70,10 @@ struct sRenderData
 	int rendererID{0};
 	cRegion<int> screenRegion;
 	cRegion<double> imageRegion;
+	// whole frame in image pixel coordinates. Differs from screenRegion only when the image is
+	// a tile of a larger frame (out-of-core tiled rendering)
+	cRegion<int> frameRegion;
+	bool frameTile{false};
 	sTextures textures;
 	cLights lights;
 	bool *stopRequest{nullptr};
@@ -81,6 +87,17 @@ struct sRenderData
 	QVector<cObjectData> objectData;
 	cStereo stereo;
 
+	// kept between frames of animation rendered by the same render job
+	cDistanceCache distanceCache;
+	cDepthReprojection depthReprojection;
+
+	// materials resolved for every object, indexed by object id. Rebuilt by ValidateObjects(),
+	// the pointers stay valid as long as 'materials' is not modified
+	QVector<cMaterial *> objectMaterials;
+
+	const cObjectData &GetObject(int objectId) const { return objectData.at(objectId); }
+	cMaterial *GetObjectMaterial(int objectId) const { return objectMaterials.at(objectId); }
+
 	void ValidateObjects()
 	{
 		for (cObjectData &object : objectData)
@@ -105,6 +122,10 @@ struct sRenderData
 				object.materialId = substituteMaterialId;
 			}
 		}
+
+		objectMaterials.resize(objectData.size());
+		for (int i = 0; i < objectData.size(); i++)
+			objectMaterials[i] = &materials[objectData[i].materialId];
 	}
 };
 
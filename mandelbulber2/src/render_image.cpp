@@ -83,6 +83,11 @@ int cRenderer::InitProgresiveSteps()
 	int progressive = int(pow(2.0, double(progressiveSteps) - 1));
 	if (progressive == 0) progressive = 1;
 
+	// cones are marched in the first pass which renders one pixel per block (also when progressive
+	// rendering is disabled)
+	if (cRenderWorker::UseConePrepass(params, data) && progressive < CONE_PREPASS_BLOCK_SIZE)
+		progressive = CONE_PREPASS_BLOCK_SIZE;
+
 	return progressive;
 }
 
@@ -111,29 +116,236 @@ void cRenderer::InitializeThreadData(cRenderWorker::sThreadData *threadData)
 				/ scheduler->GetProgressiveStep() * scheduler->GetProgressiveStep();
 		}
 		threadData[i].scheduler = scheduler;
+		threadData[i].antialiasingMask = nullptr;
+		threadData[i].monteCarloPixels = nullptr;
+		threadData[i].coneStartDistances = nullptr;
+	}
+
+	if (cRenderWorker::UseConePrepass(params, data))
+	{
+		int blocksX = (image->GetWidth() + CONE_PREPASS_BLOCK_SIZE - 1) / CONE_PREPASS_BLOCK_SIZE;
+		int blocksY = (image->GetHeight() + CONE_PREPASS_BLOCK_SIZE - 1) / CONE_PREPASS_BLOCK_SIZE;
+		coneStartDistances.fill(0.0, blocksX * blocksY);
+		for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
+			threadData[i].coneStartDistances = coneStartDistances.data();
+	}
+
+	if (cRenderWorker::UseMonteCarloTiles(params, data))
+	{
+		monteCarloPixels.fill(
+			cRenderWorker::sMonteCarloPixel(), image->GetWidth() * image->GetHeight());
+		for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
+			threadData[i].monteCarloPixels = monteCarloPixels.data();
 	}
 }
 
-void cRenderer::LaunchThreads(
-	QThread **thread, cRenderWorker **worker, cRenderWorker::sThreadData *threadData)
+void cRenderer::LaunchThreads(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots,
+	cRenderWorker::sThreadData *threadData)
 {
-	for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
+	for (int i = 0; i < poolSlots.size(); i++)
 	{
-		WriteLog(QString("Thread ") + QString::number(i) + " create", 3);
-		thread[i] = new QThread;
-		worker[i] = new cRenderWorker(
-			params, fractal, &threadData[i], data, image); // Warning! not needed to delete object
-		worker[i]->moveToThread(thread[i]);
-		QObject::connect(thread[i], SIGNAL(started()), worker[i], SLOT(doWork()));
-		QObject::connect(worker[i], SIGNAL(finished()), thread[i], SLOT(quit()));
-		QObject::connect(worker[i], SIGNAL(finished()), worker[i], SLOT(deleteLater()));
-		thread[i]->setObjectName("RenderWorker #" + QString::number(i));
-		thread[i]->start();
-		thread[i]->setPriority(systemData.GetQThreadPriority(systemData.threadsPriority));
+		cRenderWorkerPool::sPoolSlot *poolSlot = poolSlots.at(i);
+
+		// workers are kept in the pool, so they can reuse buffers allocated for previous image
+		if (!poolSlot->renderWorker)
+		{
+			WriteLog(QString("Thread ") + QString::number(i) + " create worker", 3);
+			poolSlot->renderWorker = new cRenderWorker(params, fractal, &threadData[i], data, image);
+			poolSlot->renderWorker->moveToThread(poolSlot->thread);
+		}
+		else
+		{
+			poolSlot->renderWorker->SetRenderData(params, fractal, &threadData[i], data, image);
+		}
+
+		// statistics are accumulated by the workers through all progressive passes
+		if (scheduler->GetProgressivePass() == 1)
+			poolSlot->renderWorker->ResetStatistics(data->statistics);
+
+		poolSlot->renderWorker->SetWorking();
+		QMetaObject::invokeMethod(poolSlot->renderWorker, "doWork", Qt::QueuedConnection);
 		WriteLog(QString("Thread ") + QString::number(i) + " started", 3);
 	}
 }
 
+void cRenderer::WaitForThreads(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots)
+{
+	// main thread sleeps until the worker is finished. Events are processed only in intervals
+	for (int i = 0; i < poolSlots.size(); i++)
+	{
+		while (!poolSlots.at(i)->renderWorker->WaitForFinish(50))
+		{
+			gApplication->processEvents();
+		}
+		WriteLog(QString("Thread ") + QString::number(i) + " finished", 2);
+	}
+}
+
+// sums statistics collected separately by the threads. During rendering it gives approximated
+// values, after finishing of all threads the result is exact
+void cRenderer::CollectStatistics(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots)
+{
+	double time = data->statistics.time;
+	data->statistics = initialStatistics;
+	for (cRenderWorkerPool::sPoolSlot *poolSlot : poolSlots)
+	{
+		if (poolSlot->renderWorker) poolSlot->renderWorker->MergeStatisticsTo(&data->statistics);
+	}
+	data->statistics.time = time;
+}
+
+// moves distance cache cells found by the threads to the cache of the render data
+void cRenderer::MergeDistanceCache(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots)
+{
+	for (cRenderWorkerPool::sPoolSlot *poolSlot : poolSlots)
+	{
+		if (poolSlot->renderWorker)
+			data->distanceCache.Merge(poolSlot->renderWorker->GetNewDistanceCacheCells());
+	}
+}
+
+// adaptive anti-aliasing: progressive passes render one sample per pixel. Then pixels which
+// differ from neighbours are rendered again with all anti-aliasing samples in additional pass
+bool cRenderer::StartAntialiasingPass(cRenderWorker::sThreadData *threadData)
+{
+	if (!cRenderWorker::UseAdaptiveAntialiasing(params, data) || scheduler->IsAdditionalPass())
+		return false;
+	if (*data->stopRequest || systemData.globalStopRequest || scheduler->IsStopped()) return false;
+
+	int numberOfPixels = PrepareAntialiasingMask();
+	WriteLogInt("Adaptive anti-aliasing, pixels to supersample", numberOfPixels, 2);
+	if (numberOfPixels == 0) return false;
+
+	for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
+		threadData[i].antialiasingMask = &antialiasingMask;
+
+	scheduler->StartAdditionalPass();
+	return true;
+}
+
+// Monte Carlo tile convergence: average noise is calculated for each tile. Tiles which are still
+// too noisy and have not reached maximum number of samples are rendered again in additional pass,
+// starting from the noisiest ones
+bool cRenderer::StartMonteCarloPass()
+{
+	if (!cRenderWorker::UseMonteCarloTiles(params, data) || !scheduler->IsTileMode()) return false;
+	if (*data->stopRequest || systemData.globalStopRequest || scheduler->IsStopped()) return false;
+
+	int width = image->GetWidth();
+	int maxSamples = params->DOFSamples;
+	if (params->antialiasingEnabled)
+		maxSamples *= params->antialiasingSize * params->antialiasingSize;
+	double maxNoise = params->DOFMaxNoise * 0.01;
+	const cRegion<int> &region = data->screenRegion;
+
+	QVector<QPair<double, int>> noisyTiles; // average noise, tile index
+	for (int tile = 0; tile < scheduler->GetNumberOfTiles(); tile++)
+	{
+		cRegion<int> tileRegion = scheduler->GetTile(tile);
+		double noiseSum = 0.0;
+		int numberOfPixels = 0;
+		bool allSamplesDone = true;
+		for (int y = qMax(tileRegion.y1, region.y1); y < qMin(tileRegion.y2, region.y2); y++)
+		{
+			for (int x = qMax(tileRegion.x1, region.x1); x < qMin(tileRegion.x2, region.x2); x++)
+			{
+				const cRenderWorker::sMonteCarloPixel &pixel = monteCarloPixels.at(y * width + x);
+				noiseSum += pixel.noise;
+				numberOfPixels++;
+				if (pixel.samples < maxSamples) allSamplesDone = false;
+			}
+		}
+		if (numberOfPixels == 0 || allSamplesDone) continue;
+
+		double averageNoise = noiseSum / numberOfPixels;
+		if (averageNoise >= maxNoise) noisyTiles.append(qMakePair(averageNoise, tile));
+	}
+
+	WriteLogInt("Monte Carlo tile convergence, tiles to sample", noisyTiles.size(), 2);
+	if (noisyTiles.isEmpty()) return false;
+
+	std::sort(noisyTiles.begin(), noisyTiles.end(),
+		[](const QPair<double, int> &a, const QPair<double, int> &b) { return a.first > b.first; });
+
+	QVector<int> tileSequence;
+	tileSequence.reserve(noisyTiles.size());
+	for (const QPair<double, int> &noisyTile : noisyTiles)
+		tileSequence.append(noisyTile.second);
+
+	scheduler->StartAdditionalPass(tileSequence);
+	return true;
+}
+
+// marks pixels which have different colour, depth, object colour or normal vector than any of
+// neighbouring pixels. Returns number of marked pixels
+int cRenderer::PrepareAntialiasingMask()
+{
+	int width = image->GetWidth();
+	const cRegion<int> &region = data->screenRegion;
+
+	antialiasingMask.fill(false, image->GetWidth() * image->GetHeight());
+	bool *mask = antialiasingMask.data();
+
+	int numberOfPixels = 0;
+
+#pragma omp parallel for reduction(+ : numberOfPixels)
+	for (int y = region.y1; y < region.y2; y++)
+	{
+		for (int x = region.x1; x < region.x2; x++)
+		{
+			bool differ = (x > region.x1 && AntialiasingPixelsDiffer(x, y, x - 1, y))
+										|| (x < region.x2 - 1 && AntialiasingPixelsDiffer(x, y, x + 1, y))
+										|| (y > region.y1 && AntialiasingPixelsDiffer(x, y, x, y - 1))
+										|| (y < region.y2 - 1 && AntialiasingPixelsDiffer(x, y, x, y + 1));
+			if (differ)
+			{
+				mask[y * width + x] = true;
+				numberOfPixels++;
+			}
+		}
+	}
+	return numberOfPixels;
+}
+
+bool cRenderer::AntialiasingPixelsDiffer(int x1, int y1, int x2, int y2) const
+{
+	double threshold = params->antialiasingAdaptiveThreshold;
+
+	// colour (HDR values are compressed)
+	sRGBFloat pixel1 = image->GetPixelImage(x1, y1);
+	sRGBFloat pixel2 = image->GetPixelImage(x2, y2);
+	float r1 = pixel1.R / (1.0f + pixel1.R), r2 = pixel2.R / (1.0f + pixel2.R);
+	float g1 = pixel1.G / (1.0f + pixel1.G), g2 = pixel2.G / (1.0f + pixel2.G);
+	float b1 = pixel1.B / (1.0f + pixel1.B), b2 = pixel2.B / (1.0f + pixel2.B);
+	if (fabs(r1 - r2) > threshold || fabs(g1 - g2) > threshold || fabs(b1 - b2) > threshold)
+		return true;
+
+	// depth (relative difference, also edges between object and background)
+	double z1 = image->GetPixelZBuffer(x1, y1);
+	double z2 = image->GetPixelZBuffer(x2, y2);
+	if (fabs(z1 - z2) > threshold * qMin(z1, z2)) return true;
+
+	// object colour (different objects and materials)
+	sRGB8 colour1 = image->GetPixelColor(x1, y1);
+	sRGB8 colour2 = image->GetPixelColor(x2, y2);
+	double colourThreshold = threshold * 255.0;
+	if (abs(colour1.R - colour2.R) > colourThreshold || abs(colour1.G - colour2.G) > colourThreshold
+			|| abs(colour1.B - colour2.B) > colourThreshold)
+		return true;
+
+	// normal vectors (only if they are stored in the image)
+	if (image->GetImageOptional()->optionalNormal)
+	{
+		sRGBFloat normal1 = image->GetPixelNormal(x1, y1);
+		sRGBFloat normal2 = image->GetPixelNormal(x2, y2);
+		CVector3 n1(normal1.R * 2.0 - 1.0, normal1.G * 2.0 - 1.0, normal1.B * 2.0 - 1.0);
+		CVector3 n2(normal2.R * 2.0 - 1.0, normal2.G * 2.0 - 1.0, normal2.B * 2.0 - 1.0);
+		if (n1.Dot(n2) < 1.0 - threshold) return true;
+	}
+
+	return false;
+}
+
 void cRenderer::TerminateRendering()
 {
 	scheduler->Stop();
@@ -148,7 +360,8 @@ void cRenderer::TerminateRendering()
 }
 
 double cRenderer::PeriodicUpdateStatusAndProgressBar(QString &statusText, QString &progressTxt,
-	cProgressText &progressText, QElapsedTimer &timerProgressRefresh)
+	cProgressText &progressText, QElapsedTimer &timerProgressRefresh,
+	const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots)
 {
 	// status bar and progress bar
 	double percentDone = scheduler->PercentDone();
@@ -159,6 +372,7 @@ double cRenderer::PeriodicUpdateStatusAndProgressBar(QString &statusText, QStrin
 	if (timerProgressRefresh.elapsed() > 1000)
 	{
 		updateProgressAndStatus(statusText, progressTxt, percentDone);
+		CollectStatistics(poolSlots);
 		updateStatistics(data->statistics);
 		timerProgressRefresh.restart();
 	}
@@ -182,8 +396,12 @@ QSet<int> cRenderer::UpdateImageDuringRendering(QList<int> &listToRefresh, QList
 			rendererSSAO.RenderSSAO(&listToRefresh);
 		}
 	}
-	image->CompileImage(&listToRefresh);
-	image->ConvertTo8bit();
+	// in compact storage mode 16-bit and 8-bit images are not needed before the end of rendering
+	if (!image->IsCompactStorage() || data->configuration.UseImageRefresh())
+	{
+		image->CompileImage(&listToRefresh);
+		image->ConvertTo8bit();
+	}
 	if (data->configuration.UseImageRefresh())
 	{
 		image->SetFastPreview(true);
@@ -309,6 +527,19 @@ void cRenderer::RenderDOF()
 	connect(&dof, SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
 		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
 	connect(&dof, SIGNAL(updateImage()), this, SIGNAL(updateImage()));
+
+	auto renderRegion = [&](const cRegion<int> &region, double deep) {
+		if (params->DOFLayered)
+		{
+			dof.RenderLayered(region, deep, params->DOFFocus, params->DOFMaxRadius, data->stopRequest);
+		}
+		else
+		{
+			dof.Render(region, deep, params->DOFFocus, params->DOFNumberOfPasses,
+				params->DOFBlurOpacity, params->DOFMaxRadius, data->stopRequest);
+		}
+	};
+
 	if (data->stereo.isEnabled()
 			&& (data->stereo.GetMode() == cStereo::stereoLeftRight
 					|| data->stereo.GetMode() == cStereo::stereoTopBottom))
@@ -316,27 +547,26 @@ void cRenderer::RenderDOF()
 		cRegion<int> region;
 		region = data->stereo.GetRegion(
 			CVector2<int>(image->GetWidth(), image->GetHeight()), cStereo::eyeLeft);
-		dof.Render(region, params->DOFRadius * (region.width + region.height) / 2000.0,
-			params->DOFFocus, params->DOFNumberOfPasses, params->DOFBlurOpacity, params->DOFMaxRadius,
-			data->stopRequest);
+		renderRegion(region, params->DOFRadius * (region.width + region.height) / 2000.0);
 		region = data->stereo.GetRegion(
 			CVector2<int>(image->GetWidth(), image->GetHeight()), cStereo::eyeRight);
-		dof.Render(region, params->DOFRadius * (region.width + region.height) / 2000.0,
-			params->DOFFocus, params->DOFNumberOfPasses, params->DOFBlurOpacity, params->DOFMaxRadius,
-			data->stopRequest);
+		renderRegion(region, params->DOFRadius * (region.width + region.height) / 2000.0);
 	}
 	else
 	{
-		dof.Render(data->screenRegion,
-			params->DOFRadius * (image->GetWidth() + image->GetHeight()) / 2000.0, params->DOFFocus,
-			params->DOFNumberOfPasses, params->DOFBlurOpacity, params->DOFMaxRadius, data->stopRequest);
+		// blur size is relative to the whole frame (the image can be only a tile of it)
+		renderRegion(data->screenRegion,
+			params->DOFRadius * (data->frameRegion.width + data->frameRegion.height) / 2000.0);
 	}
 }
 
 void cRenderer::RenderHDRBlur()
 {
 	cPostEffectHdrBlur *hdrBlur = new cPostEffectHdrBlur(image);
-	hdrBlur->SetParameters(params->hdrBlurRadius, params->hdrBlurIntensity);
+	// blur radius is relative to the whole frame (the image can be only a tile of it)
+	double frameScale = double(data->frameRegion.width + data->frameRegion.height)
+											/ (image->GetWidth() + image->GetHeight());
+	hdrBlur->SetParameters(params->hdrBlurRadius * frameScale, params->hdrBlurIntensity);
 	connect(hdrBlur, SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
 		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
 	hdrBlur->Render(data->stopRequest);
@@ -359,15 +589,28 @@ bool cRenderer::RenderImage()
 		progressText.ResetTimer();
 
 		// prepare multiple threads
-		QThread **thread = new QThread *[data->configuration.GetNumberOfThreads()];
+		QList<cRenderWorkerPool::sPoolSlot *> poolSlots =
+			gRenderWorkerPool->Acquire(data->configuration.GetNumberOfThreads());
 		cRenderWorker::sThreadData *threadData =
 			new cRenderWorker::sThreadData[data->configuration.GetNumberOfThreads()];
-		cRenderWorker **worker = new cRenderWorker *[data->configuration.GetNumberOfThreads()];
 
 		if (scheduler) delete scheduler;
 		scheduler = new cScheduler(data->screenRegion, progressive);
 
 		InitializeThreadData(threadData);
+		initialStatistics = data->statistics;
+
+		// Monte Carlo tile convergence needs tiles to estimate noise
+		if (data->configuration.UseTileScheduler() || cRenderWorker::UseMonteCarloTiles(params, data))
+		{
+			QVector<int> startLines;
+			for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
+				startLines.append(threadData[i].startLine);
+
+			// with NetRender only complete lines can be exchanged, so tiles have full width
+			scheduler->EnableTiles(data->configuration.GetTileSize(),
+				data->configuration.GetNumberOfThreads(), data->configuration.UseNetRender(), startLines);
+		}
 
 		QString statusText;
 		QString progressTxt;
@@ -386,7 +629,7 @@ bool cRenderer::RenderImage()
 		{
 			WriteLogDouble("Progressive loop", scheduler->GetProgressiveStep(), 2);
 
-			LaunchThreads(thread, worker, threadData);
+			LaunchThreads(poolSlots, threadData);
 
 			while (!scheduler->AllLinesDone())
 			{
@@ -410,7 +653,7 @@ bool cRenderer::RenderImage()
 
 				// status bar and progress bar
 				double percentDone = PeriodicUpdateStatusAndProgressBar(
-					statusText, progressTxt, progressText, timerProgressRefresh);
+					statusText, progressTxt, progressText, timerProgressRefresh, poolSlots);
 
 				// refresh image
 				if (listToRefresh.size() > 0)
@@ -421,6 +664,7 @@ bool cRenderer::RenderImage()
 						timerRefresh.restart();
 
 						emit updateProgressAndStatus(statusText, progressTxt, percentDone);
+						CollectStatistics(poolSlots);
 						emit updateStatistics(data->statistics);
 
 						QSet<int> set_listToRefresh = UpdateImageDuringRendering(listToRefresh, listToSend);
@@ -448,16 +692,18 @@ bool cRenderer::RenderImage()
 				}		// isPreview
 			}			// while scheduler
 
-			for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
-			{
-				while (thread[i]->isRunning())
-				{
-					gApplication->processEvents();
-				};
-				WriteLog(QString("Thread ") + QString::number(i) + " finished", 2);
-				delete thread[i];
-			}
-		} while (scheduler->ProgressiveNextStep());
+			WaitForThreads(poolSlots);
+
+			// workers are stopped, so the cache can be updated before the next pass
+			MergeDistanceCache(poolSlots);
+		} while (scheduler->ProgressiveNextStep() || StartAntialiasingPass(threadData)
+						 || StartMonteCarloPass());
+
+		// all threads are finished, so merged statistics are exact
+		CollectStatistics(poolSlots);
+
+		// threads can be used now by other renderers (also by SSAO)
+		gRenderWorkerPool->Release(poolSlots);
 
 		// send last rendered lines
 		SendRenderedLinesToNetRenderAfterRendering(listToSend);
@@ -531,9 +777,7 @@ bool cRenderer::RenderImage()
 			}
 		}
 
-		delete[] thread;
 		delete[] threadData;
-		delete[] worker;
 
 		WriteLog("cRenderer::RenderImage(): memory released", 2);
 
@@ -39,6 +39,7 @@
 #include <QElapsedTimer>
 
 #include "render_worker.hpp"
+#include "render_worker_pool.hpp"
 #include "statistics.h"
 
 // forward declarations
@@ -63,11 +64,19 @@ private:
 	void CreateLineData(int y, QByteArray *lineData) const;
 	int InitProgresiveSteps();
 	void InitializeThreadData(cRenderWorker::sThreadData *threadData);
-	void LaunchThreads(
-		QThread **thread, cRenderWorker **worker, cRenderWorker::sThreadData *threadData);
+	void LaunchThreads(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots,
+		cRenderWorker::sThreadData *threadData);
+	static void WaitForThreads(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots);
+	void CollectStatistics(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots);
+	void MergeDistanceCache(const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots);
+	bool StartAntialiasingPass(cRenderWorker::sThreadData *threadData);
+	int PrepareAntialiasingMask();
+	bool AntialiasingPixelsDiffer(int x1, int y1, int x2, int y2) const;
+	bool StartMonteCarloPass();
 	void TerminateRendering();
 	double PeriodicUpdateStatusAndProgressBar(QString &statusText, QString &progressTxt,
-		cProgressText &progressText, QElapsedTimer &timerProgressRefresh);
+		cProgressText &progressText, QElapsedTimer &timerProgressRefresh,
+		const QList<cRenderWorkerPool::sPoolSlot *> &poolSlots);
 	QSet<int> UpdateImageDuringRendering(QList<int> &listToRefresh, QList<int> &listToSend);
 	void SendRenderedLinesToNetRender(QList<int> &listToSend);
 	void UpdateNetRenderToDoList();
@@ -81,6 +90,10 @@ private:
 	sRenderData *data;
 	cImage *image;
 	cScheduler *scheduler;
+	cStatistics initialStatistics; // statistics before rendering (without data from threads)
+	QVector<bool> antialiasingMask; // pixels selected for adaptive anti-aliasing
+	QVector<cRenderWorker::sMonteCarloPixel> monteCarloPixels; // MC tile convergence state
+	QVector<double> coneStartDistances; // start of primary rays for blocks of pixels
 	bool netRenderAckReceived;
 
 public slots:
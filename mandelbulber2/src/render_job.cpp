@@ -39,7 +39,9 @@
 #include <QWidget>
 
 #include "ao_modes.h"
+#include "calculate_distance.hpp"
 #include "cimage.hpp"
+#include "file_image.hpp"
 #include "fractparams.hpp"
 #include "global_data.hpp"
 #include "image_scale.hpp"
@@ -96,6 +98,7 @@ cRenderJob::cRenderJob(const cParameterContainer *_params, const cFractalContain
 	totalNumberOfCPUs = systemData.numberOfThreads;
 	renderData = nullptr;
 	useSizeFromImage = false;
+	frameTile = false;
 	stopRequest = _stopRequest;
 
 	id++;
@@ -154,6 +157,23 @@ bool cRenderJob::Init(enumMode _mode, const cRenderingConfiguration &config)
 	imageOptional.optionalSpecular = paramsContainer->Get<bool>("specular_enabled");
 	imageOptional.optionalWorld = paramsContainer->Get<bool>("world_enabled");
 	imageOptional.optionalDiffuse = paramsContainer->Get<bool>("diffuse_enabled");
+	imageOptional.optionalSampleCount = paramsContainer->Get<bool>("sampleCount_enabled");
+
+	imageOptional.compactStorage = paramsContainer->Get<bool>("image_compact_storage");
+	if (imageOptional.compactStorage)
+	{
+		// half precision is enough for channels saved with 8-bit quality
+		auto savedIn8bit = [&](const QString &channel) {
+			return paramsContainer->Get<int>(channel + "_quality")
+						 == ImageFileSave::IMAGE_CHANNEL_QUALITY_8;
+		};
+		imageOptional.halfNormal = savedIn8bit("normal");
+		imageOptional.halfNormalWorld = savedIn8bit("normalWorld");
+		imageOptional.halfSpecular = savedIn8bit("specular");
+		imageOptional.halfDiffuse = savedIn8bit("diffuse");
+		imageOptional.halfWorld = savedIn8bit("world");
+		imageOptional.halfSampleCount = savedIn8bit("sampleCount");
+	}
 
 	emit updateProgressAndStatus(
 		QObject::tr("Initialization"), QObject::tr("Setting up image buffers"), 0.0);
@@ -196,6 +216,10 @@ bool cRenderJob::Init(enumMode _mode, const cRenderingConfiguration &config)
 
 	renderData->stereo = stereo;
 	renderData->configuration = config;
+	if (paramsContainer->Get<bool>("cpu_tile_scheduler"))
+		renderData->configuration.EnableTileScheduler(paramsContainer->Get<int>("cpu_tile_size"));
+	if (paramsContainer->Get<bool>("cpu_packet_raymarching"))
+		renderData->configuration.EnablePacketRayMarching();
 
 	ready = true;
 
@@ -292,6 +316,10 @@ void cRenderJob::PrepareData()
 	renderData->screenRegion.Set(0, 0, width, height);
 	// TODO to correct resolution and aspect ratio according to region data
 
+	// image can be only a tile of larger frame
+	renderData->frameTile = frameTile;
+	renderData->frameRegion = frameTile ? frameRegion : renderData->screenRegion;
+
 	// textures are deleted with destruction of renderData
 
 	emit updateProgressAndStatus(QObject::tr("Initialization"), QObject::tr("Loading textures"), 0.0);
@@ -375,10 +403,34 @@ bool cRenderJob::Execute()
 
 			renderData->ValidateObjects();
 
+			if (params->distanceCacheEnabled)
+			{
+				renderData->distanceCache.Validate(
+					cDistanceCache::SceneSignature(paramsContainer, fractalContainer),
+					params->distanceCacheMemoryLimit);
+			}
+
+			// start distances of primary rays reprojected from the previous frame of animation
+			// (previous tile of the same frame is not the previous frame)
+			bool depthReprojection = !renderData->stereo.isEnabled() && !frameTile;
+			if (depthReprojection)
+			{
+				renderData->depthReprojection.Prepare(params, image->GetWidth(), image->GetHeight(),
+					renderData->screenRegion, renderData->imageRegion);
+			}
+			else
+			{
+				renderData->depthReprojection.Clear();
+			}
+
 			// recalculation of some parameters;
-			params->resolution = 1.0 / image->GetHeight();
+			params->resolution = 1.0 / renderData->frameRegion.height;
+			params->imageWidth = renderData->frameRegion.width;
+			params->imageHeight = renderData->frameRegion.height;
 			ReduceDetail();
 
+			if (params->booleanOperatorsEnabled) EstimateFormulaBoundingSpheres(params, *fractals);
+
 			InitStatistics(fractals);
 
 			// initialize histograms
@@ -399,6 +451,8 @@ bool cRenderJob::Execute()
 
 			result = renderer->RenderImage();
 
+			if (depthReprojection && result) renderData->depthReprojection.StoreFrame(params, image);
+
 			if (twoPassStereo && repeat == 0) renderData->stereo.StoreImageInBuffer(image);
 
 			delete params;
@@ -827,6 +881,14 @@ void cRenderJob::UpdateParameters(
 	}
 }
 
+void cRenderJob::SetFrameRegion(const cRegion<int> &region)
+{
+	// region is given in pixel coordinates of the image, so the image is placed at
+	// (-region.x1, -region.y1) inside the frame
+	frameRegion = region;
+	frameTile = true;
+}
+
 void cRenderJob::ReduceDetail() const
 {
 	if (mode == flightAnimRecord)
@@ -81,6 +81,7 @@ public:
 	cImage *GetImagePtr() const { return image; }
 	int GetNumberOfCPUs() const { return totalNumberOfCPUs; }
 	void UseSizeFromImage(bool modeInput) { useSizeFromImage = modeInput; }
+	void SetFrameRegion(const cRegion<int> &region);
 	void ChangeCameraTargetPosition(cCameraTarget &cameraTarget) const;
 
 	void UpdateParameters(const cParameterContainer *_params, const cFractalContainer *_fractal);
@@ -117,6 +118,8 @@ private:
 	bool inProgress;
 	bool ready;
 	bool useSizeFromImage;
+	bool frameTile;
+	cRegion<int> frameRegion;
 	cImage *image;
 	cFractalContainer *fractalContainer;
 	cParameterContainer *paramsContainer;
@@ -39,6 +39,7 @@
 #include "global_data.hpp"
 #include "progress_text.hpp"
 #include "render_data.hpp"
+#include "render_worker_pool.hpp"
 #include "ssao_worker.h"
 #include "system_data.hpp"
 #include "wait.hpp"
@@ -77,10 +78,14 @@ void cRenderSSAO::SetRegion(const cRegion<int> &_region)
 void cRenderSSAO::RenderSSAO(QList<int> *list)
 {
 	WriteLog("cRenderSSAO::RenderSSAO()", 2);
-	// prepare multiple threads
-	QThread **thread = new QThread *[numberOfThreads];
+	// prepare multiple threads. Refreshing during rendering (with list of lines) is done while the
+	// threads of the pool are used by render workers. Then no new threads are created and SSAO is
+	// calculated with idle threads only, or in this thread if there are none
+	numberOfThreads = qMin(data->configuration.GetNumberOfThreads(), height);
+	QList<cRenderWorkerPool::sPoolSlot *> poolSlots =
+		gRenderWorkerPool->Acquire(numberOfThreads, list == nullptr);
+	numberOfThreads = qMax(poolSlots.size(), 1);
 	cSSAOWorker::sThreadData *threadData = new cSSAOWorker::sThreadData[numberOfThreads];
-	cSSAOWorker **worker = new cSSAOWorker *[numberOfThreads];
 
 	cProgressText progressText;
 	progressText.ResetTimer();
@@ -132,19 +137,30 @@ void cRenderSSAO::RenderSSAO(QList<int> *list)
 
 	WriteLog("Start rendering SSAO", 2);
 
-	for (int i = 0; i < numberOfThreads; i++)
+	if (poolSlots.isEmpty())
 	{
-		WriteLog(QString("Thread ") + QString::number(i) + " create", 3);
-		thread[i] = new QThread;
-		worker[i] =
-			new cSSAOWorker(params, &threadData[i], data, image); // Warning! not needed to delete object
-		worker[i]->moveToThread(thread[i]);
-		QObject::connect(thread[i], SIGNAL(started()), worker[i], SLOT(doWork()));
-		QObject::connect(worker[i], SIGNAL(finished()), thread[i], SLOT(quit()));
-		QObject::connect(worker[i], SIGNAL(finished()), worker[i], SLOT(deleteLater()));
-		thread[i]->setObjectName("SSAOWorker #" + QString::number(i));
-		thread[i]->start();
-		thread[i]->setPriority(systemData.GetQThreadPriority(systemData.threadsPriority));
+		cSSAOWorker ssaoWorker(params, &threadData[0], data, image);
+		ssaoWorker.SetWorking();
+		ssaoWorker.doWork();
+	}
+
+	for (int i = 0; i < poolSlots.size(); i++)
+	{
+		cRenderWorkerPool::sPoolSlot *poolSlot = poolSlots.at(i);
+
+		// workers are kept in the pool of threads
+		if (!poolSlot->ssaoWorker)
+		{
+			WriteLog(QString("Thread ") + QString::number(i) + " create SSAO worker", 3);
+			poolSlot->ssaoWorker = new cSSAOWorker(params, &threadData[i], data, image);
+			poolSlot->ssaoWorker->moveToThread(poolSlot->thread);
+		}
+		else
+		{
+			poolSlot->ssaoWorker->SetData(params, &threadData[i], data, image);
+		}
+		poolSlot->ssaoWorker->SetWorking();
+		QMetaObject::invokeMethod(poolSlot->ssaoWorker, "doWork", Qt::QueuedConnection);
 		WriteLog(QString("Thread ") + QString::number(i) + " started", 3);
 	}
 
@@ -189,15 +205,15 @@ void cRenderSSAO::RenderSSAO(QList<int> *list)
 		emit updateProgressAndStatus(statusText, progressTxt, percentDone);
 	}
 
-	for (int i = 0; i < numberOfThreads; i++)
+	for (int i = 0; i < poolSlots.size(); i++)
 	{
-		while (thread[i]->isRunning())
+		while (!poolSlots.at(i)->ssaoWorker->WaitForFinish(50))
 		{
 			gApplication->processEvents();
-		};
+		}
 		WriteLog(QString("Thread ") + QString::number(i) + " finished", 3);
-		delete thread[i];
 	}
+	gRenderWorkerPool->Release(poolSlots);
 
 	// status bar and progress bar
 	double percentDone = 1.0;
@@ -206,9 +222,7 @@ void cRenderSSAO::RenderSSAO(QList<int> *list)
 
 	emit updateProgressAndStatus(statusText, progressTxt, percentDone);
 
-	delete[] thread;
 	delete[] threadData;
-	delete[] worker;
 	if (list) delete[] lists;
 
 	WriteLog("cRenderSSAO::RenderSSAO(): memory released", 2);
@@ -43,6 +43,7 @@
 #include "fractparams.hpp"
 #include "hsv2rgb.h"
 #include "material.h"
+#include "noise_volume.hpp"
 #include "perlin_noise_octaves.h"
 #include "projection_3d.hpp"
 #include "region.hpp"
@@ -55,11 +56,7 @@
 cRenderWorker::cRenderWorker(const sParamRender *_params, const cNineFractals *_fractal,
 	sThreadData *_threadData, sRenderData *_data, cImage *_image)
 {
-	params = _params;
-	fractal = _fractal;
-	data = _data;
-	image = _image;
-	threadData = _threadData;
+	SetRenderData(_params, _fractal, _threadData, _data, _image);
 	cameraTarget = nullptr;
 	rayBuffer = nullptr;
 	rayStack = nullptr;
@@ -70,9 +67,22 @@ cRenderWorker::cRenderWorker(const sParamRender *_params, const cNineFractals *_
 	baseZ = CVector3(0.0, 0.0, 1.0);
 	maxRaymarchingSteps = 10000;
 	reflectionsMax = 0;
+	aspectRatio = 1.0;
 	actualHue = 0.0;
 	stopRequest = false;
+	working = false;
 	perlinNoise = nullptr;
+	perlinNoiseSeed = 0;
+	packetMode = false;
+	adaptiveAntialiasing = false;
+	rayClipping = false;
+	distanceCache = false;
+	reprojectedStart = false;
+	conePrepass = false;
+	overRelaxation = false;
+	packetStepBuff = nullptr;
+	primaryRayPacket.y = -1;
+	primaryRayPacket.count = 0;
 }
 
 cRenderWorker::~cRenderWorker()
@@ -83,14 +93,7 @@ cRenderWorker::~cRenderWorker()
 		cameraTarget = nullptr;
 	}
 
-	if (rayBuffer)
-	{
-		for (int i = 0; i < reflectionsMax + 3; i++)
-		{
-			delete[] rayBuffer[i].stepBuff;
-		}
-		delete[] rayBuffer;
-	}
+	FreeReflectionBuffer();
 
 	if (AOVectorsAround)
 	{
@@ -98,23 +101,72 @@ cRenderWorker::~cRenderWorker()
 		AOVectorsAround = nullptr;
 	}
 
-	if (rayStack) delete[] rayStack;
+	if (perlinNoise)
+	{
+		delete perlinNoise;
+		perlinNoise = nullptr;
+	}
+
+	if (packetStepBuff)
+	{
+		delete[] packetStepBuff;
+		packetStepBuff = nullptr;
+	}
+}
+
+void cRenderWorker::SetRenderData(const sParamRender *_params, const cNineFractals *_fractal,
+	sThreadData *_threadData, sRenderData *_data, cImage *_image)
+{
+	params = _params;
+	fractal = _fractal;
+	data = _data;
+	image = _image;
+	threadData = _threadData;
+}
+
+// clears statistics of the thread. Histograms get the same size as in the pattern
+void cRenderWorker::ResetStatistics(const cStatistics &pattern)
+{
+	if (statistics.histogramIterations.GetSize() != pattern.histogramIterations.GetSize())
+		statistics.histogramIterations.Resize(pattern.histogramIterations.GetSize());
+	if (statistics.histogramStepCount.GetSize() != pattern.histogramStepCount.GetSize())
+		statistics.histogramStepCount.Resize(pattern.histogramStepCount.GetSize());
+	statistics.Reset();
+	scratchArena.ResetHighWaterMark();
+
+	statisticsMutex.lock();
+	publishedStatistics = statistics;
+	statisticsMutex.unlock();
+}
+
+// copy of statistics is updated by the worker thread, so the counters which are changed for each
+// pixel don't need any synchronization
+void cRenderWorker::PublishStatistics()
+{
+	statisticsMutex.lock();
+	publishedStatistics = statistics;
+	statisticsMutex.unlock();
+	publishStatisticsTimer.restart();
+}
+
+void cRenderWorker::MergeStatisticsTo(cStatistics *target)
+{
+	statisticsMutex.lock();
+	target->Merge(publishedStatistics);
+	statisticsMutex.unlock();
 }
 
 // main render engine function called as multiple threads
 void cRenderWorker::doWork()
 {
 	// here will be rendering thread
-	int width = image->GetWidth();
-	int height = image->GetHeight();
-	double aspectRatio = double(width) / height;
+	// (when the image is a tile, projection is calculated for the whole frame)
+	int width = data->frameRegion.width;
+	int height = data->frameRegion.height;
+	aspectRatio = double(width) / height;
 
 	if (params->perspectiveType == params::perspEquirectangular) aspectRatio = 2.0;
 
-	bool monteCarlo = params->DOFMonteCarlo;
-	bool antiAliasing = params->antialiasingEnabled;
-	int antiAliasingSize = params->antialiasingSize;
-
 	if (data->stereo.isEnabled() && (params->perspectiveType != params::perspEquirectangular))
 		aspectRatio = data->stereo.ModifyAspectRatio(aspectRatio);
 
@@ -123,13 +175,85 @@ void cRenderWorker::doWork()
 	if (params->ambientOcclusionEnabled && params->ambientOcclusionMode == params::AOModeMultipleRays)
 		PrepareAOVectors();
 
-	perlinNoise = new cPerlinNoiseOctaves(params->cloudsRandomSeed);
+	// perlin noise is kept between images if the seed is not changed
+	if (!perlinNoise || perlinNoiseSeed != params->cloudsRandomSeed)
+	{
+		if (perlinNoise) delete perlinNoise;
+		perlinNoise = new cPerlinNoiseOctaves(params->cloudsRandomSeed);
+		perlinNoiseSeed = params->cloudsRandomSeed;
+	}
+
+	// precalculated noise volume is baked by the first worker and shared with the other ones
+	if (params->cloudsEnable && params->cloudsNoiseVolume)
+	{
+		noiseVolume = cNoiseVolume::Get({params->cloudsRandomSeed, params->cloudsIterations,
+			params->cloudsNoiseVolumeResolution, params->cloudsNoiseVolumeTile});
+	}
+	else
+	{
+		noiseVolume.reset();
+	}
+
+	rayClipping = UseRayClipping(params, data);
+	distanceCache = UseDistanceCache(params, data);
+	reprojectedStart = data->depthReprojection.IsReady() && !UseVolumetricEffects(params, data);
+	conePrepass = UseConePrepass(params, data) && threadData->coneStartDistances;
+	overRelaxation = UseOverRelaxation(params, data);
+
+	// adaptive anti-aliasing: one sample per pixel, and then pixels selected by the mask are
+	// supersampled in the additional pass
+	adaptiveAntialiasing = UseAdaptiveAntialiasing(params, data);
+	bool antialiasingPass = adaptiveAntialiasing && threadData->antialiasingMask;
+
+	// packet ray-marching is possible only if there is one primary ray per pixel. It's not used
+	// when primary rays start at reprojected depth, which skips most of the empty space anyway
+	packetMode = data->configuration.UsePacketRayMarching() && !params->DOFMonteCarlo
+							 && !reprojectedStart
+							 && (!params->antialiasingEnabled || (adaptiveAntialiasing && !antialiasingPass))
+							 && !data->stereo.isEnabled() && IsPacketDistanceSupported(*params, *fractal, data);
+	if (packetMode && !packetStepBuff)
+		packetStepBuff = new sStep[FRACTAL_PACKET_SIZE * MAX_PACKET_RAYMARCHING];
+	primaryRayPacket.y = -1;
+	primaryRayPacket.count = 0;
 
 	// init of scheduler
 	cScheduler *scheduler = threadData->scheduler;
 
-	// start point for ray-marching
-	CVector3 start = params->camera;
+	publishStatisticsTimer.start();
+
+	if (scheduler->IsTileMode())
+	{
+		RenderTiles(scheduler);
+	}
+	else
+	{
+		RenderLines(scheduler);
+	}
+
+	// final statistics of this pass
+	PublishStatistics();
+
+	workingMutex.lock();
+	working = false;
+	workingFinished.wakeAll();
+	workingMutex.unlock();
+
+	// emit signal to main thread when finished
+	emit finished();
+	return;
+}
+
+bool cRenderWorker::WaitForFinish(unsigned long timeout)
+{
+	QMutexLocker lock(&workingMutex);
+	if (working) workingFinished.wait(&workingMutex, timeout);
+	return !working;
+}
+
+// rendering of lines given by line scheduler
+void cRenderWorker::RenderLines(cScheduler *scheduler)
+{
+	int width = image->GetWidth();
 
 	scheduler->InitFirstLine(threadData->id, threadData->startLine);
 
@@ -155,350 +279,709 @@ void cRenderWorker::doWork()
 				break;
 			}
 
-			if (scheduler->GetProgressivePass() > 1 && xs % (scheduler->GetProgressiveStep() * 2) == 0
+			if (scheduler->SkipPreviousPassPixels() && xs % (scheduler->GetProgressiveStep() * 2) == 0
 					&& ys % (scheduler->GetProgressiveStep() * 2) == 0)
 				continue;
 
 			// skip if pixel is out of region;
 			if (xs < data->screenRegion.x1 || xs > data->screenRegion.x2) continue;
 
-			// calculate point in image coordinate system
-			CVector2<int> screenPoint(xs, ys);
-			CVector2<double> imagePoint = data->screenRegion.transpose(data->imageRegion, screenPoint);
-			cStereo::enumEye stereoEye = data->stereo.WhichEye(imagePoint);
-			if (data->stereo.isEnabled())
+			RenderPixel(xs, ys, scheduler->GetProgressiveStep());
+
+		} // next xs
+
+		if (publishStatisticsTimer.elapsed() > 500) PublishStatistics();
+	} // next ys
+}
+
+// rendering of tiles given by tile scheduler
+void cRenderWorker::RenderTiles(cScheduler *scheduler)
+{
+	int progressiveStep = scheduler->GetProgressiveStep();
+	bool skipPreviousPass = scheduler->SkipPreviousPassPixels();
+
+	for (int tile = scheduler->NextTile(threadData->id, -1); tile >= 0;
+			 tile = scheduler->NextTile(threadData->id, tile))
+	{
+		cRegion<int> tileRegion = scheduler->GetTile(tile);
+
+		for (int ys = tileRegion.y1; ys < tileRegion.y2; ys += progressiveStep)
+		{
+			// skip if line is out of region or was already rendered by NetRender server
+			if (ys < data->screenRegion.y1 || ys > data->screenRegion.y2) continue;
+			if (scheduler->IsLineDoneByServer(ys)) continue;
+
+			for (int xs = tileRegion.x1; xs < tileRegion.x2; xs += progressiveStep)
 			{
-				imagePoint = data->stereo.ModifyImagePoint(imagePoint);
-			}
-			imagePoint.x *= aspectRatio;
-
-			// full dome hemisphere cut
-			bool hemisphereCut = false;
-			if (params->perspectiveType == params::perspFishEyeCut
-					&& imagePoint.Length() > M_PI * 0.5f / params->fov)
-				hemisphereCut = true;
-
-			// Ray marching
-			int repeats = data->stereo.GetNumberOfRepeats();
-
-			sRGBFloat finalPixel;
-			sRGBFloat pixelLeftEye;
-			sRGBFloat pixelRightEye;
-			sRGB8 colour;
-			unsigned short alpha = 65535;
-			unsigned short opacity16 = 65535;
-			sRGBFloat normalFloat;
-			sRGBFloat normalFloatWorld;
-			sRGBFloat specularFloat;
-			double depth = 1e20;
-			sRGBFloat worldPositionRGB;
-			if (monteCarlo) repeats = params->DOFSamples;
-			if (antiAliasing) repeats *= antiAliasingSize * antiAliasingSize;
-
-			sRGBFloat finalPixelDOF;
-			unsigned int finalAlphaDOF = 0;
-			unsigned int finalOpacityDOF = 0;
-			sRGB finalColourDOF;
-
-			sRGBFloat monteCarloDOFStdDevSum;
-			double monteCarloNoise = 0.0;
-
-			CVector2<double> originalImagePoint = imagePoint;
-
-			for (int repeat = 0; repeat < repeats; repeat++)
+				if (systemData.globalStopRequest || scheduler->IsStopped()) break;
+
+				if (skipPreviousPass && xs % (progressiveStep * 2) == 0 && ys % (progressiveStep * 2) == 0)
+					continue;
+
+				// skip if pixel is out of region;
+				if (xs < data->screenRegion.x1 || xs > data->screenRegion.x2) continue;
+
+				RenderPixel(xs, ys, progressiveStep);
+			} // next xs
+		}		// next ys
+
+		if (publishStatisticsTimer.elapsed() > 500) PublishStatistics();
+	} // next tile
+}
+
+// rendering of single pixel (with all AA and DOF samples)
+void cRenderWorker::RenderPixel(int xs, int ys, int progressiveStep)
+{
+	bool monteCarlo = params->DOFMonteCarlo;
+	bool antiAliasing = params->antialiasingEnabled;
+	int antiAliasingSize = params->antialiasingSize;
+
+	if (adaptiveAntialiasing)
+	{
+		if (threadData->antialiasingMask)
+		{
+			// supersampling only of pixels selected by the mask
+			if (!threadData->antialiasingMask->at(ys * image->GetWidth() + xs)) return;
+		}
+		else
+		{
+			antiAliasing = false;
+		}
+	}
+
+	// calculate point in image coordinate system
+	CVector2<int> screenPoint(xs, ys);
+	CVector2<double> imagePoint = data->frameRegion.transpose(data->imageRegion, screenPoint);
+	cStereo::enumEye stereoEye = data->stereo.WhichEye(imagePoint);
+	if (data->stereo.isEnabled())
+	{
+		imagePoint = data->stereo.ModifyImagePoint(imagePoint);
+	}
+	imagePoint.x *= aspectRatio;
+
+	// full dome hemisphere cut
+	bool hemisphereCut = false;
+	if (params->perspectiveType == params::perspFishEyeCut
+			&& imagePoint.Length() > M_PI * 0.5f / params->fov)
+		hemisphereCut = true;
+
+	// Ray marching
+	int repeats = data->stereo.GetNumberOfRepeats();
+
+	sRGBFloat finalPixel;
+	sRGBFloat pixelLeftEye;
+	sRGBFloat pixelRightEye;
+	sRGB8 colour;
+	unsigned short alpha = 65535;
+	unsigned short opacity16 = 65535;
+	sRGBFloat normalFloat;
+	sRGBFloat normalFloatWorld;
+	sRGBFloat specularFloat;
+	double depth = 1e20;
+	sRGBFloat worldPositionRGB;
+	if (monteCarlo) repeats = params->DOFSamples;
+	if (antiAliasing) repeats *= antiAliasingSize * antiAliasingSize;
+	int maxRepeats = repeats;
+
+	sRGBFloat finalPixelDOF;
+	unsigned int finalAlphaDOF = 0;
+	unsigned int finalOpacityDOF = 0;
+	sRGB finalColourDOF;
+
+	sRGBFloat monteCarloDOFStdDevSum;
+	double monteCarloNoise = 0.0;
+
+	// Monte Carlo tile convergence: pixel is sampled in batches and sampling is continued in
+	// additional passes as long as the tile is too noisy
+	sMonteCarloPixel *monteCarloPixel = nullptr;
+	int firstRepeat = 0;
+	if (monteCarlo && threadData->monteCarloPixels)
+	{
+		monteCarloPixel = &threadData->monteCarloPixels[ys * image->GetWidth() + xs];
+		firstRepeat = monteCarloPixel->samples;
+		if (firstRepeat >= maxRepeats) return;
+
+		// minimum number of samples at first, then the number of samples is doubled in each pass
+		int batch = (firstRepeat == 0) ? qMax(params->DOFMinSamples, 1) : firstRepeat;
+		repeats = qMin(firstRepeat + batch, maxRepeats);
+
+		// sums of samples calculated in previous passes
+		finalPixelDOF = monteCarloPixel->pixelSum;
+		finalAlphaDOF = monteCarloPixel->alphaSum;
+		finalOpacityDOF = monteCarloPixel->opacitySum;
+		finalColourDOF = monteCarloPixel->colourSum;
+		monteCarloDOFStdDevSum = monteCarloPixel->stdDevSum;
+	}
+
+	CVector2<double> originalImagePoint = imagePoint;
+
+	for (int repeat = firstRepeat; repeat < repeats; repeat++)
+	{
+		// random sequence depends only on pixel and sample, not on thread which renders it
+		pixelRandom.Seed(
+			params->frameNo, xs - data->frameRegion.x1, ys - data->frameRegion.y1, repeat);
+
+		CVector3 viewVector;
+		CVector3 startRay;
+
+		if (antiAliasing)
+		{
+			int xStep = repeat / antiAliasingSize;
+			int yStep = repeat % antiAliasingSize;
+			double xOffset = double(xStep) / antiAliasingSize / data->frameRegion.width * aspectRatio;
+			double yOffset = double(yStep) / antiAliasingSize / data->frameRegion.height;
+			imagePoint.x = originalImagePoint.x + xOffset;
+			imagePoint.y = originalImagePoint.y + yOffset;
+		}
+
+		if (monteCarlo)
+		{
+			if (!antiAliasing)
 			{
+				// MC anti-aliasing
+				double randomX = double(pixelRandom.Random(1000)) / 1000.0 - 0.5;
+				double randomY = double(pixelRandom.Random(1000)) / 1000.0 - 0.5;
+				imagePoint.x = originalImagePoint.x + randomX / data->frameRegion.width * aspectRatio;
+				imagePoint.y = originalImagePoint.y + randomY / data->frameRegion.height;
+			}
 
-				CVector3 viewVector;
-				CVector3 startRay;
+			viewVector = CalculateViewVector(imagePoint, params->fov, params->perspectiveType, mRot);
+			startRay = params->camera;
 
-				if (antiAliasing)
-				{
-					int xStep = repeat / antiAliasingSize;
-					int yStep = repeat % antiAliasingSize;
-					double xOffset = double(xStep) / antiAliasingSize / image->GetWidth() * aspectRatio;
-					double yOffset = double(yStep) / antiAliasingSize / image->GetHeight();
-					imagePoint.x = originalImagePoint.x + xOffset;
-					imagePoint.y = originalImagePoint.y + yOffset;
-				}
+			if (params->DOFEnabled)
+			{
+				MonteCarloDOF(&startRay, &viewVector);
+			}
+		}
+		else
+		{
+			// calculate direction of ray-marching
+			viewVector = CalculateViewVector(imagePoint, params->fov, params->perspectiveType, mRot);
+			startRay = params->camera;
+		}
 
-				if (monteCarlo)
-				{
-					if (!antiAliasing)
-					{
-						// MC anti-aliasing
-						imagePoint.x =
-							originalImagePoint.x
-							+ (double(Random(1000)) / 1000.0 - 0.5) / image->GetWidth() * aspectRatio;
-						imagePoint.y =
-							originalImagePoint.y + (double(Random(1000)) / 1000.0 - 0.5) / image->GetHeight();
-					}
+		sRGBFloat rgbFromHsv;
+		if (params->DOFMonteCarlo && params->DOFMonteCarloChromaticAberration)
+		{
+			actualHue = pixelRandom.Random(3600) / 10.0;
+			rgbFromHsv = Hsv2rgb(fmodf(360.0f + float(actualHue) - 60.0f, 360.0f), 1.0f, 2.0f);
+			CVector3 randVector(
+				0.0, actualHue / 20000.0f * params->DOFMonteCarloCACameraDispersion, 0.0);
+			CVector3 randVectorRot = mRot.RotateVector(randVector);
+			viewVector -= randVectorRot;
+			viewVector.Normalize();
+		}
 
-					viewVector = CalculateViewVector(imagePoint, params->fov, params->perspectiveType, mRot);
-					startRay = start;
+		if (data->stereo.isEnabled())
+		{
+			data->stereo.WhichEyeForAnaglyph(&stereoEye, repeat);
+			if (params->perspectiveType == params::perspFishEyeCut)
+			{
+				CVector3 eyePosition;
+				CVector3 sideVector = viewVector.Cross(params->topVector);
+				sideVector.Normalize();
+				double eyeDistance = params->stereoEyeDistance;
+				if (data->stereo.AreSwapped()) eyeDistance *= -1.0;
 
-					if (params->DOFEnabled)
-					{
-						MonteCarloDOF(&startRay, &viewVector);
-					}
+				if (stereoEye == cStereo::eyeLeft)
+				{
+					eyePosition =
+						startRay
+						+ 0.5 * (cameraTarget->GetRightVector() * eyeDistance + sideVector * eyeDistance);
 				}
 				else
 				{
-					// calculate direction of ray-marching
-					viewVector = CalculateViewVector(imagePoint, params->fov, params->perspectiveType, mRot);
-					startRay = start;
+					eyePosition =
+						startRay
+						- 0.5 * (cameraTarget->GetRightVector() * eyeDistance + sideVector * eyeDistance);
 				}
+				startRay = eyePosition;
+			}
+			else
+			{
+				// reduce of stereo effect on poles
+				double stereoIntensity = (params->perspectiveType == params::perspEquirectangular)
+																	 ? 1.0 - pow(imagePoint.y * 2.0, 10.0)
+																	 : 1.0;
+
+				startRay = data->stereo.CalcEyePosition(startRay, viewVector, params->topVector,
+					params->stereoEyeDistance * stereoIntensity, stereoEye);
+				data->stereo.ViewVectorCorrection(params->stereoInfiniteCorrection * stereoIntensity,
+					mRot, mRotInv, stereoEye, params->perspectiveType, &viewVector);
+			}
+		}
 
-				sRGBFloat rgbFromHsv;
-				if (params->DOFMonteCarlo && params->DOFMonteCarloChromaticAberration)
+		sRGBAfloat resultShader;
+		sRGBAfloat objectColour;
+		CVector3 normal;
+		;
+
+		double opacity = 1.0;
+		depth = 1e20;
+
+		// ray-marching loop (reflections)
+
+		if (!hemisphereCut) // in fulldome mode, will not render pixels out of the fulldome
+		{
+			sRayRecursionIn recursionIn;
+
+			sRayMarchingIn rayMarchingIn;
+			CVector3 direction = viewVector;
+			direction.Normalize();
+			rayMarchingIn.binaryEnable = true;
+			rayMarchingIn.direction = direction;
+			rayMarchingIn.maxScan = params->viewDistanceMax;
+			rayMarchingIn.minScan = 0; // params->viewDistanceMin;
+			rayMarchingIn.start = startRay;
+			rayMarchingIn.invertMode = false;
+			rayMarchingIn.prefixSteps = nullptr;
+			rayMarchingIn.prefixStepsCount = 0;
+			rayMarchingIn.initialStep = 0.0;
+
+			// continue from the point reached by packet ray-marching
+			if (packetMode)
+			{
+				int lane = PrimaryRayPacketLane(xs, ys, progressiveStep);
+				rayMarchingIn.minScan = primaryRayPacket.startScan[lane];
+				rayMarchingIn.prefixSteps = &packetStepBuff[lane * MAX_PACKET_RAYMARCHING];
+				rayMarchingIn.prefixStepsCount = primaryRayPacket.prefixStepsCount[lane];
+				rayMarchingIn.initialStep = primaryRayPacket.initialStep[lane];
+			}
+
+			// skip the space found empty by cone marching of the block (packets start there already)
+			if (conePrepass && !packetMode)
+				rayMarchingIn.minScan = ConeStartDistance(xs, ys, progressiveStep);
+
+			// start at depth reprojected from the previous frame. The start point is accepted only
+			// if it's outside the fractal, otherwise the ray is marched from the camera
+			if (reprojectedStart)
+			{
+				double startScan = data->depthReprojection.GetStartDistance(xs, ys);
+				if (startScan > rayMarchingIn.minScan && startScan < params->viewDistanceMax)
 				{
-					actualHue = Random(3600) / 10.0;
-					rgbFromHsv = Hsv2rgb(fmodf(360.0f + float(actualHue) - 60.0f, 360.0f), 1.0f, 2.0f);
-					CVector3 randVector(
-						0.0, actualHue / 20000.0f * params->DOFMonteCarloCACameraDispersion, 0.0);
-					CVector3 randVectorRot = mRot.RotateVector(randVector);
-					viewVector -= randVectorRot;
-					viewVector.Normalize();
+					CVector3 startPoint = startRay + direction * startScan;
+					double startDistThresh = CalcDistThresh(startPoint);
+					sDistanceIn distanceIn(startPoint, startDistThresh, false);
+					sDistanceOut distanceOut;
+					double startDist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
+					if (startDist > startDistThresh) rayMarchingIn.minScan = startScan;
 				}
+			}
+			recursionIn.rayMarchingIn = rayMarchingIn;
+			recursionIn.calcInside = false;
+			recursionIn.resultShader = resultShader;
+			recursionIn.objectColour = objectColour;
+			recursionIn.rayBranch = rayBranchReflection;
+
+			sRayRecursionInOut recursionInOut;
+			sRayMarchingInOut rayMarchingInOut;
+			rayMarchingInOut.buffCount = &rayBuffer[0].buffCount;
+			rayMarchingInOut.stepBuff = rayBuffer[0].stepBuff;
+			recursionInOut.rayMarchingInOut = rayMarchingInOut;
+
+			sRayRecursionOut recursionOut = RayRecursion(recursionIn, recursionInOut);
+
+			resultShader = recursionOut.resultShader;
+			objectColour = recursionOut.objectColour;
+			depth = recursionOut.rayMarchingOut.depth;
+			if (!recursionOut.found) depth = 1e20;
+			opacity = recursionOut.fogOpacity;
+			normal = recursionOut.normal;
+			worldPositionRGB.R = recursionOut.rayMarchingOut.point.x;
+			worldPositionRGB.G = recursionOut.rayMarchingOut.point.y;
+			worldPositionRGB.B = recursionOut.rayMarchingOut.point.z;
+			specularFloat.R = recursionOut.specular.R;
+			specularFloat.G = recursionOut.specular.G;
+			specularFloat.B = recursionOut.specular.B;
+		}
 
-				if (data->stereo.isEnabled())
-				{
-					data->stereo.WhichEyeForAnaglyph(&stereoEye, repeat);
-					if (params->perspectiveType == params::perspFishEyeCut)
-					{
-						CVector3 eyePosition;
-						CVector3 sideVector = viewVector.Cross(params->topVector);
-						sideVector.Normalize();
-						double eyeDistance = params->stereoEyeDistance;
-						if (data->stereo.AreSwapped()) eyeDistance *= -1.0;
+		finalPixel.R = resultShader.R;
+		finalPixel.G = resultShader.G;
+		finalPixel.B = resultShader.B;
 
-						if (stereoEye == cStereo::eyeLeft)
-						{
-							eyePosition =
-								startRay
-								+ 0.5 * (cameraTarget->GetRightVector() * eyeDistance + sideVector * eyeDistance);
-						}
-						else
-						{
-							eyePosition =
-								startRay
-								- 0.5 * (cameraTarget->GetRightVector() * eyeDistance + sideVector * eyeDistance);
-						}
-						startRay = eyePosition;
-					}
-					else
-					{
-						// reduce of stereo effect on poles
-						double stereoIntensity = (params->perspectiveType == params::perspEquirectangular)
-																			 ? 1.0 - pow(imagePoint.y * 2.0, 10.0)
-																			 : 1.0;
-
-						startRay = data->stereo.CalcEyePosition(startRay, viewVector, params->topVector,
-							params->stereoEyeDistance * stereoIntensity, stereoEye);
-						data->stereo.ViewVectorCorrection(params->stereoInfiniteCorrection * stereoIntensity,
-							mRot, mRotInv, stereoEye, params->perspectiveType, &viewVector);
-					}
-				}
+		if (params->DOFMonteCarlo && params->DOFMonteCarloChromaticAberration)
+		{
+			finalPixel.R *= rgbFromHsv.R;
+			finalPixel.G *= rgbFromHsv.G;
+			finalPixel.B *= rgbFromHsv.B;
+		}
 
-				sRGBAfloat resultShader;
-				sRGBAfloat objectColour;
-				CVector3 normal;
-				;
+		if (data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
+		{
+			if (stereoEye == cStereo::eyeLeft)
+			{
+				pixelLeftEye.R += finalPixel.R;
+				pixelLeftEye.G += finalPixel.G;
+				pixelLeftEye.B += finalPixel.B;
+			}
+			else if (stereoEye == cStereo::eyeRight)
+			{
+				pixelRightEye.R += finalPixel.R;
+				pixelRightEye.G += finalPixel.G;
+				pixelRightEye.B += finalPixel.B;
+			}
+		}
 
-				double opacity = 1.0;
-				depth = 1e20;
+		alpha = ushort(resultShader.A * 65535);
+		opacity16 = ushort(opacity * 65535);
 
-				// ray-marching loop (reflections)
+		colour.R = uchar(objectColour.R * 255);
+		colour.G = uchar(objectColour.G * 255);
+		colour.B = uchar(objectColour.B * 255);
 
-				if (!hemisphereCut) // in fulldome mode, will not render pixels out of the fulldome
-				{
-					sRayRecursionIn recursionIn;
-
-					sRayMarchingIn rayMarchingIn;
-					CVector3 direction = viewVector;
-					direction.Normalize();
-					rayMarchingIn.binaryEnable = true;
-					rayMarchingIn.direction = direction;
-					rayMarchingIn.maxScan = params->viewDistanceMax;
-					rayMarchingIn.minScan = 0; // params->viewDistanceMin;
-					rayMarchingIn.start = startRay;
-					rayMarchingIn.invertMode = false;
-					recursionIn.rayMarchingIn = rayMarchingIn;
-					recursionIn.calcInside = false;
-					recursionIn.resultShader = resultShader;
-					recursionIn.objectColour = objectColour;
-					recursionIn.rayBranch = rayBranchReflection;
-
-					sRayRecursionInOut recursionInOut;
-					sRayMarchingInOut rayMarchingInOut;
-					rayMarchingInOut.buffCount = &rayBuffer[0].buffCount;
-					rayMarchingInOut.stepBuff = rayBuffer[0].stepBuff;
-					recursionInOut.rayMarchingInOut = rayMarchingInOut;
-
-					sRayRecursionOut recursionOut = RayRecursion(recursionIn, recursionInOut);
-
-					resultShader = recursionOut.resultShader;
-					objectColour = recursionOut.objectColour;
-					depth = recursionOut.rayMarchingOut.depth;
-					if (!recursionOut.found) depth = 1e20;
-					opacity = recursionOut.fogOpacity;
-					normal = recursionOut.normal;
-					worldPositionRGB.R = recursionOut.rayMarchingOut.point.x;
-					worldPositionRGB.G = recursionOut.rayMarchingOut.point.y;
-					worldPositionRGB.B = recursionOut.rayMarchingOut.point.z;
-					specularFloat.R = recursionOut.specular.R;
-					specularFloat.G = recursionOut.specular.G;
-					specularFloat.B = recursionOut.specular.B;
-				}
+		if (image->GetImageOptional()->optionalNormal)
+		{
+			CVector3 normalRotated = mRotInv.RotateVector(normal);
+			normalRotated.Normalize();
+			normalFloat.R = (1.0 + normalRotated.x) / 2.0;
+			normalFloat.G = (1.0 + normalRotated.z) / 2.0;
+			normalFloat.B = (1.0 - normalRotated.y) / 2.0; // <-- Also normalized B component.
+			// normalFloat.B = 1.0 - normalRotated.y;  // <-- old
+		}
 
-				finalPixel.R = resultShader.R;
-				finalPixel.G = resultShader.G;
-				finalPixel.B = resultShader.B;
+		if (image->GetImageOptional()->optionalNormalWorld)
+		{
+			CVector3 normalNormalized = normal;
+			normalNormalized.Normalize();
+			normalFloatWorld.R = normalNormalized.x;
+			normalFloatWorld.G = normalNormalized.y;
+			normalFloatWorld.B = normalNormalized.z;
+		}
 
-				if (params->DOFMonteCarlo && params->DOFMonteCarloChromaticAberration)
-				{
-					finalPixel.R *= rgbFromHsv.R;
-					finalPixel.G *= rgbFromHsv.G;
-					finalPixel.B *= rgbFromHsv.B;
-				}
+		finalPixelDOF.R += finalPixel.R;
+		finalPixelDOF.G += finalPixel.G;
+		finalPixelDOF.B += finalPixel.B;
+		finalAlphaDOF += alpha;
+		finalOpacityDOF += opacity16;
+		finalColourDOF.R += colour.R;
+		finalColourDOF.G += colour.G;
+		finalColourDOF.B += colour.B;
+
+		// noise estimation
+		if (monteCarlo)
+		{
+			monteCarloNoise =
+				MonteCarloDOFNoiseEstimation(finalPixel, repeat, finalPixelDOF, monteCarloDOFStdDevSum);
+
+			// in tile convergence mode the noise is checked for the whole tile
+			if (!monteCarloPixel && repeat > params->DOFMinSamples
+					&& monteCarloNoise < params->DOFMaxNoise * 0.01)
+			{
+				repeats = repeat + 1;
+				break;
+			}
+		}
+
+	} // next repeat
+
+	if (monteCarlo || antiAliasing)
+	{
+		if (data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
+		{
+			finalPixel = data->stereo.MixColorsRedCyan(pixelLeftEye, pixelRightEye);
+			finalPixel.R = finalPixel.R / repeats * 2.0f;
+			finalPixel.G = finalPixel.G / repeats * 2.0f;
+			finalPixel.B = finalPixel.B / repeats * 2.0f;
+		}
+		else
+		{
+			finalPixel.R = finalPixelDOF.R / repeats;
+			finalPixel.G = finalPixelDOF.G / repeats;
+			finalPixel.B = finalPixelDOF.B / repeats;
+			alpha = ushort(finalAlphaDOF / repeats);
+			opacity16 = ushort(finalOpacityDOF / repeats);
+			colour.R = uchar(finalColourDOF.R / repeats);
+			colour.G = uchar(finalColourDOF.G / repeats);
+			colour.B = uchar(finalColourDOF.B / repeats);
+		}
+		statistics.totalNumberOfDOFRepeats += repeats - firstRepeat;
+		statistics.totalNoise += monteCarloNoise;
+
+		if (monteCarloPixel)
+		{
+			// noise of previous pass is replaced by the new one
+			if (firstRepeat > 0) statistics.totalNoise -= monteCarloPixel->noise;
+			monteCarloPixel->samples = repeats;
+			monteCarloPixel->pixelSum = finalPixelDOF;
+			monteCarloPixel->alphaSum = finalAlphaDOF;
+			monteCarloPixel->opacitySum = finalOpacityDOF;
+			monteCarloPixel->colourSum = finalColourDOF;
+			monteCarloPixel->stdDevSum = monteCarloDOFStdDevSum;
+			monteCarloPixel->noise = float(monteCarloNoise);
+		}
+	}
+	else if (data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
+	{
+		finalPixel = data->stereo.MixColorsRedCyan(pixelLeftEye, pixelRightEye);
+	}
 
-				if (data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
+	for (int yy = 0; yy < progressiveStep; ++yy)
+	{
+		int yyy = screenPoint.y + yy;
+		if (yyy < data->screenRegion.y2)
+		{
+			for (int xx = 0; xx < progressiveStep; ++xx)
+			{
+				int xxx = screenPoint.x + xx;
+				if (xxx < data->screenRegion.x2)
 				{
-					if (stereoEye == cStereo::eyeLeft)
+					image->PutPixelImage(xxx, yyy, finalPixel);
+					image->PutPixelColor(xxx, yyy, colour);
+					image->PutPixelAlpha(xxx, yyy, alpha);
+					image->PutPixelZBuffer(xxx, yyy, float(depth));
+					image->PutPixelOpacity(xxx, yyy, opacity16);
+					if (image->GetImageOptional()->optionalNormal)
+						image->PutPixelNormal(xxx, yyy, normalFloat);
+					if (image->GetImageOptional()->optionalNormalWorld)
+						image->PutPixelNormalWorld(xxx, yyy, normalFloatWorld);
+					if (image->GetImageOptional()->optionalSpecular)
+						image->PutPixelSpecular(xxx, yyy, specularFloat);
+					if (image->GetImageOptional()->optionalWorld)
+						image->PutPixelWorld(xxx, yyy, worldPositionRGB);
+					if (image->GetImageOptional()->optionalDiffuse)
+						image->PutPixelDiffuse(
+							xxx, yyy, sRGBFloat(colour.R / 255.0f, colour.G / 255.0f, colour.B / 255.0f));
+					if (image->GetImageOptional()->optionalSampleCount)
 					{
-						pixelLeftEye.R += finalPixel.R;
-						pixelLeftEye.G += finalPixel.G;
-						pixelLeftEye.B += finalPixel.B;
-					}
-					else if (stereoEye == cStereo::eyeRight)
-					{
-						pixelRightEye.R += finalPixel.R;
-						pixelRightEye.G += finalPixel.G;
-						pixelRightEye.B += finalPixel.B;
+						float sampleCount = float(repeats) / maxRepeats;
+						image->PutPixelSampleCount(xxx, yyy, sRGBFloat(sampleCount, sampleCount, sampleCount));
 					}
 				}
+			}
+		}
+	}
 
-				alpha = ushort(resultShader.A * 65535);
-				opacity16 = ushort(opacity * 65535);
+	if (firstRepeat == 0) statistics.numberOfRenderedPixels++;
+}
 
-				colour.R = uchar(objectColour.R * 255);
-				colour.G = uchar(objectColour.G * 255);
-				colour.B = uchar(objectColour.B * 255);
+// adaptive anti-aliasing is used only when each pixel has more samples only because of
+// anti-aliasing
+bool cRenderWorker::UseAdaptiveAntialiasing(const sParamRender *params, const sRenderData *data)
+{
+	return params->antialiasingEnabled && params->antialiasingAdaptive
+				 && params->antialiasingSize > 1 && !params->DOFMonteCarlo
+				 && !data->configuration.UseNetRender();
+}
 
-				if (image->GetImageOptional()->optionalNormal)
-				{
-					CVector3 normalRotated = mRotInv.RotateVector(normal);
-					normalRotated.Normalize();
-					normalFloat.R = (1.0 + normalRotated.x) / 2.0;
-					normalFloat.G = (1.0 + normalRotated.z) / 2.0;
-					normalFloat.B = (1.0 - normalRotated.y) / 2.0; // <-- Also normalized B component.
-					// normalFloat.B = 1.0 - normalRotated.y;  // <-- old
-				}
+// in tile convergence mode the Monte Carlo sampling is continued in additional passes. Not
+// possible with red-cyan stereo (eyes are mixed in one pixel) and NetRender (only complete
+// lines can be exchanged)
+bool cRenderWorker::UseMonteCarloTiles(const sParamRender *params, const sRenderData *data)
+{
+	return params->DOFMonteCarlo && params->DOFMonteCarloTileConvergence
+				 && !(data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
+				 && !data->configuration.UseNetRender();
+}
 
-				if (image->GetImageOptional()->optionalNormalWorld)
-				{
-					CVector3 normalNormalized = normal;
-					normalNormalized.Normalize();
-					normalFloatWorld.R = normalNormalized.x;
-					normalFloatWorld.G = normalNormalized.y;
-					normalFloatWorld.B = normalNormalized.z;
-				}
+// direction of primary ray for given pixel (without anti-aliasing, DOF and stereo)
+CVector3 cRenderWorker::PrimaryRayDirection(int xs, int ys) const
+{
+	CVector2<int> screenPoint(xs, ys);
+	CVector2<double> imagePoint = data->frameRegion.transpose(data->imageRegion, screenPoint);
+	imagePoint.x *= aspectRatio;
+	CVector3 direction = CalculateViewVector(imagePoint, params->fov, params->perspectiveType, mRot);
+	direction.Normalize();
+	return direction;
+}
 
-				finalPixelDOF.R += finalPixel.R;
-				finalPixelDOF.G += finalPixel.G;
-				finalPixelDOF.B += finalPixel.B;
-				finalAlphaDOF += alpha;
-				finalOpacityDOF += opacity16;
-				finalColourDOF.R += colour.R;
-				finalColourDOF.G += colour.G;
-				finalColourDOF.B += colour.B;
-
-				// noise estimation
-				if (monteCarlo)
-				{
-					monteCarloNoise =
-						MonteCarloDOFNoiseEstimation(finalPixel, repeat, finalPixelDOF, monteCarloDOFStdDevSum);
+// start distance of primary ray from the cone marching pre-pass. Cones are marched for pixels
+// rendered in the coarse progressive passes (one pixel per block), and the finer passes reuse
+// them for all pixels of the block
+double cRenderWorker::ConeStartDistance(int xs, int ys, int progressiveStep)
+{
+	int blocksX = (image->GetWidth() + CONE_PREPASS_BLOCK_SIZE - 1) / CONE_PREPASS_BLOCK_SIZE;
+	double &coneStart = threadData->coneStartDistances[(ys / CONE_PREPASS_BLOCK_SIZE) * blocksX
+																										 + xs / CONE_PREPASS_BLOCK_SIZE];
+	if (progressiveStep >= CONE_PREPASS_BLOCK_SIZE)
+		coneStart = ConeMarching(xs / CONE_PREPASS_BLOCK_SIZE, ys / CONE_PREPASS_BLOCK_SIZE);
+	return coneStart;
+}
 
-					if (repeat > params->DOFMinSamples && monteCarloNoise < params->DOFMaxNoise * 0.01)
-					{
-						repeats = repeat + 1;
-						break;
-					}
-				}
+// Marching of one cone which contains primary rays of all pixels of the block (with one pixel of
+// margin for anti-aliasing samples). Sphere of radius 'dist' around the axis point at 'scan'
+// contains the whole cone up to the distance (dist + scan) / (1 + tan(angle)), so the step is
+// (dist - coneRadius) / (1 + tan(angle)). Marching stops when the cone reaches the surface. All
+// rays of the block can start at the returned distance
+double cRenderWorker::ConeMarching(int blockX, int blockY)
+{
+	int x1 = blockX * CONE_PREPASS_BLOCK_SIZE - 1;
+	int y1 = blockY * CONE_PREPASS_BLOCK_SIZE - 1;
+	int x2 = x1 + CONE_PREPASS_BLOCK_SIZE + 1;
+	int y2 = y1 + CONE_PREPASS_BLOCK_SIZE + 1;
+
+	// rays of three-point perspective are inside the pyramid spanned by the corner rays
+	CVector3 corners[4] = {PrimaryRayDirection(x1, y1), PrimaryRayDirection(x2, y1),
+		PrimaryRayDirection(x1, y2), PrimaryRayDirection(x2, y2)};
+	CVector3 axis = corners[0] + corners[1] + corners[2] + corners[3];
+	axis.Normalize();
+	double minCos = 1.0;
+	for (const CVector3 &corner : corners)
+		minCos = qMin(minCos, axis.Dot(corner));
+	double tanAngle = sqrt(1.0 - minCos * minCos) / minCos;
+
+	// DE factor higher than 1.0 is not safe for cones
+	double stepFactor = qMin(params->DEFactor, 1.0) / (1.0 + tanAngle);
+
+	double scan = 0.0;
+	for (int i = 0; i < MAX_RAYMARCHING; i++)
+	{
+		CVector3 point = params->camera + axis * scan;
+		double distThresh = CalcDistThresh(point);
+		sDistanceIn distanceIn(point, distThresh, false);
+		sDistanceOut distanceOut;
+		double dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
 
-			} // next repeat
+		statistics.histogramIterations.Add(distanceOut.iters);
+		statistics.totalNumberOfIterations += distanceOut.totalIters;
 
-			if (monteCarlo || antiAliasing)
-			{
-				if (data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
-				{
-					finalPixel = data->stereo.MixColorsRedCyan(pixelLeftEye, pixelRightEye);
-					finalPixel.R = finalPixel.R / repeats * 2.0f;
-					finalPixel.G = finalPixel.G / repeats * 2.0f;
-					finalPixel.B = finalPixel.B / repeats * 2.0f;
-				}
-				else
-				{
-					finalPixel.R = finalPixelDOF.R / repeats;
-					finalPixel.G = finalPixelDOF.G / repeats;
-					finalPixel.B = finalPixelDOF.B / repeats;
-					alpha = ushort(finalAlphaDOF / repeats);
-					opacity16 = ushort(finalOpacityDOF / repeats);
-					colour.R = uchar(finalColourDOF.R / repeats);
-					colour.G = uchar(finalColourDOF.G / repeats);
-					colour.B = uchar(finalColourDOF.B / repeats);
-				}
-				data->statistics.totalNumberOfDOFRepeats += repeats;
-				data->statistics.totalNoise += monteCarloNoise;
-			}
-			else if (data->stereo.isEnabled() && data->stereo.GetMode() == cStereo::stereoRedCyan)
+		double coneRadius = scan * tanAngle;
+		if (dist < coneRadius + distThresh) break;
+
+		scan += (dist - coneRadius) * stepFactor;
+		if (scan > params->viewDistanceMax)
+		{
+			scan = params->viewDistanceMax;
+			break;
+		}
+	}
+	return scan;
+}
+
+// returns index of pixel in the packet of primary rays. New packet is marched if pixel is not
+// in actual one
+int cRenderWorker::PrimaryRayPacketLane(int xs, int ys, int progressiveStep)
+{
+	if (primaryRayPacket.y == ys)
+	{
+		for (int lane = 0; lane < primaryRayPacket.count; lane++)
+		{
+			if (primaryRayPacket.x[lane] == xs) return lane;
+		}
+	}
+	MarchPrimaryRayPacket(xs, ys, progressiveStep);
+	return 0;
+}
+
+// Ray-marching of primary rays for next pixels in the line. Distances for all rays are
+// calculated together by CalculateDistancePacket(). Rays stop one step before the surface,
+// and RayMarching() continues from there (with binary search, shaders, etc.)
+void cRenderWorker::MarchPrimaryRayPacket(int xs, int ys, int progressiveStep)
+{
+	const int size = FRACTAL_PACKET_SIZE;
+
+	// the same pixels which will be rendered in RenderLines() or RenderTiles()
+	bool skipPreviousPass =
+		threadData->scheduler->SkipPreviousPassPixels() && ys % (progressiveStep * 2) == 0;
+	primaryRayPacket.y = ys;
+	primaryRayPacket.count = 0;
+	for (int x = xs; x <= data->screenRegion.x2 && primaryRayPacket.count < size;
+			 x += progressiveStep)
+	{
+		if (skipPreviousPass && x % (progressiveStep * 2) == 0) continue;
+		primaryRayPacket.x[primaryRayPacket.count] = x;
+		primaryRayPacket.count++;
+	}
+
+	CVector3 direction[size];
+	double scan[size];
+	double step[size];
+	int stepCount[size];
+	sDistancePacket packet;
+
+	for (int lane = 0; lane < size; lane++)
+	{
+		packet.active[lane] = lane < primaryRayPacket.count;
+		direction[lane] = packet.active[lane] ? PrimaryRayDirection(primaryRayPacket.x[lane], ys)
+																					: CVector3(1.0, 0.0, 0.0);
+		scan[lane] = (packet.active[lane] && conePrepass)
+									 ? ConeStartDistance(primaryRayPacket.x[lane], ys, progressiveStep)
+									 : 0.0;
+		step[lane] = 0.0;
+		stepCount[lane] = 0;
+		primaryRayPacket.startScan[lane] = scan[lane];
+		primaryRayPacket.initialStep[lane] = 0.0;
+		primaryRayPacket.prefixStepsCount[lane] = 0;
+	}
+
+	for (int i = 0; i < MAX_PACKET_RAYMARCHING; i++)
+	{
+		bool anyActive = false;
+		for (int lane = 0; lane < size; lane++)
+		{
+			CVector3 point = params->camera + direction[lane] * scan[lane];
+			packet.x[lane] = point.x;
+			packet.y[lane] = point.y;
+			packet.z[lane] = point.z;
+			packet.detailSize[lane] = CalcDistThresh(point);
+			anyActive |= packet.active[lane];
+		}
+		if (!anyActive) break;
+
+		CalculateDistancePacket(*params, *fractal, &packet);
+
+		for (int lane = 0; lane < size; lane++)
+		{
+			if (!packet.active[lane]) continue;
+
+			statistics.histogramIterations.Add(packet.iters[lane]);
+			statistics.totalNumberOfIterations += packet.iters[lane];
+
+			double dist = packet.distance[lane];
+			double distThresh = packet.detailSize[lane];
+			if (dist < distThresh)
 			{
-				finalPixel = data->stereo.MixColorsRedCyan(pixelLeftEye, pixelRightEye);
+				packet.active[lane] = false;
+				continue;
 			}
 
-			for (int yy = 0; yy < scheduler->GetProgressiveStep(); ++yy)
+			// the same step as in RayMarching() (without random dithering)
+			double newStep = (dist - 0.5 * distThresh) * params->DEFactor;
+			if (params->advancedQuality)
 			{
-				int yyy = screenPoint.y + yy;
-				if (yyy < data->screenRegion.y2)
+				if (newStep > params->absMaxMarchingStep) newStep = params->absMaxMarchingStep;
+				if (newStep < params->absMinMarchingStep) newStep = params->absMinMarchingStep;
+				if (distThresh > params->absMinMarchingStep)
 				{
-					for (int xx = 0; xx < scheduler->GetProgressiveStep(); ++xx)
-					{
-						int xxx = screenPoint.x + xx;
-						if (xxx < data->screenRegion.x2)
-						{
-							image->PutPixelImage(xxx, yyy, finalPixel);
-							image->PutPixelColor(xxx, yyy, colour);
-							image->PutPixelAlpha(xxx, yyy, alpha);
-							image->PutPixelZBuffer(xxx, yyy, float(depth));
-							image->PutPixelOpacity(xxx, yyy, opacity16);
-							if (image->GetImageOptional()->optionalNormal)
-								image->PutPixelNormal(xxx, yyy, normalFloat);
-							if (image->GetImageOptional()->optionalNormalWorld)
-								image->PutPixelNormalWorld(xxx, yyy, normalFloatWorld);
-							if (image->GetImageOptional()->optionalSpecular)
-								image->PutPixelSpecular(xxx, yyy, specularFloat);
-							if (image->GetImageOptional()->optionalWorld)
-								image->PutPixelWorld(xxx, yyy, worldPositionRGB);
-							if (image->GetImageOptional()->optionalDiffuse)
-								image->PutPixelDiffuse(
-									xxx, yyy, sRGBFloat(colour.R / 255.0f, colour.G / 255.0f, colour.B / 255.0f));
-						}
-					}
+					if (newStep > params->relMaxMarchingStep * distThresh)
+						newStep = params->relMaxMarchingStep * distThresh;
 				}
+				if (newStep < params->relMinMarchingStep * distThresh)
+					newStep = params->relMinMarchingStep * distThresh;
+			}
+			else
+			{
+				if (newStep > 3.0) newStep = 3.0;
 			}
 
-			data->statistics.numberOfRenderedPixels++;
-
-		} // next xs
-	}		// next ys
-
-	// emit signal to main thread when finished
-	emit finished();
-	return;
+			// previous point was not a hit, so it will be the start point for RayMarching()
+			sStep &stepData = packetStepBuff[lane * MAX_PACKET_RAYMARCHING + stepCount[lane]];
+			stepData.distance = dist;
+			stepData.iters = packet.iters[lane];
+			stepData.distThresh = distThresh;
+			stepData.step = step[lane];
+			stepData.point = CVector3(packet.x[lane], packet.y[lane], packet.z[lane]);
+			primaryRayPacket.prefixStepsCount[lane] = stepCount[lane];
+			primaryRayPacket.startScan[lane] = scan[lane];
+			primaryRayPacket.initialStep[lane] = step[lane];
+			stepCount[lane]++;
+
+			step[lane] = newStep;
+			scan[lane] += newStep;
+			if (scan[lane] > params->viewDistanceMax || newStep <= 0.0) packet.active[lane] = false;
+		}
+	}
 }
 
 // calculation of base vectors
 void cRenderWorker::PrepareMainVectors()
 {
+	// worker could be used already for previous image
+	if (cameraTarget) delete cameraTarget;
+	mRot = CRotationMatrix();
+	baseX = CVector3(1.0, 0.0, 0.0);
+	baseY = CVector3(0.0, 1.0, 0.0);
+	baseZ = CVector3(0.0, 0.0, 1.0);
+
 	cameraTarget = new cCameraTarget(params->camera, params->target, params->topVector);
 	// cameraTarget->SetCameraTargetRotation(params->camera, params->target, params->viewAngle);
 	viewAngle = cameraTarget->GetRotation();
@@ -539,9 +1022,22 @@ void cRenderWorker::PrepareMainVectors()
 // reflection data
 void cRenderWorker::PrepareReflectionBuffer()
 {
+	int newReflectionsMax = params->reflectionsMax * 1;
+	if (!params->raytracedReflections) newReflectionsMax = 0;
 
-	reflectionsMax = params->reflectionsMax * 1;
-	if (!params->raytracedReflections) reflectionsMax = 0;
+	// buffers from previous image are reused if they have the same size
+	if (rayBuffer && newReflectionsMax == reflectionsMax)
+	{
+		for (int i = 0; i < reflectionsMax + 3; i++)
+		{
+			rayBuffer[i].buffCount = 0;
+		}
+		return;
+	}
+
+	FreeReflectionBuffer();
+
+	reflectionsMax = newReflectionsMax;
 	rayBuffer = new sRayBuffer[reflectionsMax + 4];
 
 	for (int i = 0; i < reflectionsMax + 3; i++)
@@ -554,10 +1050,29 @@ void cRenderWorker::PrepareReflectionBuffer()
 	rayStack = new sRayStack[reflectionsMax + 1];
 }
 
+void cRenderWorker::FreeReflectionBuffer()
+{
+	if (rayBuffer)
+	{
+		for (int i = 0; i < reflectionsMax + 3; i++)
+		{
+			delete[] rayBuffer[i].stepBuff;
+		}
+		delete[] rayBuffer;
+		rayBuffer = nullptr;
+	}
+
+	if (rayStack)
+	{
+		delete[] rayStack;
+		rayStack = nullptr;
+	}
+}
+
 // calculating vectors for AmbientOcclusion
 void cRenderWorker::PrepareAOVectors()
 {
-	AOVectorsAround = new sVectorsAround[10000];
+	if (!AOVectorsAround) AOVectorsAround = new sVectorsAround[10000];
 	AOVectorsCount = 0;
 	int counter = 0;
 	int lightMapWidth = data->textures.lightmapTexture.Width();
@@ -600,6 +1115,28 @@ void cRenderWorker::PrepareAOVectors()
 	AOVectorsCount = counter;
 }
 
+// limits of ray-marching step set in advanced quality settings
+double cRenderWorker::LimitMarchingStep(double step, double distThresh) const
+{
+	if (params->advancedQuality)
+	{
+		if (step > params->absMaxMarchingStep) step = params->absMaxMarchingStep;
+		if (step < params->absMinMarchingStep) step = params->absMinMarchingStep;
+		if (distThresh > params->absMinMarchingStep)
+		{
+			if (step > params->relMaxMarchingStep * distThresh)
+				step = params->relMaxMarchingStep * distThresh;
+		}
+		if (step < params->relMinMarchingStep * distThresh)
+			step = params->relMinMarchingStep * distThresh;
+	}
+	else
+	{
+		if (step > 3.0) step = 3.0;
+	}
+	return step;
+}
+
 // calculation of distance where ray-marching stops
 double cRenderWorker::CalcDistThresh(CVector3 point) const
 {
@@ -638,6 +1175,107 @@ double cRenderWorker::CalcDelta(CVector3 point) const
 	return delta;
 }
 
+// clips range [minScan, maxScan] of the ray start + direction * scan to the limits box and the
+// bounding sphere. Returns false if the ray misses them
+bool cRenderWorker::ClipRayToBounds(
+	const CVector3 &start, const CVector3 &direction, double *minScan, double *maxScan) const
+{
+	double scanNear = *minScan;
+	double scanFar = *maxScan;
+
+	if (params->limitsEnabled)
+	{
+		const double origin[3] = {start.x, start.y, start.z};
+		const double dir[3] = {direction.x, direction.y, direction.z};
+		const double boxMin[3] = {params->limitMin.x, params->limitMin.y, params->limitMin.z};
+		const double boxMax[3] = {params->limitMax.x, params->limitMax.y, params->limitMax.z};
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (dir[axis] == 0.0)
+			{
+				if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) return false;
+			}
+			else
+			{
+				double scan1 = (boxMin[axis] - origin[axis]) / dir[axis];
+				double scan2 = (boxMax[axis] - origin[axis]) / dir[axis];
+				if (scan1 > scan2) std::swap(scan1, scan2);
+				scanNear = qMax(scanNear, scan1);
+				scanFar = qMin(scanFar, scan2);
+			}
+		}
+	}
+
+	if (params->boundingSphereEnabled)
+	{
+		// solution of |start + direction * scan - center| = radius
+		CVector3 toStart = start - params->boundingSphereCenter;
+		double a = direction.Dot(direction);
+		double b = toStart.Dot(direction);
+		double c = toStart.Dot(toStart) - params->boundingSphereRadius * params->boundingSphereRadius;
+		double discriminant = b * b - a * c;
+		if (discriminant < 0.0) return false;
+		double sqrtDiscriminant = sqrt(discriminant);
+		scanNear = qMax(scanNear, (-b - sqrtDiscriminant) / a);
+		scanFar = qMin(scanFar, (-b + sqrtDiscriminant) / a);
+	}
+
+	if (scanNear > scanFar) return false;
+
+	*minScan = scanNear;
+	*maxScan = scanFar;
+	return true;
+}
+
+// rays can be clipped to the limits box and the bounding sphere only if there are no volumetric
+// effects which are calculated also outside of them
+bool cRenderWorker::UseRayClipping(const sParamRender *params, const sRenderData *data)
+{
+	if (!params->limitsEnabled && !params->boundingSphereEnabled) return false;
+
+	return !UseVolumetricEffects(params, data);
+}
+
+// volumetric effects are calculated from all ray-marching steps, so rays cannot skip any part
+// of the space between the camera and the surface
+bool cRenderWorker::UseVolumetricEffects(const sParamRender *params, const sRenderData *data)
+{
+	bool visibleLights = data->lights.IsAnyLightEnabled() && params->auxLightVisibility > 0.0;
+	return params->fogEnabled || params->volFogEnabled || params->glowEnabled
+				 || params->iterFogEnabled || params->cloudsEnable || params->volumetricLightAnyEnabled
+				 || params->fakeLightsEnabled || visibleLights;
+}
+
+// distance cache is used only if distance estimation doesn't depend on the camera and all
+// ray-marching steps are not needed by volumetric effects
+bool cRenderWorker::UseDistanceCache(const sParamRender *params, const sRenderData *data)
+{
+	if (!params->distanceCacheEnabled || params->common.iterThreshMode) return false;
+
+	return !UseVolumetricEffects(params, data);
+}
+
+// cone marching pre-pass is used only for perspective where primary rays of the block of pixels
+// are inside the cone from the camera, and if all steps of primary rays are not needed by
+// volumetric effects. With NetRender there are no coarse progressive passes
+bool cRenderWorker::UseConePrepass(const sParamRender *params, const sRenderData *data)
+{
+	if (!params->conePrepassEnabled || params->common.iterThreshMode) return false;
+	if (params->perspectiveType != params::perspThreePoint || params->DOFMonteCarlo) return false;
+	if (data->stereo.isEnabled() || data->configuration.UseNetRender()) return false;
+
+	return !UseVolumetricEffects(params, data);
+}
+
+// over-relaxed steps can go back, which is not allowed for ray-marching steps used by volumetric
+// effects
+bool cRenderWorker::UseOverRelaxation(const sParamRender *params, const sRenderData *data)
+{
+	if (!params->overRelaxationEnabled || params->overRelaxationFactor <= 1.0) return false;
+
+	return !UseVolumetricEffects(params, data);
+}
+
 // Ray-Marching
 void cRenderWorker::RayMarching(
 	sRayMarchingIn &in, sRayMarchingInOut *inOut, sRayMarchingOut *out) const
@@ -654,12 +1292,52 @@ void cRenderWorker::RayMarching(
 	double distThresh = 0;
 	out->objectId = 0;
 
+	// analytic clipping of the ray to the limits box and the bounding sphere. Inside objects the
+	// box is the end of the object, so there it has to be found by ray-marching
+	if (rayClipping && !in.invertMode)
+	{
+		if (!ClipRayToBounds(in.start, in.direction, &in.minScan, &in.maxScan))
+		{
+			// the ray misses the bounds, so there is nothing to march
+			statistics.histogramStepCount.Add(0);
+			out->found = false;
+			out->lastDist = in.maxScan;
+			out->depth = in.maxScan;
+			out->point = in.start + in.direction * in.maxScan;
+			out->distThresh = CalcDistThresh(out->point);
+			statistics.numberOfRaymarchings++;
+			return;
+		}
+		scan = in.minScan;
+	}
+
+	// steps done already by packet ray-marching
+	int firstStep = 0;
+	if (in.prefixSteps)
+	{
+		for (int i = 0; i < in.prefixStepsCount; i++)
+			inOut->stepBuff[i] = in.prefixSteps[i];
+		firstStep = in.prefixStepsCount;
+		(*inOut->buffCount) = firstStep;
+		counter = firstStep;
+		step = in.initialStep;
+	}
+
 	// qDebug() << "Start ************************";
 
 	CVector3 lastPoint;
 	bool deadComputationFound = false;
 
-	for (int i = 0; i < MAX_RAYMARCHING; i++)
+	// over-relaxed sphere tracing: steps are longer than the distance as long as the unbounding
+	// spheres of consecutive points overlap. Inverted distance inside objects is not a distance to
+	// the surface, so there are used only normal steps
+	double relaxation = (overRelaxation && !in.invertMode) ? params->overRelaxationFactor : 1.0;
+	bool lastStepRelaxed = false;
+	double previousDist = 0.0;
+	double previousScan = scan;
+	double unrelaxedStep = 0.0;
+
+	for (int i = firstStep; i < MAX_RAYMARCHING; i++)
 	{
 		lastPoint = point;
 
@@ -680,63 +1358,94 @@ void cRenderWorker::RayMarching(
 
 		distThresh = CalcDistThresh(point);
 
-		sDistanceIn distanceIn(point, distThresh, false);
-		sDistanceOut distanceOut;
-		dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
-		// qDebug() <<"thresh" <<  distThresh << "dist" << dist << "scan" << scan;
-		if (in.invertMode)
+		double cachedDist = 0.0;
+		double objectDist = 0.0;
+		if (distanceCache && !in.invertMode)
+			cachedDist = data->distanceCache.LowerBound(point, dist - step);
+
+		bool distanceFromCache = cachedDist > 4.0 * distThresh;
+		if (distanceFromCache)
 		{
-			dist = distThresh * 1.99 - dist;
-			if (dist < 0.0) dist = 0.0;
+			// far from surfaces the lower bound from distance cache is enough to make the step
+			dist = cachedDist;
+			inOut->stepBuff[i].distance = dist;
+			inOut->stepBuff[i].iters = 0;
+			inOut->stepBuff[i].distThresh = distThresh;
 		}
-		out->objectId = distanceOut.objectId;
-
-		//-------------------- 4.18us for Calculate distance --------------
+		else
+		{
+			sDistanceIn distanceIn(point, distThresh, false);
+			sDistanceOut distanceOut;
+			dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
+			objectDist = distanceOut.objectDistance;
+			// qDebug() <<"thresh" <<  distThresh << "dist" << dist << "scan" << scan;
+			if (in.invertMode)
+			{
+				dist = distThresh * 1.99 - dist;
+				if (dist < 0.0) dist = 0.0;
+			}
+			out->objectId = distanceOut.objectId;
 
-		// printf("Distance = %g\n", dist/distThresh);
-		inOut->stepBuff[i].distance = dist;
-		inOut->stepBuff[i].iters = distanceOut.iters;
-		inOut->stepBuff[i].distThresh = distThresh;
+			//-------------------- 4.18us for Calculate distance --------------
 
-		data->statistics.histogramIterations.Add(distanceOut.iters);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+			// printf("Distance = %g\n", dist/distThresh);
+			inOut->stepBuff[i].distance = dist;
+			inOut->stepBuff[i].iters = distanceOut.iters;
+			inOut->stepBuff[i].distThresh = distThresh;
 
-		if (dist < distThresh)
-		{
-			if (dist < 0.1 * distThresh) data->statistics.missedDE++;
-			found = true;
-			break;
+			statistics.histogramIterations.Add(distanceOut.iters);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
 		}
 
-		inOut->stepBuff[i].step = step;
-		if (params->interiorMode)
-		{
-			step = (dist - 0.8 * distThresh) * params->DEFactor * (1.0 - Random(1000) / 10000.0);
-		}
-		else
+		// the over-relaxed step was too long if the unbounding spheres of this and the previous
+		// point don't overlap (a surface could be skipped). The step is repeated without
+		// over-relaxation, which is not used any more for this ray
+		if (lastStepRelaxed && dist + previousDist < step)
 		{
-			step = (dist - 0.5 * distThresh) * params->DEFactor * (1.0 - Random(1000) / 10000.0);
+			step = unrelaxedStep;
+			scan = previousScan + step / in.direction.Length();
+			relaxation = 1.0;
+			lastStepRelaxed = false;
+			i--;
+			continue;
 		}
 
-		if (params->advancedQuality)
+		if (!distanceFromCache)
 		{
-			if (step > params->absMaxMarchingStep) step = params->absMaxMarchingStep;
-			if (step < params->absMinMarchingStep) step = params->absMinMarchingStep;
-			if (distThresh > params->absMinMarchingStep)
+			if (dist < distThresh)
 			{
-				if (step > params->relMaxMarchingStep * distThresh)
-					step = params->relMaxMarchingStep * distThresh;
+				if (dist < 0.1 * distThresh) statistics.missedDE++;
+				found = true;
+				break;
 			}
-			if (step < params->relMinMarchingStep * distThresh)
-				step = params->relMinMarchingStep * distThresh;
+
+			// distances far from surfaces are stored for the next passes and frames
+			// stored is the distance before clamping to minimum view distance, which depends on camera
+			if (distanceCache && !in.invertMode && objectDist > 8.0 * distThresh)
+				data->distanceCache.AddDistance(point, objectDist, &newDistanceCacheCells);
+		}
+
+		inOut->stepBuff[i].step = step;
+		if (params->interiorMode)
+		{
+			step = (dist - 0.8 * distThresh) * params->DEFactor
+						 * (1.0 - pixelRandom.Random(1000) / 10000.0);
 		}
 		else
 		{
-			if (step > 3.0) step = 3.0;
+			step = (dist - 0.5 * distThresh) * params->DEFactor
+						 * (1.0 - pixelRandom.Random(1000) / 10000.0);
 		}
+		// normal step is kept in case the over-relaxed one has to be repeated
+		unrelaxedStep = LimitMarchingStep(step, distThresh);
+		step = LimitMarchingStep(step * relaxation, distThresh);
 
 		inOut->stepBuff[i].point = point;
 
+		lastStepRelaxed = relaxation > 1.0;
+		previousDist = dist;
+		previousScan = scan;
+
 		(*inOut->buffCount) = i + 1;
 		// divided by length of view Vector to eliminate overstepping when fov is big
 		scan += step / in.direction.Length();
@@ -791,8 +1500,8 @@ void cRenderWorker::RayMarching(
 
 			out->objectId = distanceOut.objectId;
 
-			data->statistics.histogramIterations.Add(distanceOut.iters);
-			data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+			statistics.histogramIterations.Add(distanceOut.iters);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
 
 			step *= 0.5;
 		}
@@ -806,14 +1515,14 @@ void cRenderWorker::RayMarching(
 
 	//---------- 7.19605us for binary searching ---------------
 
-	data->statistics.histogramStepCount.Add(counter);
+	statistics.histogramStepCount.Add(counter);
 
 	out->found = found;
 	out->lastDist = dist;
 	out->depth = scan;
 	out->distThresh = distThresh;
 	out->point = point;
-	data->statistics.numberOfRaymarchings++;
+	statistics.numberOfRaymarchings++;
 }
 
 cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
@@ -859,8 +1568,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			shaderInputData.stepBuff = inOut.rayMarchingInOut.stepBuff;
 			shaderInputData.invertMode = rayStack[rayIndex].in.calcInside;
 			shaderInputData.objectId = rayMarchingOut.objectId;
-			cObjectData objectData = data->objectData[shaderInputData.objectId];
-			shaderInputData.material = &data->materials[objectData.materialId];
+			shaderInputData.material = data->GetObjectMaterial(shaderInputData.objectId);
 
 			float reflect = shaderInputData.material->reflectance;
 			float transparent = shaderInputData.material->transparencyOfSurface;
@@ -896,11 +1604,11 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 				if (shaderInputData.material->roughSurface)
 				{
 					vn.x += roughnessTex * roughnessGradient * shaderInputData.material->surfaceRoughness
-									* (Random(20000) / 10000.0f - 1.0f);
+									* (pixelRandom.Random(20000) / 10000.0f - 1.0f);
 					vn.y += roughnessTex * roughnessGradient * shaderInputData.material->surfaceRoughness
-									* (Random(20000) / 10000.0f - 1.0f);
+									* (pixelRandom.Random(20000) / 10000.0f - 1.0f);
 					vn.z += roughnessTex * roughnessGradient * shaderInputData.material->surfaceRoughness
-									* (Random(20000) / 10000.0f - 1.0f);
+									* (pixelRandom.Random(20000) / 10000.0f - 1.0f);
 					vn.Normalize();
 				}
 				shaderInputData.normal = vn;
@@ -961,6 +1669,9 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 							rayMarchingIn.minScan = 0.0;
 							rayMarchingIn.start = newPoint;
 							rayMarchingIn.invertMode = false;
+							rayMarchingIn.prefixSteps = nullptr;
+							rayMarchingIn.prefixStepsCount = 0;
+							rayMarchingIn.initialStep = 0.0;
 							recursionIn.rayMarchingIn = rayMarchingIn;
 							recursionIn.calcInside = false;
 							recursionIn.resultShader = rayStack[rayIndex - 1].in.resultShader;
@@ -1024,6 +1735,9 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 							rayMarchingIn.start = newPoint;
 							rayMarchingIn.invertMode =
 								!rayStack[rayIndex - 1].in.calcInside || internalReflection;
+							rayMarchingIn.prefixSteps = nullptr;
+							rayMarchingIn.prefixStepsCount = 0;
+							rayMarchingIn.initialStep = 0.0;
 							recursionIn.rayMarchingIn = rayMarchingIn;
 							recursionIn.calcInside = !rayStack[rayIndex - 1].in.calcInside || internalReflection;
 							recursionIn.resultShader = rayStack[rayIndex - 1].in.resultShader;
@@ -1092,8 +1806,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			shaderInputData.stepBuff = inOut.rayMarchingInOut.stepBuff;
 			shaderInputData.invertMode = rayStack[rayIndex].in.calcInside;
 			shaderInputData.objectId = rayMarchingOut.objectId;
-			cObjectData objectData = data->objectData[shaderInputData.objectId];
-			shaderInputData.material = &data->materials[objectData.materialId];
+			shaderInputData.material = data->GetObjectMaterial(shaderInputData.objectId);
 
 			shaderInputData.normal = recursionOut.normal;
 
@@ -1374,8 +2087,9 @@ void cRenderWorker::MonteCarloDOF(CVector3 *startRay, CVector3 *viewVector) cons
 {
 	if (params->perspectiveType == params::perspThreePoint)
 	{
-		double randR = 0.0015 * params->DOFRadius * params->DOFFocus * sqrt(Random(65536) / 65536.0);
-		double randAngle = Random(65536);
+		double randR =
+			0.0015 * params->DOFRadius * params->DOFFocus * sqrt(pixelRandom.Random(65536) / 65536.0);
+		double randAngle = pixelRandom.Random(65536);
 		CVector3 randVector(randR * sin(randAngle), 0.0, randR * cos(randAngle));
 		CVector3 randVectorRot = mRot.RotateVector(randVector);
 		CVector3 viewVectorTemp = *viewVector;
@@ -1386,8 +2100,9 @@ void cRenderWorker::MonteCarloDOF(CVector3 *startRay, CVector3 *viewVector) cons
 	else
 	{
 		CVector3 viewVectorTemp = *viewVector;
-		double randR = 0.0015 * params->DOFRadius * params->DOFFocus * sqrt(Random(65536) / 65536.0);
-		double randAngle = Random(65536);
+		double randR =
+			0.0015 * params->DOFRadius * params->DOFFocus * sqrt(pixelRandom.Random(65536) / 65536.0);
+		double randAngle = pixelRandom.Random(65536);
 		CVector3 randVector(randR * sin(randAngle), 0.0, randR * cos(randAngle));
 
 		CVector3 side = viewVectorTemp.Cross(params->topVector);
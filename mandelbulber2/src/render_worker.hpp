@@ -35,11 +35,23 @@
 #ifndef MANDELBULBER2_SRC_RENDER_WORKER_HPP_
 #define MANDELBULBER2_SRC_RENDER_WORKER_HPP_
 
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
 #include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
 
 #include "algebra.hpp"
 #include "color_structures.hpp"
+#include "compute_fractal_packet.hpp"
+#include "distance_cache.hpp"
+#include "pixel_random.hpp"
+#include "scratch_arena.hpp"
+#include "statistics.h"
 #include "texture_enums.hpp"
 
 // forward declarations
@@ -52,8 +64,11 @@ struct sParamRender;
 class cNineFractals;
 class cScheduler;
 class cPerlinNoiseOctaves;
+class cNoiseVolume;
 
 #define MAX_RAYMARCHING 10000
+#define MAX_PACKET_RAYMARCHING 1000
+#define CONE_PREPASS_BLOCK_SIZE 8
 
 // ambient occlusion data
 struct sVectorsAround
@@ -69,17 +84,64 @@ class cRenderWorker : public QObject
 	Q_OBJECT
 
 public:
+	// state of Monte Carlo sampling of pixel, kept between passes in tile convergence mode
+	// sums of samples are kept in full precision, because image stores only averages
+	struct sMonteCarloPixel
+	{
+		int samples{0};
+		sRGBFloat pixelSum;
+		sRGB colourSum;
+		unsigned int alphaSum{0};
+		unsigned int opacitySum{0};
+		sRGBFloat stdDevSum;
+		float noise{0.0f};
+	};
+
 	struct sThreadData
 	{
 		int id;
 		int startLine;
 		cScheduler *scheduler;
+		const QVector<bool> *antialiasingMask; // pixels to supersample in adaptive anti-aliasing pass
+		// per-pixel MC state for tile convergence mode
+		sMonteCarloPixel *monteCarloPixels;
+		// start distances of primary rays for blocks of pixels found in cone marching pre-pass
+		double *coneStartDistances;
 	};
 
 	cRenderWorker(const sParamRender *_params, const cNineFractals *_fractal,
 		sThreadData *_threadData, sRenderData *_data, cImage *_image);
 	~cRenderWorker() override;
 
+	// worker can be reused for next images (see cRenderWorkerPool)
+	void SetRenderData(const sParamRender *_params, const cNineFractals *_fractal,
+		sThreadData *_threadData, sRenderData *_data, cImage *_image);
+	void SetWorking() { working = true; }
+	bool IsWorking() const { return working; }
+	// returns true if the worker finished within timeout (in milliseconds)
+	bool WaitForFinish(unsigned long timeout);
+
+	static bool UseAdaptiveAntialiasing(const sParamRender *params, const sRenderData *data);
+	static bool UseMonteCarloTiles(const sParamRender *params, const sRenderData *data);
+	static bool UseRayClipping(const sParamRender *params, const sRenderData *data);
+	static bool UseDistanceCache(const sParamRender *params, const sRenderData *data);
+	static bool UseVolumetricEffects(const sParamRender *params, const sRenderData *data);
+	static bool UseConePrepass(const sParamRender *params, const sRenderData *data);
+	static bool UseOverRelaxation(const sParamRender *params, const sRenderData *data);
+
+	// adaptive non-DE shading samples lattice 11 x 11 x 11 in levels with decreasing strides.
+	// Returns true if the lattice point is sampled for the first time at the level
+	static const int slowShadingAdaptiveLevels = 4;
+	static bool IsNewSlowShadingPoint(int level, int ix, int iy, int iz);
+
+	// cells of distance cache found by this worker. They are moved to the cache by cRenderer
+	cDistanceCache::tCellMap *GetNewDistanceCacheCells() { return &newDistanceCacheCells; }
+
+	// statistics are collected separately by each worker and merged by cRenderer
+	void ResetStatistics(const cStatistics &pattern);
+	// adds the last snapshot of statistics published by the worker thread
+	void MergeStatisticsTo(cStatistics *target);
+
 	// PrepareAOVectors() is public because is needed also for OpenCL data
 	void PrepareAOVectors();
 	sVectorsAround *getAOVectorsAround() const { return AOVectorsAround; }
@@ -113,6 +175,11 @@ private:
 		double maxScan;
 		bool binaryEnable;
 		bool invertMode;
+		// steps already done by packet ray-marching. They are copied to the step buffer and
+		// ray-marching is continued from minScan with initialStep
+		const sStep *prefixSteps;
+		int prefixStepsCount;
+		double initialStep;
 	};
 
 	struct sRayMarchingInOut
@@ -197,6 +264,17 @@ private:
 		bool goDeeper;
 	};
 
+	// primary rays marched together (see MarchPrimaryRayPacket())
+	struct sPrimaryRayPacket
+	{
+		int y;
+		int count;
+		int x[FRACTAL_PACKET_SIZE];
+		int prefixStepsCount[FRACTAL_PACKET_SIZE];
+		double startScan[FRACTAL_PACKET_SIZE];
+		double initialStep[FRACTAL_PACKET_SIZE];
+	};
+
 	struct sGradientsCollection
 	{
 		sRGBFloat surface;
@@ -209,9 +287,22 @@ private:
 	};
 
 	// functions
+	void RenderLines(cScheduler *scheduler);
+	void PublishStatistics();
+	void RenderTiles(cScheduler *scheduler);
+	void RenderPixel(int xs, int ys, int progressiveStep);
+	int PrimaryRayPacketLane(int xs, int ys, int progressiveStep);
+	void MarchPrimaryRayPacket(int xs, int ys, int progressiveStep);
+	CVector3 PrimaryRayDirection(int xs, int ys) const;
+	double ConeStartDistance(int xs, int ys, int progressiveStep);
+	double ConeMarching(int blockX, int blockY);
 	void PrepareMainVectors();
 	void PrepareReflectionBuffer();
+	void FreeReflectionBuffer();
 	void RayMarching(sRayMarchingIn &in, sRayMarchingInOut *inOut, sRayMarchingOut *out) const;
+	bool ClipRayToBounds(
+		const CVector3 &start, const CVector3 &direction, double *minScan, double *maxScan) const;
+	double LimitMarchingStep(double step, double distThresh) const;
 	double CalcDistThresh(CVector3 point) const;
 	double CalcDelta(CVector3 point) const;
 	static double IterOpacity(
@@ -273,10 +364,40 @@ private:
 	CVector3 baseZ;
 	CVector3 viewAngle;
 	CVector3 shadowVector;
+	double aspectRatio;
 	float actualHue;
 	int AOVectorsCount;
 	int reflectionsMax;
+	int perlinNoiseSeed;
 	bool stopRequest;
+	bool packetMode;
+	bool adaptiveAntialiasing;
+	bool rayClipping; // rays are clipped to the limits box and the bounding sphere
+	bool distanceCache;
+	bool reprojectedStart; // primary rays start at depth reprojected from the previous frame
+	bool conePrepass;
+	bool overRelaxation; // over-relaxed sphere tracing
+	std::atomic<bool> working;
+	QMutex workingMutex;
+	QWaitCondition workingFinished;
+
+	// statistics of this thread (shaders update it, so it's mutable). It's placed between the other
+	// data of the worker, so it doesn't share cache lines with the counters of other threads
+	mutable cStatistics statistics;
+	// snapshot of statistics which can be read by main thread while the worker is running
+	cStatistics publishedStatistics;
+	QMutex statisticsMutex;
+	QElapsedTimer publishStatisticsTimer;
+
+	// random numbers for actually rendered pixel sample (seeded in RenderPixel())
+	mutable cPixelRandom pixelRandom;
+
+	// temporary per-sample buffers of the shaders (kept between samples and images)
+	mutable cScratchArena scratchArena;
+
+	mutable cDistanceCache::tCellMap newDistanceCacheCells;
+
+	sPrimaryRayPacket primaryRayPacket;
 
 	// allocated objects
 	cCameraTarget *cameraTarget;
@@ -284,6 +405,8 @@ private:
 	sRayStack *rayStack;
 	sVectorsAround *AOVectorsAround;
 	cPerlinNoiseOctaves *perlinNoise;
+	QSharedPointer<const cNoiseVolume> noiseVolume; // shared by all workers
+	sStep *packetStepBuff;
 
 public slots:
 	void doWork();
@@ -0,0 +1,147 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cRenderWorkerPool class - process-wide pool of threads for rendering workers
+ *
+ * Threads and workers are kept alive between rendered images, so workers can reuse
+ * their buffers. Idle threads are removed when a render needs fewer of them. Each slot
+ * of the pool has one thread with one cRenderWorker and one cSSAOWorker living in this
+ * thread.
+ */
+
+#include "render_worker_pool.hpp"
+
+#include <QThread>
+
+#include "render_worker.hpp"
+#include "ssao_worker.h"
+#include "system_data.hpp"
+#include "write_log.hpp"
+
+cRenderWorkerPool *gRenderWorkerPool = nullptr;
+
+cRenderWorkerPool::cRenderWorkerPool()
+{
+	// nothing to initialize. Threads are created on demand
+}
+
+cRenderWorkerPool::~cRenderWorkerPool()
+{
+	for (sPoolSlot *poolSlot : allSlots)
+	{
+		DeleteSlot(poolSlot);
+	}
+	allSlots.clear();
+}
+
+void cRenderWorkerPool::DeleteSlot(sPoolSlot *poolSlot)
+{
+	poolSlot->thread->quit();
+	poolSlot->thread->wait();
+	// workers can be deleted here, because their thread is not running anymore
+	if (poolSlot->renderWorker) delete poolSlot->renderWorker;
+	if (poolSlot->ssaoWorker) delete poolSlot->ssaoWorker;
+	delete poolSlot->thread;
+	delete poolSlot;
+}
+
+QList<cRenderWorkerPool::sPoolSlot *> cRenderWorkerPool::Acquire(
+	int numberOfThreads, bool createThreads)
+{
+	QList<sPoolSlot *> acquiredSlots;
+
+	mutex.lock();
+	for (sPoolSlot *poolSlot : allSlots)
+	{
+		if (acquiredSlots.size() >= numberOfThreads) break;
+		if (!poolSlot->busy)
+		{
+			poolSlot->busy = true;
+			acquiredSlots.append(poolSlot);
+		}
+	}
+
+	// not enough idle threads (e.g. more jobs are rendered at the same time)
+	while (createThreads && acquiredSlots.size() < numberOfThreads)
+	{
+		sPoolSlot *poolSlot = new sPoolSlot;
+		poolSlot->thread = new QThread;
+		poolSlot->thread->setObjectName("RenderWorker #" + QString::number(allSlots.size()));
+		poolSlot->thread->start();
+		poolSlot->renderWorker = nullptr;
+		poolSlot->ssaoWorker = nullptr;
+		poolSlot->busy = true;
+		allSlots.append(poolSlot);
+		acquiredSlots.append(poolSlot);
+		WriteLog(QString("Render worker pool: thread ") + QString::number(allSlots.size() - 1)
+							 + " created",
+			3);
+	}
+
+	// threads (with buffers of their workers) which are not needed any more are removed
+	QList<sPoolSlot *> removedSlots;
+	int idleSlots = 0;
+	for (int i = allSlots.size() - 1; i >= 0; i--)
+	{
+		if (allSlots.at(i)->busy) continue;
+		idleSlots++;
+		if (idleSlots > numberOfThreads) removedSlots.append(allSlots.takeAt(i));
+	}
+	mutex.unlock();
+
+	for (sPoolSlot *poolSlot : removedSlots)
+	{
+		DeleteSlot(poolSlot);
+	}
+	if (!removedSlots.isEmpty())
+	{
+		WriteLog(QString("Render worker pool: ") + QString::number(removedSlots.size())
+							 + " idle threads removed",
+			3);
+	}
+
+	for (sPoolSlot *poolSlot : acquiredSlots)
+	{
+		poolSlot->thread->setPriority(systemData.GetQThreadPriority(systemData.threadsPriority));
+	}
+
+	return acquiredSlots;
+}
+
+void cRenderWorkerPool::Release(const QList<sPoolSlot *> &poolSlots)
+{
+	mutex.lock();
+	for (sPoolSlot *poolSlot : poolSlots)
+	{
+		poolSlot->busy = false;
+	}
+	mutex.unlock();
+}
@@ -0,0 +1,82 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cRenderWorkerPool class - process-wide pool of threads for rendering workers
+ *
+ * Threads and workers are kept alive between rendered images, so workers can reuse
+ * their buffers. Idle threads are removed when a render needs fewer of them. Each slot
+ * of the pool has one thread with one cRenderWorker and one cSSAOWorker living in this
+ * thread.
+ */
+
+#ifndef MANDELBULBER2_SRC_RENDER_WORKER_POOL_HPP_
+#define MANDELBULBER2_SRC_RENDER_WORKER_POOL_HPP_
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+// forward declarations
+class QThread;
+class cRenderWorker;
+class cSSAOWorker;
+
+class cRenderWorkerPool
+{
+public:
+	struct sPoolSlot
+	{
+		QThread *thread;
+		cRenderWorker *renderWorker;
+		cSSAOWorker *ssaoWorker;
+		bool busy;
+	};
+
+	cRenderWorkerPool();
+	~cRenderWorkerPool();
+
+	// reserves given number of idle threads. New threads are created if needed and no more idle
+	// threads than numberOfThreads are kept. With createThreads disabled only the existing idle
+	// threads are returned, so the list can be shorter or empty
+	QList<sPoolSlot *> Acquire(int numberOfThreads, bool createThreads = true);
+	void Release(const QList<sPoolSlot *> &poolSlots);
+	int GetNumberOfThreads() const { return allSlots.size(); }
+
+private:
+	static void DeleteSlot(sPoolSlot *poolSlot);
+
+	QList<sPoolSlot *> allSlots;
+	QMutex mutex;
+};
+
+extern cRenderWorkerPool *gRenderWorkerPool;
+
+#endif /* MANDELBULBER2_SRC_RENDER_WORKER_POOL_HPP_ */
@@ -45,7 +45,10 @@ cRenderingConfiguration::cRenderingConfiguration()
 	enableNetRender = false;
 	enableMultiThread = true;
 	enableIgnoreErrors = false;
+	enableTileScheduler = false;
+	enablePacketRayMarching = false;
 	refreshRate = 1000;
+	tileSize = 32;
 	maxRenderTime = 1e50;
 }
 
@@ -47,6 +47,13 @@ public:
 	void DisableMultiThread() { enableMultiThread = false; }
 	void EnableIgnoreErrors() { enableIgnoreErrors = true; }
 	void SetMaxRenderTime(double _maxRenderTime) { maxRenderTime = _maxRenderTime; }
+	void EnableTileScheduler(int _tileSize)
+	{
+		enableTileScheduler = true;
+		tileSize = _tileSize;
+	}
+	void DisableTileScheduler() { enableTileScheduler = false; }
+	void EnablePacketRayMarching() { enablePacketRayMarching = true; }
 
 	bool UseNetRender() const;
 	bool UseImageRefresh() const;
@@ -54,9 +61,12 @@ public:
 	bool UseRefreshRenderedList() const;
 	bool UseRenderTimeEffects() const;
 	bool UseIgnoreErrors() const;
+	bool UseTileScheduler() const { return enableTileScheduler; }
+	bool UsePacketRayMarching() const { return enablePacketRayMarching; }
 	int GetNumberOfThreads() const;
 	double GetMaxRenderTime() const { return maxRenderTime; }
 	int GetRefreshRate() const;
+	int GetTileSize() const { return tileSize; }
 
 private:
 	bool enableImageRefresh;
@@ -64,8 +74,11 @@ private:
 	bool enableNetRender;
 	bool enableMultiThread;
 	bool enableIgnoreErrors;
+	bool enableTileScheduler;
+	bool enablePacketRayMarching;
 	double maxRenderTime;
 	int refreshRate;
+	int tileSize;
 };
 
 #endif /* MANDELBULBER2_SRC_RENDERING_CONFIGURATION_HPP_ */
@@ -36,7 +36,10 @@
  * while the image renders.
  */
 
+#include <algorithm>
+
 #include <QDebug>
+#include <QPoint>
 
 #include "scheduler.hpp"
 #include "system_data.hpp"
@@ -55,6 +58,15 @@ cScheduler::cScheduler(cRegion<int> screenRegion, int progressive)
 	progressiveStep = progressive;
 	progressivePass = 1;
 	progressiveEnabled = progressive > 1;
+	additionalPass = false;
+	region = screenRegion;
+	tileMode = false;
+	fullWidthTiles = false;
+	tileSize = 0;
+	numberOfTileQueues = 0;
+	tileQueues = nullptr;
+	tilesDone = 0;
+	tilesToDo = 0;
 	Reset();
 }
 
@@ -63,6 +75,7 @@ cScheduler::~cScheduler()
 	delete[] lineDone;
 	delete[] linePendingThreadId;
 	delete[] lastLinesDone;
+	if (tileQueues) delete[] tileQueues;
 }
 
 void cScheduler::Reset() const
@@ -74,6 +87,11 @@ void cScheduler::Reset() const
 
 bool cScheduler::ThereIsStillSomethingToDo(int threadId) const
 {
+	if (tileMode)
+	{
+		return tilesDone < tilesToDo && !stopRequest && !systemData.globalStopRequest;
+	}
+
 	bool result = false;
 	for (int i = startLine; i < endLine; i++)
 	{
@@ -93,6 +111,11 @@ bool cScheduler::ThereIsStillSomethingToDo(int threadId) const
 
 bool cScheduler::AllLinesDone() const
 {
+	if (tileMode)
+	{
+		return tilesDone >= tilesToDo || stopRequest;
+	}
+
 	bool result = true;
 	for (int i = startLine; i < endLine; i++)
 	{
@@ -239,6 +262,7 @@ void cScheduler::InitFirstLine(int threadId, int firstLine) const
 QList<int> cScheduler::GetLastRenderedLines() const
 {
 	QList<int> list;
+	if (tileMode) mutex.lock();
 	for (int i = startLine; i < endLine; i++)
 	{
 		if (lastLinesDone[i])
@@ -247,15 +271,23 @@ QList<int> cScheduler::GetLastRenderedLines() const
 			lastLinesDone[i] = false;
 		}
 	}
+	if (tileMode) mutex.unlock();
 	return list;
 }
 
 double cScheduler::PercentDone() const
 {
-	int count = 0;
-	for (int i = startLine; i < endLine; i++)
+	double count = 0;
+	if (tileMode)
 	{
-		if (lineDone[i]) count++;
+		if (tilesToDo > 0) count = double(tilesDone) / tilesToDo * numberOfLines;
+	}
+	else
+	{
+		for (int i = startLine; i < endLine; i++)
+		{
+			if (lineDone[i]) count++;
+		}
 	}
 
 	double progressiveDone, percent_done;
@@ -266,12 +298,11 @@ double cScheduler::PercentDone() const
 
 	if (progressiveEnabled)
 	{
-		percent_done =
-			double(count) / numberOfLines * 0.75 / (progressiveStep * progressiveStep) + progressiveDone;
+		percent_done = count / numberOfLines * 0.75 / (progressiveStep * progressiveStep) + progressiveDone;
 	}
 	else
 	{
-		percent_done = double(count) / numberOfLines;
+		percent_done = count / numberOfLines;
 	}
 
 	return percent_done;
@@ -290,18 +321,64 @@ bool cScheduler::ProgressiveNextStep()
 	{
 		memset(linePendingThreadId, 0, sizeof(int) * endLine);
 		memset(lineDone, 0, sizeof(bool) * endLine);
+		if (tileMode) PrepareTiles();
 		return true;
 	}
 }
 
+// one more pass over all pixels in full resolution, after all progressive passes were finished
+// (used by adaptive anti-aliasing)
+void cScheduler::StartAdditionalPass()
+{
+	progressiveStep = 1;
+	progressivePass++;
+	additionalPass = true;
+	memset(linePendingThreadId, 0, sizeof(int) * endLine);
+	memset(lineDone, 0, sizeof(bool) * endLine);
+	if (tileMode) PrepareTiles();
+}
+
+// additional pass in tile mode only over selected tiles. Tiles are taken in the given order, so
+// the most important ones are rendered first (used by Monte Carlo tile convergence)
+void cScheduler::StartAdditionalPass(const QVector<int> &tileSequence)
+{
+	StartAdditionalPass();
+	if (!tileMode) return;
+
+	tileRowsToDo.fill(0);
+	for (int tile : tileSequence)
+		tileRowsToDo[tileRows.at(tile)]++;
+
+	// lines without any tile to render are already done
+	for (int tile = 0; tile < tiles.size(); tile++)
+	{
+		if (tileRowsToDo.at(tileRows.at(tile)) == 0)
+		{
+			const cRegion<int> &tileRegion = tiles.at(tile);
+			for (int line = qMax(tileRegion.y1, startLine); line < qMin(tileRegion.y2, endLine); line++)
+				lineDone[line] = true;
+		}
+	}
+
+	// tiles are dealt to the queues one by one, so each thread starts with the most important ones
+	for (int i = 0; i < numberOfTileQueues; i++)
+		tileQueues[i].tiles.clear();
+	for (int i = 0; i < tileSequence.size(); i++)
+		tileQueues[i % numberOfTileQueues].tiles.push_back(tileSequence.at(i));
+
+	tilesToDo = tileSequence.size();
+}
+
 void cScheduler::MarkReceivedLines(const QList<int> &lineNumbers) const
 {
+	mutex.lock();
 	for (int line : lineNumbers)
 	{
 		lineDone[line] = true;
 		lastLinesDone[line] = true;
 		linePendingThreadId[line] = LINE_DONE_BY_SERVER;
 	}
+	mutex.unlock();
 }
 
 QList<int> cScheduler::CreateDoneList() const
@@ -338,3 +415,236 @@ bool cScheduler::IsLineDoneByServer(int line) const
 	}
 	return false;
 }
+
+void cScheduler::EnableTiles(
+	int _tileSize, int numberOfThreads, bool _fullWidthTiles, const QVector<int> &threadStartLines)
+{
+	tileMode = true;
+	tileSize = qMax(_tileSize, 1);
+	fullWidthTiles = _fullWidthTiles;
+	startLines = threadStartLines;
+	numberOfTileQueues = qMax(numberOfThreads, 1);
+	if (tileQueues) delete[] tileQueues;
+	tileQueues = new sTileQueue[numberOfTileQueues];
+	PrepareTiles();
+}
+
+void cScheduler::PrepareTiles()
+{
+	// tiles have to be aligned to the actual progressive step
+	int tilePixelSize = (tileSize + progressiveStep - 1) / progressiveStep * progressiveStep;
+	int originX = region.x1 / progressiveStep * progressiveStep;
+	int originY = region.y1 / progressiveStep * progressiveStep;
+	int tileWidth = fullWidthTiles ? qMax(region.x2 - originX, 1) : tilePixelSize;
+	int tileGridWidth = (region.x2 - originX + tileWidth - 1) / tileWidth;
+	int tileGridHeight = (region.y2 - originY + tilePixelSize - 1) / tilePixelSize;
+
+	// sequence of tiles. Rows for NetRender (only complete lines can be sent), Hilbert curve
+	// otherwise to keep neighbouring tiles in the same queue
+	QVector<QPoint> sequence;
+	if (fullWidthTiles)
+	{
+		for (int y = 0; y < tileGridHeight; y++)
+			for (int x = 0; x < tileGridWidth; x++)
+				sequence.append(QPoint(x, y));
+	}
+	else
+	{
+		int order = 1;
+		while (order < tileGridWidth || order < tileGridHeight)
+			order *= 2;
+
+		for (int d = 0; d < order * order; d++)
+		{
+			int x, y;
+			HilbertCurveToXY(order, d, &x, &y);
+			if (x < tileGridWidth && y < tileGridHeight) sequence.append(QPoint(x, y));
+		}
+	}
+
+	tiles.clear();
+	tiles.reserve(sequence.size());
+	tileRows.clear();
+	tileRows.reserve(sequence.size());
+	tileRowsToDo.fill(0, tileGridHeight);
+	for (const QPoint &point : sequence)
+	{
+		int x1 = originX + point.x() * tileWidth;
+		int y1 = originY + point.y() * tilePixelSize;
+		int x2 = qMin(x1 + tileWidth, region.x2);
+		int y2 = qMin(y1 + tilePixelSize, region.y2);
+		tiles.append(cRegion<int>(x1, y1, x2, y2));
+		tileRows.append(point.y());
+		tileRowsToDo[point.y()]++;
+	}
+	tilesDone = 0;
+	tilesToDo = tiles.size();
+
+	// distribution of continuous ranges of tiles between threads
+	int numberOfTiles = tiles.size();
+	QVector<QPair<int, int>> firstTiles; // first tile, queue index
+	for (int i = 0; i < numberOfTileQueues; i++)
+	{
+		int firstTile;
+		if (fullWidthTiles && i < startLines.size())
+			firstTile = qBound(0, (startLines.at(i) - originY) / tilePixelSize, numberOfTiles - 1);
+		else
+			firstTile = numberOfTiles * i / numberOfTileQueues;
+		firstTiles.append(qMakePair(firstTile, i));
+	}
+	std::sort(firstTiles.begin(), firstTiles.end());
+
+	for (int i = 0; i < numberOfTileQueues; i++)
+	{
+		sTileQueue &queue = tileQueues[firstTiles.at(i).second];
+		int first = firstTiles.at(i).first;
+		int last = (i + 1 < numberOfTileQueues) ? firstTiles.at(i + 1).first
+																						: firstTiles.at(0).first + numberOfTiles;
+		queue.mutex.lock();
+		queue.tiles.clear();
+		for (int tile = first; tile < last; tile++)
+		{
+			queue.tiles.push_back(tile % numberOfTiles);
+		}
+		queue.mutex.unlock();
+	}
+}
+
+int cScheduler::NextTile(int threadId, int lastTile)
+{
+	if (lastTile >= 0) MarkTileDone(lastTile);
+
+	if (stopRequest || systemData.globalStopRequest) return -1;
+
+	int queueIndex = (threadId - 1) % numberOfTileQueues;
+	sTileQueue &queue = tileQueues[queueIndex];
+
+	while (true)
+	{
+		int nextTile = -1;
+		queue.mutex.lock();
+		if (!queue.tiles.empty())
+		{
+			nextTile = queue.tiles.front();
+			queue.tiles.pop_front();
+		}
+		queue.mutex.unlock();
+
+		if (nextTile < 0) nextTile = StealTiles(queueIndex);
+
+		// tiles with all lines received from NetRender clients are not rendered again
+		if (nextTile >= 0 && IsTileDoneByServer(nextTile))
+		{
+			MarkTileDone(nextTile);
+			continue;
+		}
+
+		return nextTile;
+	}
+}
+
+bool cScheduler::IsTileDoneByServer(int tileIndex) const
+{
+	// the same lines are checked as rendered by cRenderWorker::RenderTiles()
+	const cRegion<int> &tile = tiles.at(tileIndex);
+	bool anyLine = false;
+	bool allLines = true;
+	mutex.lock();
+	for (int line = tile.y1; line < tile.y2; line += progressiveStep)
+	{
+		if (line < startLine || line >= endLine) continue;
+		if (linePendingThreadId[line] != LINE_DONE_BY_SERVER)
+		{
+			allLines = false;
+			break;
+		}
+		anyLine = true;
+	}
+	mutex.unlock();
+	return anyLine && allLines;
+}
+
+int cScheduler::StealTiles(int queueIndex)
+{
+	// neighbouring queues are checked first, because they contain the closest tiles
+	for (int i = 1; i < numberOfTileQueues; i++)
+	{
+		sTileQueue &victim = tileQueues[(queueIndex + i) % numberOfTileQueues];
+		std::deque<int> stolenTiles;
+
+		victim.mutex.lock();
+		int size = int(victim.tiles.size());
+		if (size > 0)
+		{
+			// steal half of tiles from the end of queue
+			int numberToSteal = (size + 1) / 2;
+			stolenTiles.assign(victim.tiles.end() - numberToSteal, victim.tiles.end());
+			victim.tiles.erase(victim.tiles.end() - numberToSteal, victim.tiles.end());
+		}
+		victim.mutex.unlock();
+
+		if (!stolenTiles.empty())
+		{
+			int nextTile = stolenTiles.front();
+			stolenTiles.pop_front();
+
+			sTileQueue &queue = tileQueues[queueIndex];
+			queue.mutex.lock();
+			queue.tiles.insert(queue.tiles.end(), stolenTiles.begin(), stolenTiles.end());
+			queue.mutex.unlock();
+			return nextTile;
+		}
+	}
+	return -1;
+}
+
+void cScheduler::MarkTileDone(int tileIndex)
+{
+	const cRegion<int> &tile = tiles.at(tileIndex);
+	int firstLine = qMax(tile.y1, startLine);
+	int lastLine = qMin(tile.y2, endLine);
+
+	mutex.lock();
+	for (int line = firstLine; line < lastLine; line++)
+	{
+		lastLinesDone[line] = true;
+	}
+
+	// lines are done when all tiles in the row are done
+	tileRowsToDo[tileRows.at(tileIndex)]--;
+	if (tileRowsToDo.at(tileRows.at(tileIndex)) == 0)
+	{
+		for (int line = firstLine; line < lastLine; line++)
+		{
+			lineDone[line] = true;
+		}
+	}
+	mutex.unlock();
+
+	tilesDone++;
+}
+
+// conversion of distance along Hilbert curve to grid coordinates
+void cScheduler::HilbertCurveToXY(int order, int distance, int *x, int *y)
+{
+	int t = distance;
+	*x = 0;
+	*y = 0;
+	for (int s = 1; s < order; s *= 2)
+	{
+		int rx = 1 & (t / 2);
+		int ry = 1 & (t ^ rx);
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				*x = s - 1 - *x;
+				*y = s - 1 - *y;
+			}
+			std::swap(*x, *y);
+		}
+		*x += s * rx;
+		*y += s * ry;
+		t /= 4;
+	}
+}
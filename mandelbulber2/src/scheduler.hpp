@@ -34,6 +34,11 @@
  * The image to render is divided into [height] horizontal lines of size [width] x 1.
  * Each line will be managed by the scheduler and given to the asking threads,
  * while the image renders.
+ *
+ * In tile mode the image is divided into square tiles ordered along a Hilbert curve.
+ * Each thread gets own queue with continuous range of tiles and when the queue is empty
+ * the thread steals half of the tiles from other thread. Lines are still tracked for
+ * image refreshing and for NetRender.
  */
 
 #ifndef MANDELBULBER2_SRC_SCHEDULER_HPP_
@@ -42,6 +47,7 @@
 #include <qvector.h>
 
 #include <atomic>
+#include <deque>
 
 #include <QMutex>
 
@@ -66,12 +72,37 @@ public:
 	int GetProgressiveStep() const { return progressiveStep; }
 	int GetProgressivePass() const { return progressivePass; }
 	bool ProgressiveNextStep();
+	void StartAdditionalPass();
+	void StartAdditionalPass(const QVector<int> &tileSequence);
+	bool IsAdditionalPass() const { return additionalPass; }
+	// pixels rendered already in previous progressive pass have to be skipped
+	bool SkipPreviousPassPixels() const { return progressivePass > 1 && !additionalPass; }
 	QList<int> CreateDoneList() const;
 	bool IsLineDoneByServer(int line) const;
 
+	// tile mode
+	void EnableTiles(int _tileSize, int numberOfThreads, bool _fullWidthTiles,
+		const QVector<int> &threadStartLines);
+	bool IsTileMode() const { return tileMode; }
+	int NextTile(int threadId, int lastTile);
+	cRegion<int> GetTile(int tileIndex) const { return tiles.at(tileIndex); }
+	int GetNumberOfTiles() const { return tiles.size(); }
+	bool IsStopped() const { return stopRequest; }
+
 private:
+	struct sTileQueue
+	{
+		std::deque<int> tiles;
+		QMutex mutex;
+	};
+
 	void Reset() const;
 	int FindBiggestGap() const;
+	void PrepareTiles();
+	void MarkTileDone(int tileIndex);
+	bool IsTileDoneByServer(int tileIndex) const;
+	int StealTiles(int threadIndex);
+	static void HilbertCurveToXY(int order, int distance, int *x, int *y);
 
 	int *linePendingThreadId;
 	bool *lineDone;
@@ -83,7 +114,22 @@ private:
 	int progressiveStep;
 	int progressivePass;
 	bool progressiveEnabled;
-	QMutex mutex;
+	bool additionalPass;
+	mutable QMutex mutex;
+
+	// tile mode data
+	cRegion<int> region;
+	bool tileMode;
+	bool fullWidthTiles;
+	int tileSize;
+	int numberOfTileQueues;
+	QVector<cRegion<int>> tiles;
+	QVector<int> tileRows;		 // row of tiles where the tile belongs to
+	QVector<int> tileRowsToDo; // number of unfinished tiles in each row of tiles
+	QVector<int> startLines;
+	sTileQueue *tileQueues;
+	std::atomic<int> tilesDone;
+	int tilesToDo; // number of tiles to render in actual pass
 };
 
 #endif /* MANDELBULBER2_SRC_SCHEDULER_HPP_ */
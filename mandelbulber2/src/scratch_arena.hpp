@@ -0,0 +1,162 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2019 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
+ *
+ * cScratchArena - stack allocator for temporary buffers of render threads
+ *
+ * Every render worker has its own arena. Shaders allocate per-sample buffers (e.g. ray-marching
+ * steps of global illumination rays) from it and release them in reverse order, usually with
+ * cScratchArena::cScope. Memory blocks are kept for the next samples and images, so after the
+ * first sample there are no heap allocations in the per-sample path. Returned memory is not
+ * initialized and no constructors or destructors are called.
+ */
+
+#ifndef MANDELBULBER2_SRC_SCRATCH_ARENA_HPP_
+#define MANDELBULBER2_SRC_SCRATCH_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+class cScratchArena
+{
+public:
+	// position in the arena. Release() frees everything allocated after the mark was taken
+	struct sMark
+	{
+		size_t block;
+		size_t offset;
+		size_t usedBefore;
+	};
+
+	// releases all allocations made during lifetime of the scope
+	class cScope
+	{
+	public:
+		explicit cScope(cScratchArena *_arena) : arena(_arena), mark(_arena->Mark()) {}
+		~cScope() { arena->Release(mark); }
+		cScope(const cScope &) = delete;
+		cScope &operator=(const cScope &) = delete;
+
+	private:
+		cScratchArena *arena;
+		sMark mark;
+	};
+
+	cScratchArena() = default;
+	~cScratchArena()
+	{
+		for (sBlock &block : blocks)
+			free(block.memory);
+	}
+	cScratchArena(const cScratchArena &) = delete;
+	cScratchArena &operator=(const cScratchArena &) = delete;
+
+	template <typename T>
+	T *Allocate(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "destructors are not called");
+		return static_cast<T *>(AllocateBytes(count * sizeof(T)));
+	}
+
+	sMark Mark() const { return sMark{currentBlock, offset, usedBefore}; }
+
+	void Release(const sMark &mark)
+	{
+		currentBlock = mark.block;
+		offset = mark.offset;
+		usedBefore = mark.usedBefore;
+	}
+
+	// the biggest number of bytes used at the same time since last ResetHighWaterMark()
+	size_t GetHighWaterMark() const { return highWaterMark; }
+	void ResetHighWaterMark() { highWaterMark = usedBefore + offset; }
+
+private:
+	struct sBlock
+	{
+		char *memory;
+		size_t size;
+	};
+
+	void *AllocateBytes(size_t size)
+	{
+		const size_t alignment = alignof(std::max_align_t);
+		size = (size + alignment - 1) & ~(alignment - 1);
+
+		if (blocks.empty() || offset + size > blocks[currentBlock].size)
+		{
+			// go to the next block. Blocks after the current one are not used, so the next one can be
+			// replaced by a bigger one if it is too small
+			if (!blocks.empty())
+			{
+				usedBefore += blocks[currentBlock].size;
+				currentBlock++;
+			}
+			offset = 0;
+
+			size_t blockSize = minBlockSize;
+			if (size > blockSize) blockSize = size;
+			if (currentBlock == blocks.size())
+			{
+				blocks.push_back(sBlock{AllocateBlock(blockSize), blockSize});
+			}
+			else if (blocks[currentBlock].size < size)
+			{
+				free(blocks[currentBlock].memory);
+				blocks[currentBlock] = sBlock{AllocateBlock(blockSize), blockSize};
+			}
+		}
+
+		void *memory = blocks[currentBlock].memory + offset;
+		offset += size;
+		if (usedBefore + offset > highWaterMark) highWaterMark = usedBefore + offset;
+		return memory;
+	}
+
+	static char *AllocateBlock(size_t size)
+	{
+		char *memory = static_cast<char *>(malloc(size));
+		if (!memory) throw std::bad_alloc();
+		return memory;
+	}
+
+	static const size_t minBlockSize = 1024 * 1024;
+
+	std::vector<sBlock> blocks;
+	size_t currentBlock{0};
+	size_t offset{0};
+	size_t usedBefore{0};
+	size_t highWaterMark{0};
+};
+
+#endif /* MANDELBULBER2_SRC_SCRATCH_ARENA_HPP_ */
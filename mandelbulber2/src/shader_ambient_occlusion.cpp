@@ -51,7 +51,7 @@ sRGBAfloat cRenderWorker::AmbientOcclusion(const sShaderInputData &input) const
 
 	if (params->DOFMonteCarlo)
 	{
-		int randomSample = Random(AOVectorsCount - 1);
+		int randomSample = pixelRandom.Random(AOVectorsCount - 1);
 		start = randomSample;
 		end = randomSample;
 	}
@@ -65,14 +65,22 @@ sRGBAfloat cRenderWorker::AmbientOcclusion(const sShaderInputData &input) const
 		double opacity;
 		double shadowTemp = 1.0;
 
-		for (double r = start_dist; r < end_dist; r += dist * 2.0)
+		// AO ray ends where it leaves the limits box or the bounding sphere
+		double maxDist = end_dist;
+		if (rayClipping)
+		{
+			double minDist = 0.0;
+			if (!ClipRayToBounds(input.point, v.v, &minDist, &maxDist)) maxDist = start_dist;
+		}
+
+		for (double r = start_dist; r < maxDist; r += dist * 2.0)
 		{
 			CVector3 point2 = input.point + v.v * r;
 
 			sDistanceOut distanceOut;
 			sDistanceIn distanceIn(point2, input.distThresh, false);
 			dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
-			data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
 
 			if (params->iterFogEnabled)
 			{
@@ -31,7 +31,9 @@
  *
  * cRenderWorker::AuxLightsShader method - calculates shading for auxiliary light sources
  */
+#include "common_math.h"
 #include "fractparams.hpp"
+#include "lights.hpp"
 #include "render_data.hpp"
 #include "render_worker.hpp"
 
@@ -43,22 +45,56 @@ sRGBAfloat cRenderWorker::AuxLightsShader(const sShaderInputData &input, sRGBAfl
 	if (numberOfLights < 4) numberOfLights = 4;
 	sRGBAfloat shadeAuxSum;
 	sRGBAfloat specularAuxSum;
-	for (int i = 0; i < numberOfLights; i++)
+
+	auto addLight = [&](const sLight &light, float weight) {
+		sRGBAfloat specularAuxOutTemp;
+		sRGBAfloat shadeAux =
+			LightShading(input, surfaceColor, &light, numberOfLights, gradients, &specularAuxOutTemp);
+		shadeAuxSum.R += shadeAux.R * weight;
+		shadeAuxSum.G += shadeAux.G * weight;
+		shadeAuxSum.B += shadeAux.B * weight;
+		specularAuxSum.R += specularAuxOutTemp.R * weight;
+		specularAuxSum.G += specularAuxOutTemp.G * weight;
+		specularAuxSum.B += specularAuxOutTemp.B * weight;
+	};
+
+	if (params->DOFMonteCarlo && params->auxLightMonteCarloSampling)
 	{
-		const sLight *light = data->lights.GetLight(i);
-		if (i < params->auxLightNumber || light->enabled)
+		// every sample selects one light with probability proportional to its unshadowed intensity
+		// at the point (weighted reservoir sampling, so the lights are visited only once)
+		const int maxSamples = 16;
+		const int samples = qBound(1, params->auxLightMonteCarloSamples, maxSamples);
+		const sLight *selectedLights[maxSamples] = {};
+		float selectedWeights[maxSamples] = {};
+		float totalWeight = 0.0f;
+
+		data->lights.ForEachLight(input.point, [&](const sLight &light) {
+			CVector3 d = light.position - input.point;
+			float weight = light.intensity * dMax(light.colour.R, light.colour.G, light.colour.B)
+										 / qMax(float(d.Dot(d)), 1e-20f);
+			if (weight <= 0.0f) return;
+			totalWeight += weight;
+			for (int i = 0; i < samples; i++)
+			{
+				if (pixelRandom.Random(65535) / 65536.0f * totalWeight < weight)
+				{
+					selectedLights[i] = &light;
+					selectedWeights[i] = weight;
+				}
+			}
+		});
+
+		for (int i = 0; i < samples; i++)
 		{
-			sRGBAfloat specularAuxOutTemp;
-			sRGBAfloat shadeAux =
-				LightShading(input, surfaceColor, light, numberOfLights, gradients, &specularAuxOutTemp);
-			shadeAuxSum.R += shadeAux.R;
-			shadeAuxSum.G += shadeAux.G;
-			shadeAuxSum.B += shadeAux.B;
-			specularAuxSum.R += specularAuxOutTemp.R;
-			specularAuxSum.G += specularAuxOutTemp.G;
-			specularAuxSum.B += specularAuxOutTemp.B;
+			if (selectedLights[i])
+				addLight(*selectedLights[i], totalWeight / (selectedWeights[i] * samples));
 		}
 	}
+	else
+	{
+		data->lights.ForEachLight(input.point, [&](const sLight &light) { addLight(light, 1.0f); });
+	}
+
 	*specularOut = specularAuxSum;
 	return shadeAuxSum;
 }
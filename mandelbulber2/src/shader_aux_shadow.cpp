@@ -74,19 +74,27 @@ double cRenderWorker::AuxShadow(
 	if (params->DOFMonteCarlo && params->monteCarloSoftShadows)
 	{
 		CVector3 randomVector;
-		randomVector.x = Random(10000) / 5000.0 - 1.0;
-		randomVector.y = Random(10000) / 5000.0 - 1.0;
-		randomVector.z = Random(10000) / 5000.0 - 1.0;
-		double randomSphereRadius = pow(Random(10000) / 10000.0, 1.0 / 3.0);
+		randomVector.x = pixelRandom.Random(10000) / 5000.0 - 1.0;
+		randomVector.y = pixelRandom.Random(10000) / 5000.0 - 1.0;
+		randomVector.z = pixelRandom.Random(10000) / 5000.0 - 1.0;
+		double randomSphereRadius = pow(pixelRandom.Random(10000) / 10000.0, 1.0 / 3.0);
 		CVector3 randomSphere = randomVector * (softRange * randomSphereRadius / randomVector.Length());
 		lightVector += randomSphere;
 	}
 
+	// shadow ray ends where it leaves the limits box or the bounding sphere
+	double end = distance;
+	if (rayClipping)
+	{
+		double minScan = 0.0;
+		if (!ClipRayToBounds(input.point, lightVector, &minScan, &end)) end = input.delta;
+	}
+
 	double lastDistanceToClouds = 1e6f;
 	int count = 0;
 	double step = 0.0f;
 
-	for (double i = input.delta; i < distance; i += step)
+	for (double i = input.delta; i < end; i += step)
 	{
 		CVector3 point2 = input.point + lightVector * i;
 
@@ -101,7 +109,7 @@ double cRenderWorker::AuxShadow(
 		sDistanceOut distanceOut;
 		sDistanceIn distanceIn(point2, input.distThresh, false);
 		dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+		statistics.totalNumberOfIterations += distanceOut.totalIters;
 
 		bool limitsReached = false;
 		if (params->limitsEnabled)
@@ -113,6 +121,11 @@ double cRenderWorker::AuxShadow(
 				limitsReached = true;
 			}
 		}
+		if (params->boundingSphereEnabled)
+		{
+			if ((point2 - params->boundingSphereCenter).Length() > params->boundingSphereRadius)
+				limitsReached = true;
+		}
 
 		if (bSoft && !limitsReached)
 		{
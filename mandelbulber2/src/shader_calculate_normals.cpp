@@ -37,6 +37,9 @@
 #include "render_data.hpp"
 #include "render_worker.hpp"
 
+// strides of lattices used in adaptive non-DE shading: 8, 27, 216 and 1331 points
+static const int slowShadingStrides[cRenderWorker::slowShadingAdaptiveLevels] = {10, 5, 2, 1};
+
 CVector3 cRenderWorker::CalculateNormals(const sShaderInputData &input) const
 {
 	CVector3 normal(0.0, 0.0, 0.0);
@@ -46,36 +49,103 @@ CVector3 cRenderWorker::CalculateNormals(const sShaderInputData &input) const
 		double delta = input.distThresh * params->smoothness;
 		if (params->interiorMode) delta = input.distThresh * 0.2 * params->smoothness;
 
-		double sx1, sx2, sy1, sy2, sz1, sz2;
 		sDistanceOut distanceOut;
 
-		CVector3 deltaX(delta, 0.0, 0.0);
-		sDistanceIn distanceIn1(input.point + deltaX, input.distThresh, true);
-		sx1 = CalculateDistance(*params, *fractal, distanceIn1, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
-		sDistanceIn distanceIn2(input.point - deltaX, input.distThresh, true);
-		sx2 = CalculateDistance(*params, *fractal, distanceIn2, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
-
-		CVector3 deltaY(0.0, delta, 0.0);
-		sDistanceIn distanceIn3(input.point + deltaY, input.distThresh, true);
-		sy1 = CalculateDistance(*params, *fractal, distanceIn3, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
-		sDistanceIn distanceIn4(input.point - deltaY, input.distThresh, true);
-		sy2 = CalculateDistance(*params, *fractal, distanceIn4, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
-
-		CVector3 deltaZ(0.0, 0.0, delta);
-		sDistanceIn distanceIn5(input.point + deltaZ, input.distThresh, true);
-		sz1 = CalculateDistance(*params, *fractal, distanceIn5, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
-		sDistanceIn distanceIn6(input.point - deltaZ, input.distThresh, true);
-		sz2 = CalculateDistance(*params, *fractal, distanceIn6, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
-
-		normal.x = sx1 - sx2;
-		normal.y = sy1 - sy2;
-		normal.z = sz1 - sz2;
+		if (params->normalVectorMode == params::normalVectorTetrahedral)
+		{
+			// gradient from 4 samples placed in vertices of tetrahedron
+			const CVector3 vertices[4] = {CVector3(1.0, -1.0, -1.0), CVector3(-1.0, -1.0, 1.0),
+				CVector3(-1.0, 1.0, -1.0), CVector3(1.0, 1.0, 1.0)};
+
+			for (int i = 0; i < 4; i++)
+			{
+				sDistanceIn distanceIn(input.point + vertices[i] * delta, input.distThresh, true);
+				double dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
+				statistics.totalNumberOfIterations += distanceOut.totalIters;
+				normal += vertices[i] * dist;
+			}
+		}
+		else
+		{
+			double sx1, sx2, sy1, sy2, sz1, sz2;
+
+			CVector3 deltaX(delta, 0.0, 0.0);
+			sDistanceIn distanceIn1(input.point + deltaX, input.distThresh, true);
+			sx1 = CalculateDistance(*params, *fractal, distanceIn1, &distanceOut, data);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
+			sDistanceIn distanceIn2(input.point - deltaX, input.distThresh, true);
+			sx2 = CalculateDistance(*params, *fractal, distanceIn2, &distanceOut, data);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
+
+			CVector3 deltaY(0.0, delta, 0.0);
+			sDistanceIn distanceIn3(input.point + deltaY, input.distThresh, true);
+			sy1 = CalculateDistance(*params, *fractal, distanceIn3, &distanceOut, data);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
+			sDistanceIn distanceIn4(input.point - deltaY, input.distThresh, true);
+			sy2 = CalculateDistance(*params, *fractal, distanceIn4, &distanceOut, data);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
+
+			CVector3 deltaZ(0.0, 0.0, delta);
+			sDistanceIn distanceIn5(input.point + deltaZ, input.distThresh, true);
+			sz1 = CalculateDistance(*params, *fractal, distanceIn5, &distanceOut, data);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
+			sDistanceIn distanceIn6(input.point - deltaZ, input.distThresh, true);
+			sz2 = CalculateDistance(*params, *fractal, distanceIn6, &distanceOut, data);
+			statistics.totalNumberOfIterations += distanceOut.totalIters;
+
+			normal.x = sx1 - sx2;
+			normal.y = sy1 - sy2;
+			normal.z = sz1 - sz2;
+		}
+	}
+
+	// calculating normal vector based on average value of binary central difference
+	// (adaptive: lattice is refined in steps and calculation is finished when normal vector
+	// doesn't change)
+	else if (params->slowShadingAdaptive)
+	{
+		double delta = input.delta * params->smoothness;
+		if (params->interiorMode) delta = input.distThresh * 0.2 * params->smoothness;
+
+		// lattice 11 x 11 x 11 is refined in 4 levels and only new points are calculated, so when
+		// normal vector doesn't converge, the cost is the same as for non-adaptive mode
+		const double maxAngleCos = 0.999;
+		CVector3 lastNormal;
+
+		for (int level = 0; level < slowShadingAdaptiveLevels; level++)
+		{
+			int stride = slowShadingStrides[level];
+			for (int ix = 0; ix <= 10; ix += stride)
+			{
+				for (int iy = 0; iy <= 10; iy += stride)
+				{
+					for (int iz = 0; iz <= 10; iz += stride)
+					{
+						if (!IsNewSlowShadingPoint(level, ix, iy, iz)) continue;
+
+						CVector3 point2(ix * 0.2 - 1.0, iy * 0.2 - 1.0, iz * 0.2 - 1.0);
+						CVector3 point3 = input.point + point2 * delta;
+
+						sFractalIn fractIn(point3, params->minN, params->N, &params->common, -1, false);
+						sFractalOut fractOut;
+						fractOut.colorIndex = 0;
+
+						Compute<fractal::calcModeNormal>(*fractal, fractIn, &fractOut);
+						double pseudoDistance = 1 + params->N - fractOut.iters;
+						statistics.totalNumberOfIterations += fractOut.iters;
+						normal += point2 * pseudoDistance;
+					}
+				}
+			}
+
+			double length = normal.Length();
+			if (length > 0.0)
+			{
+				CVector3 actualNormal = normal / length;
+				if (level > 0 && actualNormal.Dot(lastNormal) > maxAngleCos) break;
+				lastNormal = actualNormal;
+			}
+		}
 	}
 
 	// calculating normal vector based on average value of binary central difference
@@ -100,7 +170,7 @@ CVector3 cRenderWorker::CalculateNormals(const sShaderInputData &input) const
 
 					Compute<fractal::calcModeNormal>(*fractal, fractIn, &fractOut);
 					double pseudoDistance = 1 + params->N - fractOut.iters;
-					data->statistics.totalNumberOfIterations += fractOut.iters;
+					statistics.totalNumberOfIterations += fractOut.iters;
 					normal += point2 * pseudoDistance;
 				}
 			}
@@ -127,3 +197,16 @@ CVector3 cRenderWorker::CalculateNormals(const sShaderInputData &input) const
 
 	return normal;
 }
+
+bool cRenderWorker::IsNewSlowShadingPoint(int level, int ix, int iy, int iz)
+{
+	// lattice with stride 2 doesn't contain the one with stride 5, so all previous levels are checked
+	for (int i = 0; i <= level; i++)
+	{
+		int stride = slowShadingStrides[i];
+		bool inLattice = ix % stride == 0 && iy % stride == 0 && iz % stride == 0;
+		if (i == level) return inLattice;
+		if (inLattice) return false;
+	}
+	return false;
+}
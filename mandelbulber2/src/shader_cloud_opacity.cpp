@@ -7,6 +7,7 @@
 
 #include "render_worker.hpp"
 #include "perlin_noise_octaves.h"
+#include "noise_volume.hpp"
 #include "common_math.h"
 #include "fractparams.hpp"
 #include <algorithm>
@@ -46,8 +47,13 @@ double cRenderWorker::CloudOpacity(
 	double distToCloud = distToGeometry;
 	if (h > 0)
 	{
-		double opacity = perlinNoise->normalizedOctaveNoise3D_0_1(point2.x / params->cloudsPeriod,
-			point2.y / params->cloudsPeriod, point2.z / params->cloudsPeriod, params->cloudsIterations);
+		CVector3 noisePoint = point2 / params->cloudsPeriod;
+		double opacity;
+		if (noiseVolume)
+			opacity = noiseVolume->Noise(noisePoint.x, noisePoint.y, noisePoint.z);
+		else
+			opacity = perlinNoise->normalizedOctaveNoise3D_0_1(
+				noisePoint.x, noisePoint.y, noisePoint.z, params->cloudsIterations);
 
 		distToCloud = fabs(1.0 - opacity - params->cloudsDensity) * 0.2 * params->cloudsPeriod
 									* params->cloudsDEMultiplier;
@@ -45,7 +45,10 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 	sShaderInputData inputCopy = input;
 	sRGBAfloat objectColorTemp = objectColor;
 
-	sStep *stepBuff = new sStep[maxRaymarchingSteps + 2];
+	// step buffer is taken from the arena of the worker and released when leaving the function
+	cScratchArena::cScope scratchScope(&scratchArena);
+	sStep *stepBuff = scratchArena.Allocate<sStep>(maxRaymarchingSteps + 2);
+	statistics.scratchMemoryPeak = scratchArena.GetHighWaterMark();
 	inputCopy.stepBuff = stepBuff;
 	inputCopy.stepCount = 0;
 
@@ -57,9 +60,9 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 	for (int rayDepth = 0; rayDepth < params->reflectionsMax; rayDepth++)
 	{
 		CVector3 reflectedDirection = inputCopy.normal;
-		double randomX = (Random(20000) - 10000) / 10000.0;
-		double randomY = (Random(20000) - 10000) / 10000.0;
-		double randomZ = (Random(20000) - 10000) / 10000.0;
+		double randomX = (pixelRandom.Random(20000) - 10000) / 10000.0;
+		double randomY = (pixelRandom.Random(20000) - 10000) / 10000.0;
+		double randomZ = (pixelRandom.Random(20000) - 10000) / 10000.0;
 		CVector3 randomVector(randomX * 1.2, randomY * 1.2, randomZ * 1.2);
 		CVector3 randomizedDirection = reflectedDirection + randomVector;
 		randomizedDirection.Normalize();
@@ -97,11 +100,7 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 
 			if (dist < distThresh)
 			{
-				if (scan < distThresh * 2.0)
-				{
-					delete[] stepBuff;
-					return out;
-				}
+				if (scan < distThresh * 2.0) return out;
 				inputCopy.point = point;
 				CVector3 vn = CalculateNormals(inputCopy);
 				inputCopy.normal = vn;
@@ -121,8 +120,7 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 			sRGBAfloat specular;
 			sRGBFloat iridescence;
 
-			cObjectData objectData = data->objectData[inputCopy.objectId];
-			inputCopy.material = &data->materials[objectData.materialId];
+			inputCopy.material = data->GetObjectMaterial(inputCopy.objectId);
 
 			// letting colors from textures (before normal map shader)
 			if (inputCopy.material->colorTexture.IsLoaded())
@@ -184,6 +182,5 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 		if (finished || totalOpacity > 1.0) break;
 	}
 
-	delete[] stepBuff;
 	return out;
 }
@@ -72,19 +72,27 @@ sRGBAfloat cRenderWorker::MainShadow(const sShaderInputData &input) const
 	if (params->DOFMonteCarlo && params->monteCarloSoftShadows)
 	{
 		CVector3 randomVector;
-		randomVector.x = Random(10000) / 5000.0 - 1.0;
-		randomVector.y = Random(10000) / 5000.0 - 1.0;
-		randomVector.z = Random(10000) / 5000.0 - 1.0;
-		double randomSphereRadius = pow(Random(10000) / 10000.0, 1.0 / 3.0);
+		randomVector.x = pixelRandom.Random(10000) / 5000.0 - 1.0;
+		randomVector.y = pixelRandom.Random(10000) / 5000.0 - 1.0;
+		randomVector.z = pixelRandom.Random(10000) / 5000.0 - 1.0;
+		double randomSphereRadius = pow(pixelRandom.Random(10000) / 10000.0, 1.0 / 3.0);
 		CVector3 randomSphere = randomVector * (softRange * randomSphereRadius / randomVector.Length());
 		shadowVect += randomSphere;
 	}
 
+	// shadow ray ends where it leaves the limits box or the bounding sphere
+	double end = factor;
+	if (rayClipping)
+	{
+		double minScan = 0.0;
+		if (!ClipRayToBounds(input.point, shadowVect, &minScan, &end)) end = start;
+	}
+
 	int count = 0;
 	double step = 0.0f;
 	double lastDistanceToClouds = 1e6f;
 
-	for (double i = start; i < factor; i += step)
+	for (double i = start; i < end; i += step)
 	{
 		point2 = input.point + shadowVect * i;
 
@@ -99,7 +107,7 @@ sRGBAfloat cRenderWorker::MainShadow(const sShaderInputData &input) const
 		sDistanceOut distanceOut;
 		sDistanceIn distanceIn(point2, dist_thresh, false);
 		dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
-		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+		statistics.totalNumberOfIterations += distanceOut.totalIters;
 
 		bool limitsReached = false;
 		if (params->limitsEnabled)
@@ -111,6 +119,11 @@ sRGBAfloat cRenderWorker::MainShadow(const sShaderInputData &input) const
 				limitsReached = true;
 			}
 		}
+		if (params->boundingSphereEnabled)
+		{
+			if ((point2 - params->boundingSphereCenter).Length() > params->boundingSphereRadius)
+				limitsReached = true;
+		}
 
 		if (bSoft && !limitsReached)
 		{
@@ -41,7 +41,7 @@ using std::max;
 
 CVector3 cRenderWorker::NormalMapShader(const sShaderInputData &input) const
 {
-	cObjectData objectData = data->objectData[input.objectId];
+	const cObjectData &objectData = data->GetObject(input.objectId);
 	CVector3 texX, texY;
 	double texturePixelSize;
 	CVector2<float> texPoint =
@@ -41,7 +41,7 @@ using std::max;
 
 float cRenderWorker::RoughnessTexture(const sShaderInputData &input) const
 {
-	cObjectData objectData = data->objectData[input.objectId];
+	const cObjectData &objectData = data->GetObject(input.objectId);
 	CVector3 texX, texY;
 	float texturePixelSize;
 	CVector2<float> texPoint =
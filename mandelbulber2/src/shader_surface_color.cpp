@@ -41,7 +41,7 @@ sRGBAfloat cRenderWorker::SurfaceColour(
 {
 	sRGBAfloat out;
 
-	switch (data->objectData[input.objectId].objectType)
+	switch (data->GetObject(input.objectId).objectType)
 	{
 		case fractal::objFractal:
 		{
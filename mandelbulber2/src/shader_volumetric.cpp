@@ -122,7 +122,7 @@ sRGBAfloat cRenderWorker::VolumetricShader(
 			step = (min(distance, lastCloudDistance) - 0.5 * input2.distThresh) * params->DEFactor
 						 * params->volumetricLightDEFactor;
 
-			step *= (1.0 - Random(1000) / 10000.0);
+			step *= (1.0 - pixelRandom.Random(1000) / 10000.0);
 
 			if (params->advancedQuality)
 			{
@@ -42,15 +42,14 @@
 #include "color_structures.hpp"
 #include "common_math.h"
 #include "fractparams.hpp"
+#include "pixel_random.hpp"
 #include "render_data.hpp"
 
 cSSAOWorker::cSSAOWorker(
 	const sParamRender *_params, sThreadData *_threadData, const sRenderData *_data, cImage *_image)
 {
-	params = _params;
-	data = _data;
-	image = _image;
-	threadData = _threadData;
+	SetData(_params, _threadData, _data, _image);
+	working = false;
 }
 
 cSSAOWorker::~cSSAOWorker()
@@ -58,16 +57,30 @@ cSSAOWorker::~cSSAOWorker()
 	// nothing to destroy
 }
 
+void cSSAOWorker::SetData(
+	const sParamRender *_params, sThreadData *_threadData, const sRenderData *_data, cImage *_image)
+{
+	params = _params;
+	data = _data;
+	image = _image;
+	threadData = _threadData;
+}
+
 void cSSAOWorker::doWork()
 {
 	int quality = threadData->quality;
 	int startLineInit = threadData->startLine;
 	int startLine = threadData->region.y1;
 	int endLine = threadData->region.y2;
-	int width = threadData->region.width;
-	int height = threadData->region.height;
 	int startX = threadData->region.x1;
 	int endX = threadData->region.x2;
+
+	// projection is calculated for the whole frame (the image can be only a tile of it)
+	const cRegion<int> &frame = data->frameTile ? data->frameRegion : threadData->region;
+	int frameX = frame.x1;
+	int frameY = frame.y1;
+	int width = frame.width;
+	int height = frame.height;
 	sRGBFloat aoColor = threadData->color;
 
 	double *cosine = new double[quality];
@@ -123,8 +136,8 @@ void cSSAOWorker::doWork()
 				double x2, y2;
 				if (perspectiveType == params::perspFishEye || perspectiveType == params::perspFishEyeCut)
 				{
-					x2 = (double(x - startX) / width - 0.5) * aspectRatio;
-					y2 = (double(y - startLine) / height - 0.5);
+					x2 = (double(x - frameX) / width - 0.5) * aspectRatio;
+					y2 = (double(y - frameY) / height - 0.5);
 					double r = sqrt(x2 * x2 + y2 * y2);
 					if (r != 0.0)
 					{
@@ -134,15 +147,15 @@ void cSSAOWorker::doWork()
 				}
 				else if (perspectiveType == params::perspEquirectangular)
 				{
-					x2 = M_PI * (double(x - startX) / width - 0.5) * aspectRatio;
-					y2 = M_PI * (double(y - startLine) / height - 0.5);
+					x2 = M_PI * (double(x - frameX) / width - 0.5) * aspectRatio;
+					y2 = M_PI * (double(y - frameY) / height - 0.5);
 					x2 = sin(fov * x2) * cos(fov * y2) * z;
 					y2 = sin(fov * y2) * z;
 				}
 				else
 				{
-					x2 = (double(x - startX) / width - 0.5) * aspectRatio;
-					y2 = double(y - startLine) / height - 0.5;
+					x2 = (double(x - frameX) / width - 0.5) * aspectRatio;
+					y2 = double(y - frameY) / height - 0.5;
 					x2 = x2 * z * fov;
 					y2 = y2 * z * fov;
 				}
@@ -152,7 +165,11 @@ void cSSAOWorker::doWork()
 				int maxRandom = 62831 / quality;
 				double rRandom = 1.0;
 
-				if (params->SSAO_random_mode) rRandom = 0.5 + Random(65536) / 65536.0;
+				// random numbers depend only on pixel, so result is the same for any number of threads
+				cPixelRandom pixelRandom;
+				pixelRandom.Seed(
+					params->frameNo, x - data->frameRegion.x1, y - data->frameRegion.y1, 0);
+				if (params->SSAO_random_mode) rRandom = 0.5 + pixelRandom.Random(65536) / 65536.0;
 
 				for (int angleIndex = 0; angleIndex < quality; angleIndex++)
 				{
@@ -160,7 +177,7 @@ void cSSAOWorker::doWork()
 					double angle = angleIndex;
 					if (params->SSAO_random_mode)
 					{
-						angle = angleStep * angleIndex + Random(maxRandom) / 10000.0;
+						angle = angleStep * angleIndex + pixelRandom.Random(maxRandom) / 10000.0;
 						ca = cos(angle);
 						sa = sin(angle);
 					}
@@ -186,8 +203,8 @@ void cSSAOWorker::doWork()
 						if (perspectiveType == params::perspFishEye
 								|| perspectiveType == params::perspFishEyeCut)
 						{
-							xx2 = M_PI * ((xx - startX) / width - 0.5) * aspectRatio;
-							yy2 = M_PI * ((yy - startLine) / height - 0.5);
+							xx2 = M_PI * ((xx - frameX) / width - 0.5) * aspectRatio;
+							yy2 = M_PI * ((yy - frameY) / height - 0.5);
 							double r2 = sqrt(xx2 * xx2 + yy2 * yy2);
 							if (r != 0.0)
 							{
@@ -197,15 +214,15 @@ void cSSAOWorker::doWork()
 						}
 						else if (perspectiveType == params::perspEquirectangular)
 						{
-							xx2 = M_PI * ((xx - startX) / width - 0.5) * aspectRatio;
-							yy2 = M_PI * ((yy - startLine) / height - 0.5);
+							xx2 = M_PI * ((xx - frameX) / width - 0.5) * aspectRatio;
+							yy2 = M_PI * ((yy - frameY) / height - 0.5);
 							xx2 = sin(fov * xx2) * cos(fov * yy2) * z2;
 							yy2 = sin(fov * yy2) * z2;
 						}
 						else
 						{
-							xx2 = ((xx - startX) / width - 0.5) * aspectRatio;
-							yy2 = (yy - startLine) / height - 0.5;
+							xx2 = ((xx - frameX) / width - 0.5) * aspectRatio;
+							yy2 = (yy - frameY) / height - 0.5;
 							xx2 = xx2 * (z2 * fov);
 							yy2 = yy2 * (z2 * fov);
 						}
@@ -248,6 +265,17 @@ void cSSAOWorker::doWork()
 	delete[] cosine;
 
 	// emit signal to main thread when finished
+	workingMutex.lock();
+	working = false;
+	workingFinished.wakeAll();
+	workingMutex.unlock();
 	emit finished();
 	return;
 }
+
+bool cSSAOWorker::WaitForFinish(unsigned long timeout)
+{
+	QMutexLocker lock(&workingMutex);
+	if (working) workingFinished.wait(&workingMutex, timeout);
+	return !working;
+}
@@ -42,7 +42,11 @@
 #include <qobject.h>
 
 #include <QList>
+#include <QMutex>
 #include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
 
 #include "color_structures.hpp"
 #include "region.hpp"
@@ -73,6 +77,14 @@ public:
 		cImage *_image);
 	~cSSAOWorker() override;
 
+	// worker can be reused (see cRenderWorkerPool)
+	void SetData(const sParamRender *_params, sThreadData *_threadData, const sRenderData *_data,
+		cImage *_image);
+	void SetWorking() { working = true; }
+	bool IsWorking() const { return working; }
+	// returns true if the worker finished within timeout (in milliseconds)
+	bool WaitForFinish(unsigned long timeout);
+
 	QThread workerThread;
 
 	// data got from main thread
@@ -81,6 +93,11 @@ public:
 	sThreadData *threadData;
 	cImage *image;
 
+private:
+	std::atomic<bool> working;
+	QMutex workingMutex;
+	QWaitCondition workingFinished;
+
 public slots:
 	void doWork();
 
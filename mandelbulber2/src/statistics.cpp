@@ -43,6 +43,7 @@ cStatistics::cStatistics()
 	totalNumberOfDOFRepeats = 0;
 	totalNoise = 0;
 	time = 0.0;
+	scratchMemoryPeak = 0;
 }
 
 cStatistics::~cStatistics() = default;
@@ -54,7 +55,23 @@ void cStatistics::Reset()
 	numberOfRaymarchings = 0;
 	numberOfRenderedPixels = 0;
 	totalNumberOfDOFRepeats = 0;
+	totalNoise = 0.0;
 	time = 0.0;
+	scratchMemoryPeak = 0;
 	histogramIterations.Clear();
 	histogramStepCount.Clear();
 }
+
+// adds counters collected by another (per thread) instance. Time and DE type are not changed
+void cStatistics::Merge(const cStatistics &source)
+{
+	totalNumberOfIterations += source.totalNumberOfIterations;
+	missedDE += source.missedDE;
+	numberOfRaymarchings += source.numberOfRaymarchings;
+	numberOfRenderedPixels += source.numberOfRenderedPixels;
+	totalNumberOfDOFRepeats += source.totalNumberOfDOFRepeats;
+	totalNoise += source.totalNoise;
+	if (source.scratchMemoryPeak > scratchMemoryPeak) scratchMemoryPeak = source.scratchMemoryPeak;
+	histogramIterations.Merge(source.histogramIterations);
+	histogramStepCount.Merge(source.histogramStepCount);
+}
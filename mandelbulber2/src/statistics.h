@@ -52,6 +52,7 @@ public:
 	long long totalNumberOfDOFRepeats;
 	double totalNoise;
 	double time;
+	size_t scratchMemoryPeak; // the biggest scratch memory used by one thread [bytes]
 	QString usedDEType;
 
 	double GetTotalNumberOfIterations() const { return totalNumberOfIterations; }
@@ -67,7 +68,9 @@ public:
 		return double(totalNumberOfDOFRepeats) / numberOfRenderedPixels;
 	}
 	double GetAverageDOFNoise() const { return totalNoise / numberOfRenderedPixels; }
+	double GetScratchMemoryPeakKB() const { return scratchMemoryPeak / 1024.0; }
 	void Reset();
+	void Merge(const cStatistics &source);
 };
 
 #endif /* MANDELBULBER2_SRC_STATISTICS_H_ */
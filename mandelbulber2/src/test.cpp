@@ -38,15 +38,20 @@
 #include "animation_frames.hpp"
 #include "animation_keyframes.hpp"
 #include "cimage.hpp"
+#include "compute_fractal.hpp"
 #include "files.h"
+#include "formula/definition/all_fractal_list.hpp"
+#include "fractparams.hpp"
 #include "headless.h"
 #include "initparameters.hpp"
 #include "interface.hpp"
 #include "keyframes.hpp"
 #include "netrender.hpp"
+#include "nine_fractals.hpp"
 #include "opencl_global.h"
 #include "opencl_hardware.h"
 #include "render_job.hpp"
+#include "render_worker.hpp"
 #include "rendering_configuration.hpp"
 #include "settings.hpp"
 #include "system_directories.hpp"
@@ -606,3 +611,242 @@ void Test::renderImageSave() const
 	delete testParFractal;
 	delete testPar;
 }
+
+void Test::computeFormulasWrapper() const
+{
+	if (IsBenchmarking())
+	{
+		QBENCHMARK_ONCE { computeFormulas(); }
+	}
+	else
+	{
+		computeFormulas();
+	}
+}
+
+void Test::computeFormulas() const
+{
+	// compares the formula specialized iteration loop with the generic one (virtual formula call)
+	// for all registered formulas and benchmarks both of them
+	cParameterContainer *testPar = new cParameterContainer;
+	cFractalContainer *testParFractal = new cFractalContainer;
+
+	testPar->SetContainerName("main");
+	InitParams(testPar);
+	/****************** TEMPORARY CODE FOR MATERIALS *******************/
+
+	InitMaterialParams(1, testPar);
+
+	/*******************************************************************/
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		testParFractal->at(i).SetContainerName(QString("fractal") + QString::number(i));
+		InitFractalParams(&testParFractal->at(i));
+	}
+
+	const int gridSize = IsBenchmarking() ? 10 * difficulty : 8;
+	const int maxN = testPar->Get<int>("N");
+
+	QVector<CVector3> points;
+	for (int ix = 0; ix < gridSize; ix++)
+	{
+		for (int iy = 0; iy < gridSize; iy++)
+		{
+			for (int iz = 0; iz < gridSize; iz++)
+			{
+				points.append(
+					(CVector3(ix, iy, iz) / (gridSize - 1) - CVector3(0.5, 0.5, 0.5)) * 4.0);
+			}
+		}
+	}
+	QVector<sFractalOut> outSpecialized(points.size());
+	QVector<sFractalOut> outGeneric(points.size());
+
+	for (const cAbstractFractal *fractalFormula : newFractalList)
+	{
+		const fractal::enumFractalFormula formula = fractalFormula->getInternalId();
+		if (formula == fractal::none) continue;
+
+		testPar->Set("formula", 1, int(formula));
+
+		sParamRender *params = new sParamRender(testPar);
+		cNineFractals *fractals = new cNineFractals(testParFractal, testPar);
+		cNineFractals *fractalsGeneric = new cNineFractals(testParFractal, testPar);
+		fractalsGeneric->DisableSpecializedCompute();
+
+		// the whole grid is timed as one batch, because single calls are too short to be measured
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < points.size(); i++)
+		{
+			sFractalIn in(points[i], 0, maxN, &params->common, -1, false);
+			Compute<fractal::calcModeNormal>(*fractals, in, &outSpecialized[i]);
+		}
+		const qint64 timeSpecialized = timer.nsecsElapsed();
+
+		timer.start();
+		for (int i = 0; i < points.size(); i++)
+		{
+			sFractalIn in(points[i], 0, maxN, &params->common, -1, false);
+			Compute<fractal::calcModeNormal>(*fractalsGeneric, in, &outGeneric[i]);
+		}
+		const qint64 timeGeneric = timer.nsecsElapsed();
+
+		qint64 iterations = 0;
+		for (int i = 0; i < points.size(); i++)
+		{
+			iterations += outSpecialized[i].iters;
+
+			if (!IsBenchmarking())
+			{
+				// distances are compared bitwise, so NaN results of both loops are equal as well
+				const bool sameDistance =
+					memcmp(&outSpecialized[i].distance, &outGeneric[i].distance, sizeof(double)) == 0;
+				QVERIFY2(outSpecialized[i].iters == outGeneric[i].iters && sameDistance,
+					QString("specialized computation of formula %1 differs from generic one")
+						.arg(fractalFormula->getInternalName())
+						.toStdString()
+						.c_str());
+			}
+		}
+
+		if (IsBenchmarking())
+		{
+			WriteLogCout(QString("formula %1: generic %2 Mit/s, specialized %3 Mit/s\n")
+										 .arg(fractalFormula->getInternalName())
+										 .arg(iterations * 1000.0 / qMax(timeGeneric, qint64(1)))
+										 .arg(iterations * 1000.0 / qMax(timeSpecialized, qint64(1))),
+				1);
+		}
+
+		delete fractalsGeneric;
+		delete fractals;
+		delete params;
+	}
+
+	delete testParFractal;
+	delete testPar;
+}
+
+void Test::slowShadingAdaptiveWrapper() const
+{
+	if (IsBenchmarking())
+	{
+		QBENCHMARK_ONCE { slowShadingAdaptive(); }
+	}
+	else
+	{
+		slowShadingAdaptive();
+	}
+}
+
+void Test::slowShadingAdaptive() const
+{
+	// adaptive non-DE shading refines the lattice 11 x 11 x 11 in levels. Every lattice point has
+	// to be calculated exactly once, so when normal vector doesn't converge, the adaptive mode
+	// doesn't calculate more points than non-adaptive one
+	const int levels = cRenderWorker::slowShadingAdaptiveLevels;
+	const int expectedPoints[] = {8, 27, 235, 1331};
+	int calculatedPoints = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		for (int ix = 0; ix <= 10; ix++)
+		{
+			for (int iy = 0; iy <= 10; iy++)
+			{
+				for (int iz = 0; iz <= 10; iz++)
+				{
+					if (cRenderWorker::IsNewSlowShadingPoint(level, ix, iy, iz)) calculatedPoints++;
+				}
+			}
+		}
+		QVERIFY2(calculatedPoints == expectedPoints[level],
+			QString("wrong number of points calculated up to level %1 of adaptive slow shading")
+				.arg(level)
+				.toStdString()
+				.c_str());
+	}
+
+	for (int ix = 0; ix <= 10; ix++)
+	{
+		for (int iy = 0; iy <= 10; iy++)
+		{
+			for (int iz = 0; iz <= 10; iz++)
+			{
+				int count = 0;
+				for (int level = 0; level < levels; level++)
+				{
+					if (cRenderWorker::IsNewSlowShadingPoint(level, ix, iy, iz)) count++;
+				}
+				QVERIFY2(count == 1, "lattice point of adaptive slow shading calculated more than once");
+			}
+		}
+	}
+
+	// renders the same scene with non-adaptive and adaptive slow shading and compares the time
+	const QString simpleExampleFileName =
+		QDir::toNativeSeparators(systemDirectories.sharedDir + QDir::separator() + "examples"
+														 + QDir::separator() + "mandelbox001.fract");
+
+	cParameterContainer *testPar = new cParameterContainer;
+	cFractalContainer *testParFractal = new cFractalContainer;
+	cAnimationFrames *testAnimFrames = new cAnimationFrames;
+	cKeyframes *testKeyframes = new cKeyframes;
+
+	testPar->SetContainerName("main");
+	InitParams(testPar);
+	/****************** TEMPORARY CODE FOR MATERIALS *******************/
+
+	InitMaterialParams(1, testPar);
+
+	/*******************************************************************/
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		testParFractal->at(i).SetContainerName(QString("fractal") + QString::number(i));
+		InitFractalParams(&testParFractal->at(i));
+	}
+	bool stopRequest = false;
+	cRenderingConfiguration config;
+	config.DisableRefresh();
+	config.DisableProgressiveRender();
+
+	cSettings parSettings(cSettings::formatFullText);
+	parSettings.BeQuiet(true);
+	parSettings.LoadFromFile(simpleExampleFileName);
+	parSettings.Decode(testPar, testParFractal, testAnimFrames, testKeyframes);
+	testPar->Set("image_width", IsBenchmarking() ? 10 * difficulty : 20);
+	testPar->Set("image_height", IsBenchmarking() ? 10 * difficulty : 20);
+	testPar->Set("slow_shading", true);
+
+	qint64 renderTime[2];
+	for (int adaptive = 0; adaptive < 2; adaptive++)
+	{
+		testPar->Set("slow_shading_adaptive", adaptive == 1);
+		cImage *image =
+			new cImage(testPar->Get<int>("image_width"), testPar->Get<int>("image_height"));
+		cRenderJob *renderJob = new cRenderJob(testPar, testParFractal, image, &stopRequest);
+		renderJob->Init(cRenderJob::still, config);
+
+		QElapsedTimer timer;
+		timer.start();
+		bool result = renderJob->Execute();
+		renderTime[adaptive] = timer.elapsed();
+
+		delete renderJob;
+		delete image;
+		if (!IsBenchmarking()) QVERIFY2(result, "slow shading render failed.");
+	}
+
+	if (IsBenchmarking())
+	{
+		WriteLogCout(QString("slow shading: non-adaptive %1 ms, adaptive %2 ms\n")
+									 .arg(renderTime[0])
+									 .arg(renderTime[1]),
+			1);
+	}
+
+	delete testKeyframes;
+	delete testAnimFrames;
+	delete testParFractal;
+	delete testPar;
+}
@@ -69,6 +69,8 @@ private:
 	void testKeyframe() const;
 	void renderSimple() const;
 	void renderImageSave() const;
+	void computeFormulas() const;
+	void slowShadingAdaptive() const;
 
 private slots:
 	static void init();
@@ -79,6 +81,8 @@ private slots:
 	void testKeyframeWrapper() const;
 	void renderSimpleWrapper() const;
 	void testImageSaveWrapper() const;
+	void computeFormulasWrapper() const;
+	void slowShadingAdaptiveWrapper() const;
 };
 
 #endif /* MANDELBULBER2_SRC_TEST_HPP_ */